@@ -0,0 +1,159 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#include <climits>
+
+#include "benchmark/benchmark.h"
+
+#include "chai/ManagedArray.hpp"
+#include "chai/config.hpp"
+
+#include "../src/util/forall.hpp"
+
+/*
+ * Loop whose cost grows with the index, so that a static split leaves the
+ * threads owning the end of the range with most of the work.
+ */
+template <typename POLICY>
+void benchmark_forall_skewed(benchmark::State& state, POLICY policy)
+{
+  const int n = state.range(0);
+  chai::ManagedArray<double> array(n);
+
+  while (state.KeepRunning()) {
+    forall(policy, 0, n, [=](int i) {
+      double value = 0.0;
+      for (int j = 0; j < i / 16; ++j) {
+        value += 1.0 / (j + 1);
+      }
+      array[i] = value;
+    });
+  }
+
+  array.free();
+}
+
+void benchmark_forall_skewed_sequential(benchmark::State& state)
+{
+  benchmark_forall_skewed(state, sequential());
+}
+
+void benchmark_forall_skewed_parallel_host_static(benchmark::State& state)
+{
+  benchmark_forall_skewed(state, parallel_host(chai::SCHEDULE_STATIC));
+}
+
+void benchmark_forall_skewed_parallel_host_guided(benchmark::State& state)
+{
+  benchmark_forall_skewed(state, parallel_host(chai::SCHEDULE_GUIDED));
+}
+
+void benchmark_forall_skewed_work_stealing(benchmark::State& state)
+{
+  benchmark_forall_skewed(state, work_stealing());
+}
+
+BENCHMARK(benchmark_forall_skewed_sequential)->Range(1 << 10, 1 << 16);
+BENCHMARK(benchmark_forall_skewed_parallel_host_static)->Range(1 << 10, 1 << 16);
+BENCHMARK(benchmark_forall_skewed_parallel_host_guided)->Range(1 << 10, 1 << 16);
+BENCHMARK(benchmark_forall_skewed_work_stealing)->Range(1 << 10, 1 << 16);
+
+/*
+ * Streaming update through captured arrays, one index at a time against a
+ * batch of lanes at a time.
+ */
+void benchmark_forall_axpy_sequential(benchmark::State& state)
+{
+  const int n = state.range(0);
+  chai::ManagedArray<float> x(n);
+  chai::ManagedArray<float> y(n);
+
+  while (state.KeepRunning()) {
+    forall(sequential(), 0, n, [=](int i) {
+      y[i] = 2.0f * x[i] + y[i];
+    });
+  }
+
+  x.free();
+  y.free();
+}
+
+void benchmark_forall_axpy_simd(benchmark::State& state)
+{
+  const int n = state.range(0);
+  chai::ManagedArray<float> x(n);
+  chai::ManagedArray<float> y(n);
+
+  while (state.KeepRunning()) {
+    forall(simd(), 0, n, [=](chai::SimdIndex i) {
+      y.store(i, 2.0f * x.load(i) + y.load(i));
+    });
+  }
+
+  x.free();
+  y.free();
+}
+
+BENCHMARK(benchmark_forall_axpy_sequential)->Range(1 << 10, 1 << 20);
+BENCHMARK(benchmark_forall_axpy_simd)->Range(1 << 10, 1 << 20);
+
+#if defined(CHAI_ENABLE_GPU_SIMULATION_MODE)
+/*
+ * Copy the input to the simulated device over a link with a latency of 10 us
+ * and a bandwidth of 4 GB/s, then run a kernel that costs about as much as
+ * the copy. Each chunk of a pipelined copy pays the latency.
+ */
+template <typename POLICY>
+void benchmark_forall_transfer(benchmark::State& state, POLICY policy)
+{
+  const int n = state.range(0);
+  chai::ManagedArray<double> input(n);
+  chai::ManagedArray<double> output(n);
+
+  chai::CopyModel model;
+  model.latency = 10.0e-6;
+  model.bandwidth = 4.0e9;
+  chai::SimulatedDevice::getInstance()->setCopyModel(model);
+
+  while (state.KeepRunning()) {
+    state.PauseTiming();
+    // Touch the input on the host so that every iteration moves it again
+    forall(sequential(), 0, n, [=](int i) { input[i] = i; });
+    state.ResumeTiming();
+
+    forall(policy, 0, n, [=](int i) {
+      double value = input[i];
+      for (int j = 0; j < 32; ++j) {
+        value = value * 0.5 + 1.0;
+      }
+      output[i] = value;
+    });
+  }
+
+  chai::SimulatedDevice::getInstance()->setCopyModel(chai::CopyModel());
+
+  input.free();
+  output.free();
+}
+
+void benchmark_forall_transfer_gpu(benchmark::State& state)
+{
+  benchmark_forall_transfer(state, gpu());
+}
+
+void benchmark_forall_transfer_gpu_pipelined(benchmark::State& state)
+{
+  benchmark_forall_transfer(state, gpu_pipelined(state.range(1)));
+}
+
+BENCHMARK(benchmark_forall_transfer_gpu)->Args({1 << 22, 1});
+BENCHMARK(benchmark_forall_transfer_gpu_pipelined)
+    ->Args({1 << 22, 2})
+    ->Args({1 << 22, 4})
+    ->Args({1 << 22, 16});
+#endif
+
+BENCHMARK_MAIN();
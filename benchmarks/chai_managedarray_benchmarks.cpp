@@ -8,6 +8,7 @@
 
 #include "benchmark/benchmark.h"
 
+#include "chai/ArrayManager.hpp"
 #include "chai/ManagedArray.hpp"
 #include "chai/config.hpp"
 
@@ -33,8 +34,65 @@ void benchmark_managedarray_alloc_cpu(benchmark::State& state)
   state.SetItemsProcessed(state.iterations() * state.range(0));
 }
 
+/*
+ * Capture an array that is already resident, as a kernel does when it is
+ * launched. Nothing is moved, so this times the bookkeeping of the capture
+ * path, and the Debug logging sites on it unless CHAI_LOG_LEVEL removes them.
+ */
+void benchmark_managedarray_capture(benchmark::State& state)
+{
+  chai::ArrayManager* manager = chai::ArrayManager::getInstance();
+  chai::ManagedArray<char> array(state.range(0), chai::CPU);
+
+  manager->setExecutionSpace(chai::CPU);
+
+  while (state.KeepRunning()) {
+    chai::ManagedArray<char> captured(array);
+    benchmark::DoNotOptimize(captured);
+  }
+
+  manager->setExecutionSpace(chai::NONE);
+
+  array.free();
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+/*
+ * Launch a kernel that captures the same arrays as its last launch, so every
+ * capture is completed from the capture cache. With every instrument off,
+ * this times the fast path of a capture.
+ */
+void benchmark_managedarray_capture_cached(benchmark::State& state)
+{
+  static const char site = 0;
+
+  chai::ArrayManager* manager = chai::ArrayManager::getInstance();
+  manager->enableCaptureCache();
+  chai::ManagedArray<char> array(1024, chai::CPU);
+
+  while (state.KeepRunning()) {
+    manager->setCaptureSite(&site);
+    manager->setExecutionSpace(chai::CPU);
+
+    for (int i = 0; i < state.range(0); ++i) {
+      chai::ManagedArray<char> captured(array);
+      benchmark::DoNotOptimize(captured);
+    }
+
+    manager->setExecutionSpace(chai::NONE);
+  }
+
+  array.free();
+  manager->disableCaptureCache();
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
 BENCHMARK(benchmark_managedarray_alloc_default)->Range(1, INT_MAX);
 BENCHMARK(benchmark_managedarray_alloc_cpu)->Range(1, INT_MAX);
+BENCHMARK(benchmark_managedarray_capture)->Arg(1024);
+BENCHMARK(benchmark_managedarray_capture_cached)->Arg(1)->Arg(16);
 
 #if defined(CHAI_ENABLE_CUDA) || defined(CHAI_ENABLE_HIP)
 void benchmark_managedarray_alloc_gpu(benchmark::State& state)
@@ -0,0 +1,395 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#include "chai/AllocationProfiler.hpp"
+
+#include "chai/Instrumentation.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#if defined(__GLIBC__) || defined(__APPLE__)
+#define CHAI_HAVE_BACKTRACE
+#include <cxxabi.h>
+#include <execinfo.h>
+#endif
+
+namespace chai
+{
+
+namespace {
+
+/*!
+ * Frames of the profiler itself, left out of every backtrace.
+ */
+const int s_skipped_frames = 2;
+
+const char* spaceName(int space)
+{
+  switch (space) {
+    case CPU:
+      return "CPU";
+    case GPU:
+      return "GPU";
+    case UM:
+      return "UM";
+    case PINNED:
+      return "PINNED";
+    default:
+      return "NONE";
+  }
+}
+
+std::vector<void*> backtraceStack()
+{
+  std::vector<void*> stack;
+
+#if defined(CHAI_HAVE_BACKTRACE)
+  void* frames[AllocationProfiler::s_max_frames + s_skipped_frames];
+  const int depth =
+      backtrace(frames, AllocationProfiler::s_max_frames + s_skipped_frames);
+
+  if (depth > s_skipped_frames) {
+    stack.assign(frames + s_skipped_frames, frames + depth);
+  }
+#endif
+
+  return stack;
+}
+
+#if defined(CHAI_HAVE_BACKTRACE)
+/*!
+ * Demangle the symbol of a line of backtrace_symbols, which glibc prints as
+ * "object(symbol+offset) [address]".
+ */
+std::string demangle(const char* line)
+{
+  std::string text(line);
+
+  const size_t open = text.find('(');
+  const size_t plus = text.find('+', open);
+
+  if (open == std::string::npos || plus == std::string::npos ||
+      plus == open + 1) {
+    return text;
+  }
+
+  const std::string mangled = text.substr(open + 1, plus - open - 1);
+
+  int status = 0;
+  char* name = abi::__cxa_demangle(mangled.c_str(), nullptr, nullptr, &status);
+
+  if (status != 0 || !name) {
+    return text;
+  }
+
+  const std::string result = text.substr(0, open + 1) + name + text.substr(plus);
+  std::free(name);
+  return result;
+}
+#endif
+
+}  // end of anonymous namespace
+
+constexpr int AllocationProfiler::s_max_frames;
+
+AllocationProfiler* AllocationProfiler::getInstance()
+{
+  static AllocationProfiler s_allocation_profiler_instance;
+  return &s_allocation_profiler_instance;
+}
+
+AllocationProfiler::AllocationProfiler() :
+  m_enabled{false},
+  m_output{},
+  m_rate{16},
+  m_always_sampled_size{size_t(1) << 20},
+  m_countdown{0},
+  m_num_live{0},
+  m_sites{},
+  m_live{}
+{
+  // Sites point to regions, so the regions must outlive the
+  // AllocationProfiler.
+  RegionStatistics::getInstance();
+
+  for (int space = 0; space < NUM_EXECUTION_SPACES; ++space) {
+    m_live_bytes[space] = 0;
+    m_peak_bytes[space] = 0;
+    m_recorded_peak[space] = 0;
+  }
+
+  const char* rate = std::getenv("CHAI_ALLOCATION_SAMPLE_RATE");
+  if (rate && *rate) {
+    m_rate = std::max(1l, std::atol(rate));
+  }
+
+  const char* env = std::getenv("CHAI_ALLOCATION_PROFILE");
+  if (env && *env) {
+    m_output = env;
+    setEnabled(true);
+  }
+}
+
+AllocationProfiler::~AllocationProfiler()
+{
+  if (m_output.empty()) {
+    return;
+  }
+
+  if (m_output == "1") {
+    report(std::cerr);
+  } else {
+    std::ofstream file(m_output);
+    report(file);
+  }
+}
+
+void AllocationProfiler::setEnabled(bool enabled)
+{
+  m_enabled = enabled;
+  Instrumentation::setEnabled(INSTRUMENT_ALLOCATION_PROFILER, enabled);
+}
+
+void AllocationProfiler::setSampling(size_t rate, size_t always_sampled_size)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_rate = std::max(rate, size_t(1));
+  m_always_sampled_size = always_sampled_size;
+}
+
+void AllocationProfiler::sample(void* pointer,
+                                ExecutionSpace space,
+                                size_t size)
+{
+  size_t bytes = size;
+
+  if (size < m_always_sampled_size) {
+    if (m_countdown.fetch_add(1, std::memory_order_relaxed) % m_rate != 0) {
+      return;
+    }
+
+    // The sample stands for the allocations that were not sampled
+    bytes = size * m_rate;
+  }
+
+  SiteKey key(RegionStatistics::current(), backtraceStack());
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  Site& site = m_sites[key];
+  if (!site.region) {
+    site.region = key.first;
+    site.stack = std::move(key.second);
+  }
+
+  ++site.allocations;
+  site.live_bytes[space] += bytes;
+  site.peak_bytes[space] = std::max(site.peak_bytes[space],
+                                    site.live_bytes[space]);
+
+  Sample& sampled = m_live[pointer];
+  if (sampled.site) {
+    // An allocation that was freed without being reported
+    sampled.site->live_bytes[sampled.space] -= sampled.bytes;
+    m_live_bytes[sampled.space] -= sampled.bytes;
+  } else {
+    m_num_live.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  sampled.site = &site;
+  sampled.space = space;
+  sampled.bytes = bytes;
+
+  m_live_bytes[space] += bytes;
+  updatePeak(space);
+}
+
+void AllocationProfiler::release(void* pointer)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  auto found = m_live.find(pointer);
+  if (found == m_live.end()) {
+    return;
+  }
+
+  Sample const& sampled = found->second;
+  sampled.site->live_bytes[sampled.space] -= sampled.bytes;
+  m_live_bytes[sampled.space] -= sampled.bytes;
+
+  m_live.erase(found);
+  m_num_live.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void AllocationProfiler::updatePeak(ExecutionSpace space)
+{
+  if (m_live_bytes[space] <= m_peak_bytes[space]) {
+    return;
+  }
+
+  m_peak_bytes[space] = m_live_bytes[space];
+
+  // Recording every site at every new peak would be quadratic while memory
+  // grows, so the sites are recorded each time the peak grows by 1/64.
+  if (m_peak_bytes[space] <= m_recorded_peak[space] + m_recorded_peak[space] / 64 &&
+      m_recorded_peak[space] != 0) {
+    return;
+  }
+
+  m_recorded_peak[space] = m_peak_bytes[space];
+
+  for (auto& entry : m_sites) {
+    entry.second.bytes_at_peak[space] = entry.second.live_bytes[space];
+  }
+}
+
+std::vector<AllocationProfiler::Site> AllocationProfiler::getSites(
+    ExecutionSpace space,
+    size_t max_sites) const
+{
+  std::vector<Site> sites;
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto const& entry : m_sites) {
+      Site const& site = entry.second;
+      if (site.live_bytes[space] || site.peak_bytes[space]) {
+        sites.push_back(site);
+      }
+    }
+  }
+
+  std::sort(sites.begin(), sites.end(), [=] (Site const& a, Site const& b) {
+    if (a.live_bytes[space] != b.live_bytes[space]) {
+      return a.live_bytes[space] > b.live_bytes[space];
+    }
+    return a.bytes_at_peak[space] > b.bytes_at_peak[space];
+  });
+
+  if (max_sites > 0 && sites.size() > max_sites) {
+    sites.resize(max_sites);
+  }
+
+  return sites;
+}
+
+size_t AllocationProfiler::getLiveBytes(ExecutionSpace space) const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_live_bytes[space];
+}
+
+size_t AllocationProfiler::getPeakBytes(ExecutionSpace space) const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_peak_bytes[space];
+}
+
+std::vector<std::string> AllocationProfiler::symbolize(
+    std::vector<void*> const& stack)
+{
+  std::vector<std::string> frames;
+
+#if defined(CHAI_HAVE_BACKTRACE)
+  if (!stack.empty()) {
+    char** symbols =
+        backtrace_symbols(stack.data(), static_cast<int>(stack.size()));
+
+    if (symbols) {
+      for (size_t i = 0; i < stack.size(); ++i) {
+        frames.push_back(demangle(symbols[i]));
+      }
+      std::free(symbols);
+      return frames;
+    }
+  }
+#endif
+
+  for (void* frame : stack) {
+    std::ostringstream address;
+    address << frame;
+    frames.push_back(address.str());
+  }
+
+  return frames;
+}
+
+void AllocationProfiler::report(std::ostream& stream, size_t max_sites) const
+{
+  size_t rate = 0;
+  size_t always_sampled_size = 0;
+  size_t live[NUM_EXECUTION_SPACES] = {};
+  size_t peak[NUM_EXECUTION_SPACES] = {};
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    rate = m_rate;
+    always_sampled_size = m_always_sampled_size;
+    for (int space = CPU; space < NUM_EXECUTION_SPACES; ++space) {
+      live[space] = m_live_bytes[space];
+      peak[space] = m_peak_bytes[space];
+    }
+  }
+
+  stream << "Memory held by allocation site, sampling 1 in " << rate
+         << " allocations and every allocation of " << always_sampled_size
+         << " bytes or more\n";
+
+  for (int space = CPU; space < NUM_EXECUTION_SPACES; ++space) {
+    if (!peak[space]) {
+      continue;
+    }
+
+    stream << "\n" << spaceName(space) << ": " << live[space]
+           << " bytes held, at most " << peak[space] << "\n";
+
+    const std::vector<Site> sites = getSites(ExecutionSpace(space), max_sites);
+
+    for (size_t i = 0; i < sites.size(); ++i) {
+      Site const& site = sites[i];
+
+      stream << "\n  #" << (i + 1) << " " << site.live_bytes[space]
+             << " bytes held, " << site.bytes_at_peak[space]
+             << " at the peak (" << std::fixed << std::setprecision(1)
+             << 100.0 * site.bytes_at_peak[space] / peak[space] << "%), "
+             << site.peak_bytes[space] << " at most, "
+             << site.allocations << " sampled allocations";
+
+      if (site.region->getParent()) {
+        stream << ", in region " << site.region->getPath();
+      }
+
+      stream << "\n";
+
+      for (std::string const& frame : symbolize(site.stack)) {
+        stream << "      " << frame << "\n";
+      }
+    }
+  }
+}
+
+void AllocationProfiler::clear()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  m_live.clear();
+  m_sites.clear();
+  m_num_live = 0;
+  m_countdown = 0;
+
+  for (int space = 0; space < NUM_EXECUTION_SPACES; ++space) {
+    m_live_bytes[space] = 0;
+    m_peak_bytes[space] = 0;
+    m_recorded_peak[space] = 0;
+  }
+}
+
+}  // end of namespace chai
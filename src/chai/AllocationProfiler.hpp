@@ -0,0 +1,249 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#ifndef CHAI_AllocationProfiler_HPP
+#define CHAI_AllocationProfiler_HPP
+
+#include "chai/config.hpp"
+#include "chai/ExecutionSpaces.hpp"
+#include "chai/RegionStatistics.hpp"
+#include "chai/Types.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace chai
+{
+
+/*!
+ * \brief Singleton finding the call sites that hold memory.
+ *
+ * While profiling is on, one in every getSampleRate allocations made by the
+ * ArrayManager is sampled, along with every allocation of at least
+ * getAlwaysSampledSize bytes. The backtrace of a sampled allocation is its
+ * call site, and the bytes it holds are counted against the site until it is
+ * freed, scaled by the sample rate to estimate the bytes of the allocations
+ * that were not sampled. For every space, each site keeps the bytes it
+ * holds, the most it ever held, and what it held when the whole program held
+ * the most, so that the sites behind the peak can be found after the fact.
+ *
+ * A site is a backtrace in a region, so that the same code allocating in
+ * several regions has a site for each. Backtraces are taken with the
+ * backtrace function of the C library where it exists, and symbolized only
+ * when reported. Elsewhere, the allocations of a region share one site.
+ *
+ * Profiling is off by default. Setting the CHAI_ALLOCATION_PROFILE
+ * environment variable turns it on, and prints the report at shutdown: to
+ * standard error if the variable is 1, and to the file it names otherwise.
+ * CHAI_ALLOCATION_SAMPLE_RATE sets the sample rate.
+ */
+class AllocationProfiler
+{
+public:
+  /*!
+   * Number of frames kept for every backtrace.
+   */
+  static constexpr int s_max_frames = 24;
+
+  /*!
+   * \brief Memory held by one call site.
+   */
+  struct Site {
+    /*!
+     * Return addresses of the backtrace, innermost first.
+     */
+    std::vector<void*> stack;
+
+    /*!
+     * Region of the thread that made the allocations.
+     */
+    Region const* region = nullptr;
+
+    size_t live_bytes[NUM_EXECUTION_SPACES] = {};
+    size_t peak_bytes[NUM_EXECUTION_SPACES] = {};
+
+    /*!
+     * Bytes held when the whole program held the most in each space, within
+     * a sixty-fourth of the peak.
+     */
+    size_t bytes_at_peak[NUM_EXECUTION_SPACES] = {};
+
+    size_t allocations = 0;
+  };
+
+  /*!
+   * \brief Get the singleton instance.
+   *
+   * \return Pointer to the AllocationProfiler instance.
+   */
+  CHAISHAREDDLL_API static AllocationProfiler* getInstance();
+
+  /*!
+   * \brief Print the report if CHAI_ALLOCATION_PROFILE is set.
+   */
+  ~AllocationProfiler();
+
+  /*!
+   * \brief Turn sampling on or off.
+   *
+   * Frees of the allocations already sampled are tracked either way.
+   */
+  CHAISHAREDDLL_API void setEnabled(bool enabled);
+
+  /*!
+   * \brief Whether sampling is on.
+   */
+  bool isEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+  /*!
+   * \brief Set which allocations are sampled.
+   *
+   * \param rate Sample one in every rate allocations. Defaults to 16.
+   * \param always_sampled_size Sample every allocation of at least this many
+   *        bytes. Defaults to 1 MiB.
+   */
+  CHAISHAREDDLL_API void setSampling(size_t rate, size_t always_sampled_size);
+
+  size_t getSampleRate() const { return m_rate; }
+
+  size_t getAlwaysSampledSize() const { return m_always_sampled_size; }
+
+  /*!
+   * \brief Record an allocation of size bytes at pointer in space.
+   */
+  void recordAllocation(void* pointer, ExecutionSpace space, size_t size)
+  {
+    if (isEnabled()) {
+      sample(pointer, space, size);
+    }
+  }
+
+  /*!
+   * \brief Record that the allocation at pointer was freed.
+   */
+  void recordFree(void* pointer)
+  {
+    if (m_num_live.load(std::memory_order_relaxed) > 0) {
+      release(pointer);
+    }
+  }
+
+  /*!
+   * \brief Get the sites holding memory in space, by decreasing bytes held.
+   *
+   * \param space The space to rank the sites by.
+   * \param max_sites The number of sites to return, or 0 for all of them.
+   */
+  CHAISHAREDDLL_API std::vector<Site> getSites(ExecutionSpace space,
+                                               size_t max_sites = 0) const;
+
+  /*!
+   * \brief Get the estimated bytes held, and the most held, in space.
+   */
+  CHAISHAREDDLL_API size_t getLiveBytes(ExecutionSpace space) const;
+
+  CHAISHAREDDLL_API size_t getPeakBytes(ExecutionSpace space) const;
+
+  /*!
+   * \brief Get the frames of a backtrace as text, demangled where possible.
+   */
+  CHAISHAREDDLL_API static std::vector<std::string> symbolize(
+      std::vector<void*> const& stack);
+
+  /*!
+   * \brief Print, for every space, the sites holding the most memory.
+   *
+   * \param max_sites The number of sites to print for each space.
+   */
+  CHAISHAREDDLL_API void report(std::ostream& stream,
+                                size_t max_sites = 10) const;
+
+  /*!
+   * \brief Forget all sites and sampled allocations.
+   */
+  CHAISHAREDDLL_API void clear();
+
+protected:
+  /*!
+   * \brief Construct a new AllocationProfiler.
+   *
+   * The constructor is a protected member, ensuring that it can
+   * only be called by the singleton getInstance method.
+   */
+  AllocationProfiler();
+
+private:
+  /*!
+   * \brief A sampled allocation that was not freed yet.
+   */
+  struct Sample {
+    Site* site;
+    ExecutionSpace space;
+
+    /*!
+     * Estimated bytes of the allocations the sample stands for.
+     */
+    size_t bytes;
+  };
+
+  CHAISHAREDDLL_API void sample(void* pointer,
+                                ExecutionSpace space,
+                                size_t size);
+
+  CHAISHAREDDLL_API void release(void* pointer);
+
+  /*!
+   * \brief Record the bytes each site holds if space is at a new peak.
+   */
+  void updatePeak(ExecutionSpace space);
+
+  std::atomic<bool> m_enabled;
+
+  /*!
+   * Value of CHAI_ALLOCATION_PROFILE, if set.
+   */
+  std::string m_output;
+
+  size_t m_rate;
+
+  size_t m_always_sampled_size;
+
+  /*!
+   * Allocations counted towards the sample rate.
+   */
+  std::atomic<size_t> m_countdown;
+
+  std::atomic<size_t> m_num_live;
+
+  mutable std::mutex m_mutex;
+
+  using SiteKey = std::pair<Region const*, std::vector<void*>>;
+
+  std::map<SiteKey, Site> m_sites;
+
+  std::unordered_map<void*, Sample> m_live;
+
+  size_t m_live_bytes[NUM_EXECUTION_SPACES];
+
+  size_t m_peak_bytes[NUM_EXECUTION_SPACES];
+
+  /*!
+   * Peak at which the bytes of every site were last recorded.
+   */
+  size_t m_recorded_peak[NUM_EXECUTION_SPACES];
+};
+
+}  // end of namespace chai
+
+#endif  // CHAI_AllocationProfiler_HPP
@@ -7,6 +7,8 @@
 #include "chai/ArrayManager.hpp"
 
 #include "chai/config.hpp"
+#include "chai/KernelStatistics.hpp"
+#include "chai/ThreadPool.hpp"
 
 #if defined(CHAI_ENABLE_CUDA)
 #include "cuda_runtime_api.h"
@@ -14,9 +16,132 @@
 
 #include "umpire/ResourceManager.hpp"
 
+#include <algorithm>
+#include <cstring>
+
 namespace chai
 {
 
+namespace {
+
+/*!
+ * Copies at least this large between host accessible spaces are split
+ * across the ThreadPool.
+ */
+const size_t s_parallel_copy_size = 1 << 22;
+
+/*!
+ * Size of the blocks a parallel copy is split into.
+ */
+const size_t s_parallel_copy_block = 1 << 20;
+
+/*!
+ * Launch sites cached in each execution space before the cache starts over.
+ */
+const size_t s_max_capture_sites = 4096;
+
+/*!
+ * True on the threads that run kernel bodies.
+ */
+thread_local bool s_kernel_thread = false;
+
+/*!
+ * \brief Whether memory in the given space can be read and written by a
+ *        plain memcpy on the host.
+ */
+bool isHostAccessible(ExecutionSpace space)
+{
+  if (space == CPU || space == PINNED) {
+    return true;
+  }
+
+#if defined(CHAI_ENABLE_GPU_SIMULATION_MODE)
+  if (space == GPU) {
+    return true;
+  }
+#endif
+
+  return false;
+}
+
+/*!
+ * \brief Whether kernels in the given space can run on a resource of the
+ *        given platform.
+ */
+bool runsOn(camp::resources::Platform platform, ExecutionSpace space)
+{
+  switch (platform) {
+    case camp::resources::Platform::host:
+#if defined(CHAI_ENABLE_GPU_SIMULATION_MODE)
+      return space == CPU || space == GPU;
+#else
+      return space == CPU;
+#endif
+    case camp::resources::Platform::cuda:
+    case camp::resources::Platform::hip:
+      return space == GPU;
+    default:
+      return false;
+  }
+}
+
+#if defined(CHAI_ENABLE_GPU_SIMULATION_MODE)
+/*!
+ * \brief Whether a transfer must go through the copy model of the simulated
+ *        device.
+ *
+ * Copies to and from the GPU space only use it when copies have a cost,
+ * since otherwise splitting them across the ThreadPool is faster.
+ */
+template <typename TRANSFER>
+bool usesCopyEngine(TRANSFER const& transfer)
+{
+  return (transfer.src_space == GPU || transfer.dst_space == GPU) &&
+         SimulatedDevice::getInstance()->isCopyModeled();
+}
+
+template <typename TRANSFER>
+SimulatedDevice::CopyDirection copyDirection(TRANSFER const& transfer)
+{
+  return transfer.dst_space == GPU ? SimulatedDevice::COPY_TO_DEVICE
+                                   : SimulatedDevice::COPY_FROM_DEVICE;
+}
+#endif
+
+#if defined(CHAI_ENABLE_CUDA)
+/*!
+ * \brief Stream used for the slices of deferred transfers.
+ *
+ * It does not synchronize with the default stream, so slices can be copied
+ * while a kernel runs there.
+ */
+cudaStream_t sliceStream()
+{
+  static cudaStream_t stream = [] {
+    cudaStream_t created;
+    CHAI_GPU_ERROR_CHECK(cudaStreamCreateWithFlags(&created,
+                                                   cudaStreamNonBlocking));
+    return created;
+  }();
+
+  return stream;
+}
+#elif defined(CHAI_ENABLE_HIP)
+hipStream_t sliceStream()
+{
+  static hipStream_t stream = [] {
+    hipStream_t created;
+    CHAI_GPU_ERROR_CHECK(hipStreamCreateWithFlags(&created,
+                                                  hipStreamNonBlocking));
+    return created;
+  }();
+
+  return stream;
+}
+#endif
+
+}
+
 PointerRecord ArrayManager::s_null_record = PointerRecord();
 
 ArrayManager* ArrayManager::getInstance()
@@ -29,7 +154,16 @@ ArrayManager::ArrayManager() :
   m_pointer_map{},
   m_allocators{},
   m_resource_manager{umpire::ResourceManager::getInstance()},
-  m_callbacks_active{true}
+  m_callbacks_active{true},
+  m_kernel_statistics{KernelStatistics::getInstance()},
+  m_array_statistics{ArrayStatistics::getInstance()},
+  m_tag_statistics{TagStatistics::getInstance()},
+  m_tracer{Tracer::getInstance()},
+  m_operation_recorder{OperationRecorder::getInstance()},
+  m_transfer_checker{TransferChecker::getInstance()},
+  m_allocation_profiler{AllocationProfiler::getInstance()},
+  m_region_statistics{RegionStatistics::getInstance()},
+  m_metrics{}
 {
   m_pointer_map.clear();
   m_current_execution_space = NONE;
@@ -88,6 +222,7 @@ void ArrayManager::registerPointer(
                       pointer << " already there.  Deleting abandoned pointer record.");
 
            callback(foundRecord, ACTION_FOUND_ABANDONED, space);
+           forgetRecord(foundRecord);
 
            for (int fspace = CPU; fspace < NUM_EXECUTION_SPACES; ++fspace) {
               foundRecord->m_pointers[fspace] = nullptr;
@@ -106,6 +241,7 @@ void ArrayManager::registerPointer(
     if (!record->m_pointers[i]) record->m_owned[i] = true;
   }
   record->m_owned[space] = owned;
+  updateGeneration(record);
 
   if (pointer) {
      // if umpire already knows about this pointer, we want to make sure its records and ours
@@ -140,6 +276,7 @@ void ArrayManager::deregisterPointer(PointerRecord* record, bool deregisterFromU
     }
   }
   if (record != &s_null_record) {
+     forgetRecord(record);
      delete record;
   }
 }
@@ -159,12 +296,83 @@ void * ArrayManager::frontOfAllocation(void * pointer) {
 void ArrayManager::setExecutionSpace(ExecutionSpace space)
 {
   CHAI_LOG(Debug, "Setting execution space to " << space);
+  m_operation_recorder->record(OPERATION_SET_SPACE, space);
 
-  if (chai::GPU == space) {
+  // A GPU kernel counts as launched once its execution space is left.
+  // Kernels with an event are waited for array by array instead.
+  if (m_current_execution_space == GPU && !m_kernel_has_event) {
     m_synced_since_last_kernel = false;
   }
 
+  if (m_current_execution_space != NONE) {
+    endCaptureSite();
+    m_next_capture_site = nullptr;
+  }
+
+  if (chai::GPU == space) {
+    m_kernel_has_event = false;
+  }
+
+  // Kernels on a resource get their event from recordLaunchEvent. A kernel
+  // in a space the resource does not run in is launched as if there were
+  // no resource.
+  m_resource_launch = m_has_resource && space != NONE &&
+                      runsOn(m_resource.get_platform(), space);
+
+  if (m_has_resource && space != NONE && !m_resource_launch) {
+    CHAI_LOG(Debug, "Resource does not run kernels in space " << space);
+  }
+
+  if (m_resource_launch) {
+    m_resource_space = space;
+    m_resource_captures.clear();
+    m_kernel_has_event = true;
+  }
+
+  const ExecutionSpace previous_space = m_current_execution_space;
   m_current_execution_space = space;
+
+  if (space == NONE) {
+    if (previous_space != NONE) {
+      m_kernel_statistics->endKernel();
+    }
+    if (m_metrics.isEnabled()) {
+      m_metrics.endKernel();
+    }
+  } else {
+    m_kernel_statistics->beginKernel(space);
+    m_array_statistics->beginKernel();
+    if (m_metrics.isEnabled()) {
+      m_metrics.beginKernel(space);
+    }
+  }
+
+  if (previous_space != NONE) {
+    m_tracer->recordSpan(Tracer::TRACE_LAUNCH, previous_space, NONE, 0,
+                         m_launch_start);
+  }
+
+  if (space != NONE && m_tracer->isEnabled()) {
+    m_launch_start = m_tracer->now();
+  }
+
+  if (space != NONE) {
+    if (m_capture_plan) {
+      MovePlan::Kernel kernel;
+      kernel.space = space;
+      m_capture_plan->m_kernels.push_back(kernel);
+    }
+
+    if (m_replay_plan) {
+      replayKernel(space);
+    }
+
+    // Plans and deferred transfers need to see every capture
+    m_capture_site_pending = m_capture_cache_active &&
+                             space < NUM_EXECUTION_SPACES &&
+                             !m_capture_plan && !m_replay_plan &&
+                             !m_defer_transfers;
+  }
 }
 
 void* ArrayManager::move(void* pointer,
@@ -187,7 +395,12 @@ void* ArrayManager::move(void* pointer,
 
 ExecutionSpace ArrayManager::getExecutionSpace()
 {
-  return m_current_execution_space;
+  return s_kernel_thread ? NONE : m_current_execution_space;
+}
+
+void ArrayManager::setKernelThread(bool kernel_thread)
+{
+  s_kernel_thread = kernel_thread;
 }
 
 void ArrayManager::registerTouch(PointerRecord* pointer_record)
@@ -202,8 +415,21 @@ void ArrayManager::registerTouch(PointerRecord* pointer_record,
 
      if (space != NONE) {
        CHAI_LOG(Debug, pointer_record->m_pointers[space] << " touched in space " << space);
+       m_operation_recorder->record(OPERATION_TOUCH, pointer_record, space);
+       m_transfer_checker->recordTouch(pointer_record, m_current_execution_space);
+       if (!pointer_record->m_touched[space] ||
+           pointer_record->m_last_space != space) {
+         updateGeneration(pointer_record);
+       }
+
        pointer_record->m_touched[space] = true;
        pointer_record->m_last_space = space;
+
+       // A touch right after a capture means the capture may write
+       if (m_recorded_accesses && !m_recorded_accesses->empty() &&
+           m_recorded_accesses->back().record == pointer_record) {
+         m_recorded_accesses->back().write = true;
+       }
      }
   }
 }
@@ -215,6 +441,59 @@ void ArrayManager::resetTouch(PointerRecord* pointer_record)
     for (int space = CPU; space < NUM_EXECUTION_SPACES; ++space) {
       pointer_record->m_touched[space] = false;
     }
+
+    updateGeneration(pointer_record);
+  }
+}
+
+void ArrayManager::move(PointerRecord* const* records,
+                        size_t count,
+                        ExecutionSpace space,
+                        bool touch)
+{
+  if (space == NONE) {
+    return;
+  }
+
+  // Slices of one array share its record, which must be captured once
+  std::vector<PointerRecord*> unique(records, records + count);
+  std::sort(unique.begin(), unique.end());
+  unique.erase(std::unique(unique.begin(), unique.end()), unique.end());
+  unique.erase(std::remove(unique.begin(), unique.end(), &s_null_record),
+               unique.end());
+
+  std::vector<Transfer> transfers;
+  transfers.reserve(unique.size());
+
+  for (PointerRecord* record : unique) {
+    if (captureCached(record, space, touch)) {
+      continue;
+    }
+
+    Transfer transfer;
+    if (captureRecord(record, space, transfer)) {
+      transfers.push_back(transfer);
+    }
+  }
+
+  issueTransfers(transfers.data(), transfers.size());
+
+  if (!touch) {
+    return;
+  }
+
+  for (PointerRecord* record : unique) {
+#if defined(CHAI_ENABLE_UM)
+    if (record->m_last_space == UM) {
+      continue;
+    }
+#endif
+#if defined(CHAI_ENABLE_PINNED)
+    if (record->m_last_space == PINNED) {
+      continue;
+    }
+#endif
+    registerTouch(record, space);
   }
 }
 
@@ -224,15 +503,148 @@ void ArrayManager::move(PointerRecord* record, ExecutionSpace space)
     return;
   }
 
+  Transfer transfer;
+  if (captureRecord(record, space, transfer)) {
+    issueTransfers(&transfer, 1);
+  }
+}
+
+bool ArrayManager::captureRecord(PointerRecord* record,
+                                 ExecutionSpace space,
+                                 Transfer& transfer)
+{
+  if (m_capture_site_pending) {
+    findCaptureSite(record);
+  }
+
+  if (m_capture_site && space == m_current_execution_space &&
+      record != &s_null_record) {
+    if (m_capture_site_matched) {
+      // The kernel no longer makes the captures of its last launch
+      m_capture_site_matched = false;
+      m_capture_site->resize(m_capture_index);
+    }
+
+    CachedCapture cached;
+    cached.record = record;
+    cached.generation = 0;
+    m_capture_site->push_back(cached);
+    ++m_capture_index;
+  }
+
+  if (m_resource_launch && space == m_current_execution_space &&
+      record != &s_null_record) {
+    m_resource_captures.push_back(record);
+  }
+
+  waitForEvent(record, space);
+
   callback(record, ACTION_CAPTURED, space);
 
-  if (space == record->m_last_space) {
+  if (Instrumentation::isEnabled()) {
+    instrumentCapture(record, space, 0);
+  }
+
+  if (m_replay_plan) {
+    replayCapture(record, space);
+  }
+
+  if (m_recorded_accesses && record != &s_null_record) {
+    Access access;
+    access.record = record;
+    access.write = false;
+#if defined(CHAI_ENABLE_UM)
+    access.write = access.write || record->m_last_space == UM;
+#endif
+#if defined(CHAI_ENABLE_PINNED)
+    access.write = access.write || record->m_last_space == PINNED;
+#endif
+    m_recorded_accesses->push_back(access);
+  }
+
+  const ExecutionSpace source = record->m_last_space;
+  const bool moved = prepareMove(record, space, transfer);
+
+  if (m_capture_plan && !m_capture_plan->m_kernels.empty() &&
+      record != &s_null_record) {
+    MovePlan::Capture capture;
+    capture.move.record = record;
+    capture.move.space = space;
+    capture.move.key = nullptr;
+    capture.move.size = record->m_size;
+    capture.source = source;
+    capture.moved = moved;
+
+    for (int s = CPU; s < NUM_EXECUTION_SPACES && !capture.move.key; ++s) {
+      capture.move.key = record->m_pointers[s];
+    }
+
+    m_capture_plan->m_kernels.back().captures.push_back(capture);
+  }
+
+  return moved;
+}
+
+void ArrayManager::instrumentCapture(PointerRecord* record,
+                                     ExecutionSpace space,
+                                     size_t value)
+{
+  m_tracer->recordInstant(Tracer::TRACE_CAPTURE, space, record->m_size);
+
+  if (record == &s_null_record) {
     return;
   }
 
+  m_array_statistics->recordCapture(record, space);
+  m_operation_recorder->record(OPERATION_CAPTURE, record, space, value);
+
+  if (m_metrics.isEnabled()) {
+    m_metrics.recordCapture();
+  }
+
+  if (m_region_statistics->isEnabled()) {
+    RegionStatistics::current()->recordCapture();
+  }
+}
+
+void ArrayManager::issueTransfers(Transfer const* transfers, size_t count)
+{
+  if (count == 0) {
+    return;
+  }
+
+  if (m_transfer_checker->isEnabled()) {
+    checkTransfers(transfers, count);
+  }
+
+  if (m_defer_transfers) {
+    m_deferred_transfers.insert(m_deferred_transfers.end(),
+                                transfers,
+                                transfers + count);
+  } else {
+    copyTransfers(transfers, count);
+  }
+
+  for (size_t i = 0; i < count; ++i) {
+    finishMove(transfers[i]);
+  }
+}
+
+bool ArrayManager::prepareMove(PointerRecord* record,
+                               ExecutionSpace space,
+                               Transfer& transfer)
+{
+  if (space == NONE) {
+    return false;
+  }
+
+  if (space == record->m_last_space) {
+    return false;
+  }
+
 #if defined(CHAI_ENABLE_UM)
   if (record->m_last_space == UM) {
-    return;
+    return false;
   }
 #endif
 
@@ -241,7 +653,7 @@ void ArrayManager::move(PointerRecord* record, ExecutionSpace space)
     if (space == CPU) {
       syncIfNeeded();
     }
-    return;
+    return false;
   }
 #endif
 
@@ -255,17 +667,626 @@ void ArrayManager::move(PointerRecord* record, ExecutionSpace space)
 
 
   if ( (!record->m_touched[record->m_last_space]) || (! src_pointer )) {
+    return false;
+  }
+
+  transfer.record = record;
+  transfer.dst = dst_pointer;
+  transfer.src = src_pointer;
+  transfer.size = record->m_size;
+  transfer.dst_space = space;
+  transfer.src_space = record->m_last_space;
+
+  return true;
+}
+
+void ArrayManager::finishMove(Transfer const& transfer)
+{
+  // Exclude the copy if src and dst are the same (can happen for PINNED memory)
+  if (transfer.dst != transfer.src) {
+    callback(transfer.record, ACTION_MOVE, transfer.dst_space);
+
+    if (Instrumentation::isEnabled()) {
+      m_kernel_statistics->recordMove(transfer.size);
+      if (m_tag_statistics->isEnabled()) {
+        m_tag_statistics->recordMove(transfer.record->m_name, transfer.size);
+      }
+      if (m_metrics.isEnabled()) {
+        m_metrics.recordMove(transfer.dst_space, transfer.size);
+      }
+      if (m_region_statistics->isEnabled()) {
+        RegionStatistics::current()->recordMove(transfer.dst_space,
+                                                transfer.size);
+      }
+      if (m_array_statistics->isEnabled()) {
+        m_array_statistics->recordMove(transfer.record,
+                                       transfer.src_space,
+                                       transfer.dst_space,
+                                       transfer.size);
+      }
+    }
+  }
+
+  resetTouch(transfer.record);
+}
+
+void ArrayManager::copyTransfers(Transfer const* transfers, size_t count)
+{
+  const bool instrumented = Instrumentation::isEnabled();
+  const bool timed = instrumented && m_metrics.isEnabled();
+  const std::uint64_t start =
+      instrumented && m_tracer->isEnabled() ? m_tracer->now() : 0;
+  const Metrics::Clock::time_point begin =
+      timed ? Metrics::Clock::now() : Metrics::Clock::time_point();
+
+#if defined(CHAI_ENABLE_GPU_SIMULATION_MODE)
+  // As on a real device, copies wait for the kernels already launched
+  if (count > 0) {
+    syncIfNeeded();
+  }
+#endif
+
+  // Moves of kernels on a device resource are queued on it, ahead of the
+  // kernel. A host resource runs in order with the host, so its moves take
+  // the same path as without a resource.
+  if (m_resource_launch && m_resource_on_device) {
+    for (size_t i = 0; i < count; ++i) {
+      if (transfers[i].dst != transfers[i].src) {
+        m_resource.memcpy(transfers[i].dst, transfers[i].src,
+                          transfers[i].size);
+      }
+    }
+
+    if (timed) {
+      m_metrics.recordMoveLatency(Metrics::Clock::now() - begin);
+    }
+    if (instrumented) {
+      traceTransfers(transfers, count, start);
+    }
+    return;
+  }
+
+  // The pool is only started once parallel copies are turned on
+  ThreadPool* pool = m_parallel_copies ? ThreadPool::getInstance() : nullptr;
+  const bool parallel = pool && pool->getNumThreads() > 1;
+
+  // Blocks of the large host copies, as (transfer index, offset) pairs
+  std::vector<std::pair<size_t, size_t>> blocks;
+
+  for (size_t i = 0; i < count; ++i) {
+    Transfer const& transfer = transfers[i];
+
+    if (transfer.dst == transfer.src) {
+      continue;
+    }
+
+#if defined(CHAI_ENABLE_GPU_SIMULATION_MODE)
+    if (usesCopyEngine(transfer)) {
+      SimulatedDevice::getInstance()->copy(
+          transfer.dst, transfer.src, transfer.size, copyDirection(transfer));
+      continue;
+    }
+#endif
+
+    if (parallel &&
+        transfer.size >= s_parallel_copy_size &&
+        isHostAccessible(transfer.src_space) &&
+        isHostAccessible(transfer.dst_space)) {
+      for (size_t offset = 0; offset < transfer.size;
+           offset += s_parallel_copy_block) {
+        blocks.emplace_back(i, offset);
+      }
+    } else {
+      m_resource_manager.copy(transfer.dst, transfer.src);
+    }
+  }
+
+  if (!blocks.empty()) {
+    const int num_blocks = static_cast<int>(blocks.size());
+
+    pool->parallelFor(0, num_blocks, SCHEDULE_WORK_STEALING,
+      [&] (int begin, int end) {
+        for (int b = begin; b < end; ++b) {
+          Transfer const& transfer = transfers[blocks[b].first];
+          const size_t offset = blocks[b].second;
+          const size_t bytes =
+              std::min(s_parallel_copy_block, transfer.size - offset);
+
+          std::memcpy(static_cast<char*>(transfer.dst) + offset,
+                      static_cast<char*>(transfer.src) + offset,
+                      bytes);
+        }
+      }, 1);
+  }
+
+  if (timed) {
+    m_metrics.recordMoveLatency(Metrics::Clock::now() - begin);
+  }
+  if (instrumented) {
+    traceTransfers(transfers, count, start);
+  }
+}
+
+void ArrayManager::traceTransfers(Transfer const* transfers,
+                                  size_t count,
+                                  std::uint64_t start)
+{
+  if (!m_tracer->isEnabled()) {
+    return;
+  }
+
+  // The copies of a batch overlap, so each spans the whole batch
+  for (size_t i = 0; i < count; ++i) {
+    if (transfers[i].dst != transfers[i].src) {
+      m_tracer->recordSpan(Tracer::TRACE_MOVE,
+                           transfers[i].dst_space,
+                           transfers[i].src_space,
+                           transfers[i].size,
+                           start);
+    }
+  }
+}
+
+void ArrayManager::checkTransfers(Transfer const* transfers, size_t count)
+{
+  // The sources must hold what the kernels launched so far wrote
+  syncIfNeeded();
+
+  for (size_t i = 0; i < count; ++i) {
+    Transfer const& transfer = transfers[i];
+
+    if (transfer.dst == transfer.src) {
+      continue;
+    }
+
+    if (isHostAccessible(transfer.src_space)) {
+      m_transfer_checker->recordTransfer(transfer.record,
+                                         transfer.src_space,
+                                         transfer.dst_space,
+                                         transfer.src,
+                                         transfer.size);
+    } else {
+      void* staging = m_allocators[CPU]->allocate(transfer.size);
+      m_resource_manager.copy(staging, transfer.src, transfer.size);
+      m_transfer_checker->recordTransfer(transfer.record,
+                                         transfer.src_space,
+                                         transfer.dst_space,
+                                         staging,
+                                         transfer.size);
+      m_allocators[CPU]->deallocate(staging);
+    }
+  }
+}
+
+void ArrayManager::beginDeferredTransfers()
+{
+  abandonCaptureSite();
+  m_defer_transfers = true;
+}
+
+void ArrayManager::copyDeferredTransfers(size_t chunk, size_t num_chunks)
+{
+  if (m_deferred_transfers.empty()) {
+    return;
+  }
+
+  // Slices are not ordered with the default stream, so wait for the kernels
+  // launched before this batch of moves once, before the first slice.
+  if (chunk == 0) {
+    syncIfNeeded();
+  }
+
+  for (Transfer const& transfer : m_deferred_transfers) {
+    if (transfer.dst == transfer.src) {
+      continue;
+    }
+
+    const size_t slice_begin = transfer.size * chunk / num_chunks;
+    const size_t slice_end = transfer.size * (chunk + 1) / num_chunks;
+
+    if (slice_begin == slice_end) {
+      continue;
+    }
+
+    void* dst = static_cast<char*>(transfer.dst) + slice_begin;
+    void* src = static_cast<char*>(transfer.src) + slice_begin;
+    const size_t bytes = slice_end - slice_begin;
+    const std::uint64_t start = m_tracer->isEnabled() ? m_tracer->now() : 0;
+
+#if defined(CHAI_ENABLE_GPU_SIMULATION_MODE)
+    if (usesCopyEngine(transfer)) {
+      SimulatedDevice::getInstance()->copy(dst, src, bytes,
+                                           copyDirection(transfer));
+    } else {
+      std::memcpy(dst, src, bytes);
+    }
+#elif defined(CHAI_ENABLE_CUDA)
+    CHAI_GPU_ERROR_CHECK(cudaMemcpyAsync(dst, src, bytes, cudaMemcpyDefault,
+                                         sliceStream()));
+#elif defined(CHAI_ENABLE_HIP)
+    CHAI_GPU_ERROR_CHECK(hipMemcpyAsync(dst, src, bytes, hipMemcpyDefault,
+                                        sliceStream()));
+#else
+    m_resource_manager.copy(dst, src, bytes);
+#endif
+
+    m_tracer->recordSpan(Tracer::TRACE_MOVE, transfer.dst_space,
+                         transfer.src_space, bytes, start);
+  }
+
+#if defined(CHAI_ENABLE_CUDA)
+  CHAI_GPU_ERROR_CHECK(cudaStreamSynchronize(sliceStream()));
+#elif defined(CHAI_ENABLE_HIP)
+  CHAI_GPU_ERROR_CHECK(hipStreamSynchronize(sliceStream()));
+#endif
+}
+
+void ArrayManager::endDeferredTransfers()
+{
+  m_defer_transfers = false;
+  m_deferred_transfers.clear();
+}
+
+void ArrayManager::beginCapture(MovePlan& plan)
+{
+  abandonCaptureSite();
+  plan.clear();
+  m_capture_plan = &plan;
+}
+
+void ArrayManager::endCapture()
+{
+  if (m_capture_plan) {
+    m_capture_plan->optimize();
+    m_capture_plan = nullptr;
+  }
+}
+
+void ArrayManager::beginReplay(MovePlan const& plan)
+{
+  abandonCaptureSite();
+  m_replay_plan = &plan;
+  m_replay_kernel = 0;
+  m_replay_capture = 0;
+  m_replay_matched = true;
+}
+
+bool ArrayManager::endReplay()
+{
+  if (m_replay_plan && m_replay_matched) {
+    const auto& kernels = m_replay_plan->m_kernels;
+
+    m_replay_matched =
+        m_replay_kernel == kernels.size() &&
+        (m_replay_kernel == 0 ||
+         m_replay_capture == kernels[m_replay_kernel - 1].captures.size());
+  }
+
+  const bool matched = m_replay_plan && m_replay_matched;
+
+  m_replay_plan = nullptr;
+  m_replay_matched = false;
+
+  return matched;
+}
+
+void ArrayManager::beginAccessRecording(std::vector<Access>& accesses)
+{
+  m_recorded_accesses = &accesses;
+
+  if (m_current_execution_space == GPU) {
+    m_kernel_has_event = true;
+  }
+}
+
+void ArrayManager::endAccessRecording()
+{
+  m_recorded_accesses = nullptr;
+}
+
+void ArrayManager::registerEvent(Event const& event,
+                                 std::vector<Access> const& accesses)
+{
+  for (auto const& access : accesses) {
+    access.record->m_event = event;
+  }
+
+  if (event.getSpace() == GPU && m_current_execution_space == GPU) {
+    m_kernel_has_event = true;
+  }
+}
+
+void ArrayManager::waitForEvent(PointerRecord* record, ExecutionSpace space)
+{
+  if (!record || record == &s_null_record) {
+    return;
+  }
+
+  Event& event = record->m_event;
+
+  if (event.getSpace() == NONE) {
+    return;
+  }
+
+  // A kernel on a resource waits on the resource for kernels on resources,
+  // and on the host for kernels on the default stream
+  if (m_resource_launch) {
+    camp::resources::Event* resource_event = event.getResourceEvent();
+
+    if (resource_event && space == m_current_execution_space) {
+      m_resource.wait_for(resource_event);
+      return;
+    }
+  } else if (event.getSpace() == GPU && space == GPU &&
+             !event.getResourceEvent()) {
+    // Only kernels on the default stream are in order with this one
     return;
-  } else if (dst_pointer != src_pointer) {
-    // Exclude the copy if src and dst are the same (can happen for PINNED memory)
+  }
+
+  event.wait();
+  event = Event();
+}
+
+void ArrayManager::setCaptureSite(void const* site)
+{
+  m_next_capture_site = site;
+}
+
+void ArrayManager::setResource(camp::resources::Resource const& resource)
+{
+  m_resource = resource;
+  m_has_resource = true;
+
+  const camp::resources::Platform platform = m_resource.get_platform();
+  m_resource_on_device = platform == camp::resources::Platform::cuda ||
+                         platform == camp::resources::Platform::hip;
+}
+
+void ArrayManager::clearResource()
+{
+  m_resource = camp::resources::Resource{camp::resources::Host{}};
+  m_has_resource = false;
+  m_resource_on_device = false;
+}
+
+void ArrayManager::recordLaunchEvent()
+{
+  if (m_resource_captures.empty()) {
+    return;
+  }
+
+  const Event event(m_resource.get_event(), m_resource_space);
+
+  for (PointerRecord* record : m_resource_captures) {
+    record->m_event = event;
+  }
+
+  m_resource_captures.clear();
+}
+
+void ArrayManager::disableCaptureCache()
+{
+  abandonCaptureSite();
+  m_capture_cache_active = false;
+
+  for (auto& sites : m_capture_sites) {
+    sites.clear();
+  }
+}
+
+void ArrayManager::findCaptureSite(PointerRecord* record)
+{
+  m_capture_site_pending = false;
+
+  auto& sites = m_capture_sites[m_current_execution_space];
+  void const* key = m_next_capture_site ? m_next_capture_site
+                                        : static_cast<void const*>(record);
+
+  // Sites named after records that have since been freed are never found
+  // again, so start over rather than let them pile up
+  if (sites.size() >= s_max_capture_sites && sites.find(key) == sites.end()) {
+    sites.clear();
+  }
+
+  m_capture_site = &sites[key];
+  m_capture_index = 0;
+  m_capture_site_matched = true;
+}
+
+void ArrayManager::endCaptureSite()
+{
+  m_capture_site_pending = false;
+
+  if (!m_capture_site) {
+    return;
+  }
+
+  // Captures the kernel did not make this time are no longer part of it
+  m_capture_site->resize(m_capture_index);
+
+  // Captures of UM and PINNED arrays may synchronize every time
+  for (auto& cached : *m_capture_site) {
+    const ExecutionSpace last_space = cached.record->m_last_space;
+    const bool cacheable = last_space != UM && last_space != PINNED;
+    cached.generation = cacheable ? cached.record->m_generation : 0;
+  }
+
+  m_capture_site = nullptr;
+  m_capture_index = 0;
+  m_capture_site_matched = false;
+}
+
+void ArrayManager::abandonCaptureSite()
+{
+  m_capture_site_pending = false;
+  m_capture_site = nullptr;
+  m_capture_index = 0;
+  m_capture_site_matched = false;
+}
+
+void ArrayManager::forgetRecord(PointerRecord* record)
+{
+  forgetCapture(record);
+  forgetResourceCapture(record);
+  m_array_statistics->forget(record);
+  m_operation_recorder->forget(record);
+  m_transfer_checker->forget(record);
+}
+
+void ArrayManager::forgetCapture(PointerRecord* record)
+{
+  if (!m_capture_site) {
+    return;
+  }
+
+  for (auto const& cached : *m_capture_site) {
+    if (cached.record == record) {
+      m_capture_site->clear();
+      abandonCaptureSite();
+      return;
+    }
+  }
+}
+
+void ArrayManager::forgetResourceCapture(PointerRecord* record)
+{
+  m_resource_captures.erase(std::remove(m_resource_captures.begin(),
+                                        m_resource_captures.end(),
+                                        record),
+                            m_resource_captures.end());
+}
+
+void ArrayManager::replayKernel(ExecutionSpace space)
+{
+  if (!m_replay_matched) {
+    return;
+  }
+
+  const auto& kernels = m_replay_plan->m_kernels;
+
+  // The previous kernel must have made all of its recorded captures
+  if ((m_replay_kernel > 0 &&
+       m_replay_capture != kernels[m_replay_kernel - 1].captures.size()) ||
+      m_replay_kernel == kernels.size() ||
+      kernels[m_replay_kernel].space != space) {
+    CHAI_LOG(Debug, "Kernel " << m_replay_kernel << " does not match the plan");
+    m_replay_matched = false;
+    return;
+  }
+
+  const MovePlan::Kernel& kernel = kernels[m_replay_kernel];
+  ++m_replay_kernel;
+  m_replay_capture = 0;
+
+  std::vector<Transfer> transfers;
+  transfers.reserve(kernel.moves.size());
+
+  for (const auto& planned : kernel.moves) {
+    // Skip records that no longer describe the recorded allocation
     {
-      m_resource_manager.copy(dst_pointer, src_pointer);
+      std::lock_guard<std::mutex> lock(m_mutex);
+      auto found = m_pointer_map.find(planned.key);
+      if (found == m_pointer_map.end() || !found->second ||
+          *found->second != planned.record ||
+          planned.record->m_size != planned.size) {
+        continue;
+      }
+    }
+
+    // Kernels still writing the array must finish before it is copied
+    waitForEvent(planned.record, planned.space);
+
+    Transfer transfer;
+    if (prepareMove(planned.record, planned.space, transfer)) {
+      transfers.push_back(transfer);
     }
+  }
+
+  issueTransfers(transfers.data(), transfers.size());
+}
+
+void ArrayManager::replayCapture(PointerRecord* record, ExecutionSpace space)
+{
+  if (!m_replay_matched) {
+    return;
+  }
+
+  const auto& kernels = m_replay_plan->m_kernels;
+
+  if (m_replay_kernel == 0 ||
+      m_replay_capture == kernels[m_replay_kernel - 1].captures.size()) {
+    m_replay_matched = false;
+    return;
+  }
+
+  const MovePlan::Move& recorded =
+      kernels[m_replay_kernel - 1].captures[m_replay_capture].move;
 
-    callback(record, ACTION_MOVE, space);
+  if (recorded.record != record || recorded.space != space) {
+    CHAI_LOG(Debug, "Capture of " << record << " does not match the plan");
+    m_replay_matched = false;
+    return;
   }
 
-  resetTouch(record);
+  ++m_replay_capture;
+}
+
+bool ArrayManager::captureReplayed(PointerRecord* record,
+                                   ExecutionSpace space,
+                                   bool write)
+{
+  if (!m_replay_matched || m_replay_kernel == 0 ||
+      space != m_current_execution_space) {
+    return false;
+  }
+
+  const auto& captures = m_replay_plan->m_kernels[m_replay_kernel - 1].captures;
+
+  if (m_replay_capture == captures.size() ||
+      captures[m_replay_capture].move.record != record ||
+      captures[m_replay_capture].move.space != space) {
+    return false;
+  }
+
+  // The planned moves have already run, so the array only needs checking.
+  // Captures of UM and PINNED arrays may synchronize, so they are left to
+  // the normal path too.
+  const ExecutionSpace last_space = record->m_last_space;
+  if (last_space == UM || last_space == PINNED || !record->m_pointers[space] ||
+      (last_space != space && record->m_touched[last_space] &&
+       record->m_pointers[last_space])) {
+    return false;
+  }
+
+  ++m_replay_capture;
+  ++m_num_replayed_captures;
+
+  if (Instrumentation::isEnabled()) {
+    instrumentCapture(record, space, 0);
+  }
+
+  if (record->m_event.getSpace() != NONE) {
+    waitForEvent(record, space);
+  }
+
+  if (m_resource_launch) {
+    m_resource_captures.push_back(record);
+  }
+
+  callback(record, ACTION_CAPTURED, space);
+
+  if (m_recorded_accesses) {
+    Access access;
+    access.record = record;
+    access.write = write;
+    m_recorded_accesses->push_back(access);
+  }
+
+  if (write) {
+    registerTouch(record, space);
+  }
+
+  return true;
 }
 
 void ArrayManager::allocate(
@@ -275,9 +1296,36 @@ void ArrayManager::allocate(
   auto size = pointer_record->m_size;
   auto alloc = m_resource_manager.getAllocator(pointer_record->m_allocators[space]);
 
+  const bool instrumented = Instrumentation::isEnabled();
+  const bool timed = instrumented && m_metrics.isEnabled();
+  const Metrics::Clock::time_point begin =
+      timed ? Metrics::Clock::now() : Metrics::Clock::time_point();
+
   pointer_record->m_pointers[space] = alloc.allocate(size);
+
+  if (timed) {
+    m_metrics.recordAllocation(space, size, Metrics::Clock::now() - begin);
+  }
+
   callback(pointer_record, ACTION_ALLOC, space);
 
+  if (instrumented) {
+    if (m_region_statistics->isEnabled()) {
+      RegionStatistics::current()->recordAllocation(size);
+    }
+    m_kernel_statistics->recordAllocation(size);
+    m_tracer->recordInstant(Tracer::TRACE_ALLOCATE, space, size);
+    if (m_tag_statistics->isEnabled()) {
+      m_tag_statistics->recordAllocation(pointer_record->m_name, space, size);
+      pointer_record->m_tagged[space] = true;
+    }
+    m_operation_recorder->record(OPERATION_ALLOCATE, pointer_record, space,
+                                 size);
+    m_transfer_checker->forget(pointer_record, space);
+    m_allocation_profiler->recordAllocation(pointer_record->m_pointers[space],
+                                            space, size);
+  }
+
   registerPointer(pointer_record, space);
 
   CHAI_LOG(Debug, "Allocated array at: " << pointer_record->m_pointers[space]);
@@ -287,6 +1335,19 @@ void ArrayManager::free(PointerRecord* pointer_record, ExecutionSpace spaceToFre
 {
   if (!pointer_record) return;
 
+  if (pointer_record != &s_null_record) {
+    m_operation_recorder->record(OPERATION_FREE, pointer_record, spaceToFree);
+  }
+
+  waitForEvent(pointer_record);
+
+#if defined(CHAI_ENABLE_GPU_SIMULATION_MODE)
+  // Kernels that are still running may be using the memory
+  if (pointer_record->m_pointers[GPU]) {
+    syncIfNeeded();
+  }
+#endif
+
   for (int space = CPU; space < NUM_EXECUTION_SPACES; ++space) {
     if (space == spaceToFree || spaceToFree == NONE) {
       if (pointer_record->m_pointers[space]) {
@@ -297,6 +1358,18 @@ void ArrayManager::free(PointerRecord* pointer_record, ExecutionSpace spaceToFre
             callback(pointer_record,
                      ACTION_FREE,
                      ExecutionSpace(UM));
+            m_tracer->recordInstant(Tracer::TRACE_FREE, ExecutionSpace(UM),
+                                    pointer_record->m_size);
+            if (pointer_record->m_tagged[UM]) {
+              m_tag_statistics->recordFree(pointer_record->m_name,
+                                           ExecutionSpace(UM),
+                                           pointer_record->m_size);
+              pointer_record->m_tagged[UM] = false;
+            }
+            if (m_metrics.isEnabled()) {
+              m_metrics.recordFree(ExecutionSpace(UM), pointer_record->m_size);
+            }
+            m_allocation_profiler->recordFree(space_ptr);
 
             auto alloc = m_resource_manager.getAllocator(pointer_record->m_allocators[UM]);
             alloc.deallocate(space_ptr);
@@ -311,6 +1384,19 @@ void ArrayManager::free(PointerRecord* pointer_record, ExecutionSpace spaceToFre
             callback(pointer_record,
                      ACTION_FREE,
                      ExecutionSpace(PINNED));
+            m_tracer->recordInstant(Tracer::TRACE_FREE, ExecutionSpace(PINNED),
+                                    pointer_record->m_size);
+            if (pointer_record->m_tagged[PINNED]) {
+              m_tag_statistics->recordFree(pointer_record->m_name,
+                                           ExecutionSpace(PINNED),
+                                           pointer_record->m_size);
+              pointer_record->m_tagged[PINNED] = false;
+            }
+            if (m_metrics.isEnabled()) {
+              m_metrics.recordFree(ExecutionSpace(PINNED),
+                                   pointer_record->m_size);
+            }
+            m_allocation_profiler->recordFree(space_ptr);
 
             auto alloc = m_resource_manager.getAllocator(
                 pointer_record->m_allocators[PINNED]);
@@ -325,6 +1411,19 @@ void ArrayManager::free(PointerRecord* pointer_record, ExecutionSpace spaceToFre
             callback(pointer_record,
                      ACTION_FREE,
                      ExecutionSpace(space));
+            m_tracer->recordInstant(Tracer::TRACE_FREE, ExecutionSpace(space),
+                                    pointer_record->m_size);
+            if (pointer_record->m_tagged[space]) {
+              m_tag_statistics->recordFree(pointer_record->m_name,
+                                           ExecutionSpace(space),
+                                           pointer_record->m_size);
+              pointer_record->m_tagged[space] = false;
+            }
+            if (m_metrics.isEnabled()) {
+              m_metrics.recordFree(ExecutionSpace(space),
+                                   pointer_record->m_size);
+            }
+            m_allocation_profiler->recordFree(space_ptr);
 
             auto alloc = m_resource_manager.getAllocator(
                 pointer_record->m_allocators[space]);
@@ -348,8 +1447,13 @@ void ArrayManager::free(PointerRecord* pointer_record, ExecutionSpace spaceToFre
     }
   }
   
-  if (pointer_record != &s_null_record && spaceToFree == NONE) {
-    delete pointer_record;
+  if (pointer_record != &s_null_record) {
+    if (spaceToFree == NONE) {
+      forgetRecord(pointer_record);
+      delete pointer_record;
+    } else {
+      updateGeneration(pointer_record);
+    }
   }
 }
 
@@ -437,11 +1541,52 @@ PointerRecord* ArrayManager::makeManaged(void* pointer,
   return pointer_record;
 }
 
+void ArrayManager::setName(PointerRecord* record, const char* name)
+{
+  if (!record || record == &s_null_record) {
+    return;
+  }
+
+  // Move the memory the array holds to its new name. Arrays named when they
+  // are allocated hold none yet.
+  for (int space = CPU; space < NUM_EXECUTION_SPACES; ++space) {
+    if (record->m_tagged[space]) {
+      m_tag_statistics->recordRename(record->m_name, name,
+                                     ExecutionSpace(space), record->m_size);
+    }
+  }
+
+  record->m_name = name;
+}
+
+bool ArrayManager::ownsAllocation(PointerRecord const* record, int space) const
+{
+  void* pointer = record->m_pointers[space];
+
+  if (!pointer || !record->m_owned[space]) {
+    return false;
+  }
+
+#if defined(CHAI_ENABLE_UM)
+  if (space != UM && pointer == record->m_pointers[UM]) {
+    return false;
+  }
+#endif
+#if defined(CHAI_ENABLE_PINNED)
+  if (space != PINNED && pointer == record->m_pointers[PINNED]) {
+    return false;
+  }
+#endif
+
+  return true;
+}
+
 PointerRecord* ArrayManager::deepCopyRecord(PointerRecord const* record)
 {
   PointerRecord* copy = new PointerRecord{};
   const size_t size = record->m_size;
   copy->m_size = size;
+  copy->m_name = record->m_name;
   copy->m_user_callback = [] (const PointerRecord*, Action, ExecutionSpace) {};
 
   const ExecutionSpace last_space = record->m_last_space;
@@ -537,29 +1682,64 @@ void ArrayManager::evict(ExecutionSpace space, ExecutionSpace destinationSpace)
       return;
    }
 
-   // Now move and evict
+   m_operation_recorder->record(OPERATION_EVICT, space, destinationSpace);
+
+   // Collect the records first: allocating in the destination space
+   // registers new pointers, which needs m_mutex.
    std::vector<PointerRecord*> pointersToEvict;
-   std::lock_guard<std::mutex> lock(m_mutex);
-   for (const auto& entry : m_pointer_map) {
-      // Get the pointer record
-      auto record = *entry.second;
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      for (const auto& entry : m_pointer_map) {
+         pointersToEvict.push_back(*entry.second);
+      }
+   }
 
-      // Move the data and register the touches
-      move(record, destinationSpace);
-      registerTouch(record, destinationSpace);
+   // A record appears once for each space it is allocated in
+   std::sort(pointersToEvict.begin(), pointersToEvict.end());
+   pointersToEvict.erase(
+      std::unique(pointersToEvict.begin(), pointersToEvict.end()),
+      pointersToEvict.end());
+
+   const std::uint64_t start = m_tracer->isEnabled() ? m_tracer->now() : 0;
+
+   // Move the data as a single batch of transfers
+   std::vector<Transfer> transfers;
+   transfers.reserve(pointersToEvict.size());
+
+   for (const auto& record : pointersToEvict) {
+      waitForEvent(record, destinationSpace);
+      callback(record, ACTION_CAPTURED, destinationSpace);
+
+      Transfer transfer;
+      if (prepareMove(record, destinationSpace, transfer)) {
+         transfers.push_back(transfer);
+      }
+   }
+
+   if (m_transfer_checker->isEnabled()) {
+      checkTransfers(transfers.data(), transfers.size());
+   }
 
-      // If the destinationSpace is ever allowed to be NONE, then we will need to
-      // update the touch in the eviction space and make sure the last space is not
-      // the eviction space.
+   copyTransfers(transfers.data(), transfers.size());
 
-      // Mark record for eviction later in this routine
-      pointersToEvict.push_back(record);
+   size_t bytes = 0;
+   for (const auto& transfer : transfers) {
+      finishMove(transfer);
+      bytes += transfer.size;
    }
 
-   // This must be done in a second pass because free erases from m_pointer_map,
-   // which would invalidate the iterator in the above loop
-   for (const auto& entry : pointersToEvict) {
-      free(entry, space);
+   m_tracer->recordSpan(Tracer::TRACE_EVICT, destinationSpace, space, bytes,
+                        start);
+   if (m_metrics.isEnabled()) {
+      m_metrics.recordEviction(bytes);
+   }
+
+   // If the destinationSpace is ever allowed to be NONE, then we will need to
+   // update the touch in the eviction space and make sure the last space is not
+   // the eviction space.
+   for (const auto& record : pointersToEvict) {
+      registerTouch(record, destinationSpace);
+      free(record, space);
    }
 }
 
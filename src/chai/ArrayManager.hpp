@@ -8,16 +8,34 @@
 #define CHAI_ArrayManager_HPP
 
 #include "chai/config.hpp"
+#include "chai/AllocationProfiler.hpp"
+#include "chai/ArrayStatistics.hpp"
 #include "chai/ChaiMacros.hpp"
 #include "chai/ExecutionSpaces.hpp"
+#include "chai/Instrumentation.hpp"
+#include "chai/Metrics.hpp"
+#include "chai/MovePlan.hpp"
+#include "chai/OperationLog.hpp"
 #include "chai/PointerRecord.hpp"
+#include "chai/RegionStatistics.hpp"
+#include "chai/TagStatistics.hpp"
+#include "chai/Tracer.hpp"
+#include "chai/TransferChecker.hpp"
 #include "chai/Types.hpp"
 
+#include "camp/resource.hpp"
+
 #if defined(CHAI_ENABLE_RAJA_PLUGIN)
 #include "chai/pluginLinker.hpp"
 #endif
 
+#if defined(CHAI_ENABLE_GPU_SIMULATION_MODE)
+#include "chai/SimulatedDevice.hpp"
+#endif
+
+#include <cstdint>
 #include <unordered_map>
+#include <vector>
 
 #include "umpire/Allocator.hpp"
 #include "umpire/util/MemoryMap.hpp"
@@ -68,7 +86,9 @@ inline void gpuErrorCheck(hipError_t code, const char *file, int line, bool abor
 
 // wrapper for hip/cuda synchronize
 inline void synchronize() {
-#if defined (CHAI_ENABLE_HIP) &&!defined(__HIP_DEVICE_COMPILE__)
+#if defined(CHAI_ENABLE_GPU_SIMULATION_MODE)
+   SimulatedDevice::getInstance()->synchronize();
+#elif defined (CHAI_ENABLE_HIP) &&!defined(__HIP_DEVICE_COMPILE__)
    CHAI_GPU_ERROR_CHECK(hipDeviceSynchronize());
 #elif defined (CHAI_ENABLE_CUDA) &&!defined(__CUDA_ARCH__)
    CHAI_GPU_ERROR_CHECK(cudaDeviceSynchronize());
@@ -115,6 +135,8 @@ CHAI_HOST inline void  gpuMemcpy(void* dst, const void* src, size_t count, gpuMe
 
 #endif //#if defined(CHAI_GPUCC)
 
+class KernelStatistics;
+
 /*!
  * \brief Singleton that manages caching and movement of ManagedArray objects.
  *
@@ -142,6 +164,15 @@ public:
 
   using PointerMap = umpire::util::MemoryMap<PointerRecord*>;
 
+  /*!
+   * \brief A record captured while recording accesses, and whether the
+   *        capture may write to it.
+   */
+  struct Access {
+    PointerRecord* record;
+    bool write;
+  };
+
   CHAISHAREDDLL_API static PointerRecord s_null_record;
 
   /*!
@@ -163,10 +194,23 @@ public:
   /*!
    * \brief Get the current execution space.
    *
+   * The space belongs to the thread launching kernels, so threads marked
+   * with setKernelThread always get NONE.
+   *
    * \return The current execution space.jo
    */
   CHAISHAREDDLL_API ExecutionSpace getExecutionSpace();
 
+  /*!
+   * \brief Mark the calling thread as one that runs kernel bodies.
+   *
+   * Copies of arrays made by kernel bodies on such a thread are never
+   * captures, even while the launching thread is in the middle of one.
+   *
+   * \param kernel_thread Whether the calling thread runs kernel bodies.
+   */
+  CHAISHAREDDLL_API static void setKernelThread(bool kernel_thread);
+
   /*!
    * \brief Move data in pointer to the current execution space.
    *
@@ -177,6 +221,33 @@ public:
                                PointerRecord* pointer_record,
                                ExecutionSpace = NONE);
 
+  /*!
+   * \brief Move the data of several records to space as a single batch.
+   *
+   * Every record is captured as move would capture it, but the copies of all
+   * of them are issued together. A record listed more than once is only
+   * captured once.
+   *
+   * \param records The records to move.
+   * \param count Number of records.
+   * \param space The execution space to move the data to.
+   * \param touch Whether to register a touch of every record in space.
+   */
+  CHAISHAREDDLL_API void move(PointerRecord* const* records,
+                              size_t count,
+                              ExecutionSpace space,
+                              bool touch);
+
+  /*!
+   * \brief Name an array.
+   *
+   * The memory the array holds is accounted under its new name from now on.
+   *
+   * \param record The record of the array.
+   * \param name Name with static storage, or null to remove the name.
+   */
+  CHAISHAREDDLL_API void setName(PointerRecord* record, const char* name);
+
   /*!
    * \brief Register a touch of the pointer in the current execution space.
    *
@@ -326,6 +397,13 @@ public:
    */
   CHAISHAREDDLL_API size_t getTotalSize() const;
 
+  /*!
+   * \brief Get the counters and histograms of the work of the ArrayManager.
+   *
+   * \return Pointer to the registry of metrics.
+   */
+  Metrics* getMetrics() { return &m_metrics; }
+
   /*!
    * \brief Calls callbacks of pointers still in the map with ACTION_LEAKED.
    */
@@ -411,8 +489,28 @@ public:
    */
   bool deviceSynchronize() { return m_device_synchronize; }
 
+  /*!
+   * \brief Split large copies between host accessible spaces into blocks
+   *        copied by the ThreadPool.
+   *
+   * Off by default, so that programs that never use a host policy do not
+   * start the threads of the pool.
+   */
+  void enableParallelCopies() { m_parallel_copies = true; }
+
+  /*!
+   * \brief Copy every array with a single memcpy.
+   */
+  void disableParallelCopies() { m_parallel_copies = false; }
+
   /*!
    * \brief synchronize the device if there hasn't been a synchronize since the last kernel
+   *
+   * Only GPU kernels launched without an event count: kernels that register
+   * an event, such as those of the gpu_async policy, are waited for array by
+   * array when their arrays are next used, so this does not wait for them.
+   * Code that reads device data by other means after such a kernel must wait
+   * for its event, or call chai::synchronize.
    */
   bool syncIfNeeded();
 
@@ -425,6 +523,246 @@ public:
    */
   CHAISHAREDDLL_API void evict(ExecutionSpace space, ExecutionSpace destinationSpace);
 
+  /*!
+   * \brief Start deferring the copies made by moves.
+   *
+   * Until endDeferredTransfers is called, moves allocate the destination and
+   * update the PointerRecord as usual, but leave the data where it is. The
+   * data is then copied in slices with copyDeferredTransfers, which lets a
+   * pipelined kernel work on one slice while the next one is in flight.
+   */
+  CHAISHAREDDLL_API void beginDeferredTransfers();
+
+  /*!
+   * \brief Copy one slice of every deferred transfer.
+   *
+   * Each transfer is split into num_chunks slices of (nearly) equal size, and
+   * slice chunk is copied. Returns once the slice has arrived. The first
+   * slice waits for kernels launched before the transfers were deferred.
+   *
+   * \param chunk Index of the slice to copy.
+   * \param num_chunks Number of slices the transfers are split into.
+   */
+  CHAISHAREDDLL_API void copyDeferredTransfers(size_t chunk, size_t num_chunks);
+
+  /*!
+   * \brief Stop deferring copies and forget the deferred transfers.
+   *
+   * Every slice of the deferred transfers must have been copied already.
+   */
+  CHAISHAREDDLL_API void endDeferredTransfers();
+
+  /*!
+   * \brief Start recording kernels and their captures into a MovePlan.
+   *
+   * Data is moved as usual while recording. Anything already in the plan is
+   * discarded.
+   *
+   * \param plan The plan to record into.
+   */
+  CHAISHAREDDLL_API void beginCapture(MovePlan& plan);
+
+  /*!
+   * \brief Stop recording and compute the moves of the recorded plan.
+   */
+  CHAISHAREDDLL_API void endCapture();
+
+  /*!
+   * \brief Start replaying a recorded MovePlan.
+   *
+   * Each kernel started while replaying issues the moves planned for it as a
+   * single batch. As soon as a kernel or capture differs from the recording,
+   * the remaining kernels fall back to moving data as they are captured.
+   *
+   * \param plan The plan to replay. Must outlive the replay.
+   */
+  CHAISHAREDDLL_API void beginReplay(MovePlan const& plan);
+
+  /*!
+   * \brief Stop replaying.
+   *
+   * \return true if the kernels and captures since beginReplay matched the
+   *         plan exactly, false if the replay fell back to the normal path.
+   */
+  CHAISHAREDDLL_API bool endReplay();
+
+  /*!
+   * \brief Start appending the records captured to accesses.
+   *
+   * Captures of non-const arrays are recorded as writes, as are captures of
+   * arrays in the UM and PINNED spaces, which are never touched explicitly.
+   * A GPU kernel whose accesses are recorded is expected to register an
+   * event, so leaving it does not count as a launch for syncIfNeeded.
+   *
+   * \param accesses Where to record the captures.
+   */
+  CHAISHAREDDLL_API void beginAccessRecording(std::vector<Access>& accesses);
+
+  /*!
+   * \brief Stop recording captures.
+   */
+  CHAISHAREDDLL_API void endAccessRecording();
+
+  /*!
+   * \brief Attach the event of an asynchronous kernel to the arrays it
+   *        captured.
+   *
+   * Later captures, frees and reallocations of those arrays, and picks and
+   * sets of their elements, wait for the event instead of synchronizing the
+   * whole device. Call it after launching the kernel, which may be after
+   * leaving its execution space.
+   *
+   * \param event Completion of the kernel.
+   * \param accesses The captures of the kernel, from beginAccessRecording.
+   */
+  CHAISHAREDDLL_API void registerEvent(Event const& event,
+                                       std::vector<Access> const& accesses);
+
+  /*!
+   * \brief Wait for the last asynchronous kernel that captured an array.
+   *
+   * Kernels on the default stream of the GPU run in launch order, so an
+   * array used next by such a kernel does not wait for another one.
+   *
+   * \param record The record of the array.
+   * \param space The execution space the array is used in next.
+   */
+  CHAISHAREDDLL_API void waitForEvent(PointerRecord* record,
+                                      ExecutionSpace space = CPU);
+
+  /*!
+   * \brief Identify the launch site of the next kernel.
+   *
+   * Once enableCaptureCache has been called, the captures of a kernel are
+   * cached under its launch site, so that launching it again while its
+   * arrays are unchanged skips their moves.
+   * Kernels without a site, such as those launched through the RAJA plugin,
+   * are identified by their first capture instead.
+   *
+   * \param site Address unique to the launch site, used until the next call
+   *        to setExecutionSpace.
+   */
+  CHAISHAREDDLL_API void setCaptureSite(void const* site);
+
+  /*!
+   * \brief Launch the following kernels on a camp resource.
+   *
+   * The moves of kernels launched on the resource are issued on it, in order
+   * with the kernels, and their arrays wait for the event recorded by
+   * recordLaunchEvent rather than for the whole device. Kernels on another
+   * resource that capture the arrays wait for the event on their resource.
+   * Kernels in a space the resource does not run in, such as CPU kernels
+   * while a CUDA stream is set, are launched as if no resource was set.
+   *
+   * Every kernel launched until clearResource is assumed to run on the
+   * resource. A kernel launched on another resource in between is given an
+   * event of this one, so later accesses do not wait for it.
+   *
+   * \param resource The resource, e.g. the camp::resources::Cuda stream the
+   *        following RAJA kernels are launched on.
+   */
+  CHAISHAREDDLL_API void setResource(camp::resources::Resource const& resource);
+
+  /*!
+   * \brief Launch the following kernels on the default stream again.
+   */
+  CHAISHAREDDLL_API void clearResource();
+
+  /*!
+   * \brief Attach an event of the resource to the arrays captured by the
+   *        last kernel launched on it.
+   *
+   * Call it once the kernel has been launched, as the RAJA plugin does after
+   * every launch.
+   */
+  CHAISHAREDDLL_API void recordLaunchEvent();
+
+  /*!
+   * \brief Turn caching of captures on.
+   *
+   * The cache is off by default. Kernels launched through the RAJA plugin are
+   * identified by their first capture, so kernels starting with the same
+   * array share a cache entry and evict each other's captures.
+   */
+  void enableCaptureCache() { m_capture_cache_active = true; }
+
+  /*!
+   * \brief Turn caching of captures off, and forget the cached captures.
+   */
+  CHAISHAREDDLL_API void disableCaptureCache();
+
+  /*!
+   * \brief Get the number of captures completed from the cache.
+   */
+  size_t getNumCachedCaptures() const { return m_num_cached_captures; }
+
+  /*!
+   * \brief Get the number of captures a replay completed without deciding
+   *        whether to move their array.
+   */
+  size_t getNumReplayedCaptures() const { return m_num_replayed_captures; }
+
+  /*!
+   * \brief Complete a capture from the cache if it cannot move anything.
+   *
+   * A capture hits the cache when it is the same, in the same order, as in the
+   * last launch of the kernel, and its record has not changed since then.
+   *
+   * \param record The record of the captured array.
+   * \param space The execution space of the capture.
+   * \param write Whether the capture registers a touch.
+   *
+   * \return true if the capture is complete, false if the array must be
+   *         moved with move.
+   */
+  inline bool captureCached(PointerRecord* record,
+                            ExecutionSpace space,
+                            bool write)
+  {
+    if (m_capture_site_pending) {
+      findCaptureSite(record);
+    }
+
+    if (!m_capture_site_matched || space != m_current_execution_space ||
+        m_capture_index == m_capture_site->size()) {
+      return m_replay_plan && captureReplayed(record, space, write);
+    }
+
+    CachedCapture const& cached = (*m_capture_site)[m_capture_index];
+
+    if (cached.record != record || cached.generation == 0 ||
+        cached.generation != record->m_generation ||
+        (write && (record->m_last_space != space || !record->m_touched[space]))) {
+      return false;
+    }
+
+    ++m_capture_index;
+    ++m_num_cached_captures;
+
+    if (Instrumentation::isEnabled()) {
+      instrumentCapture(record, space, write);
+    }
+
+    if (record->m_event.getSpace() != NONE) {
+      waitForEvent(record, space);
+    }
+
+    if (m_resource_launch) {
+      m_resource_captures.push_back(record);
+    }
+
+    callback(record, ACTION_CAPTURED, space);
+
+    if (m_recorded_accesses) {
+      Access access;
+      access.record = record;
+      access.write = write;
+      m_recorded_accesses->push_back(access);
+    }
+
+    return true;
+  }
+
 
 protected:
   /*!
@@ -439,6 +777,69 @@ protected:
 
 private:
 
+  /*!
+   * \brief Description of a single copy issued by a move.
+   */
+  struct Transfer {
+    PointerRecord* record;
+    void* dst;
+    void* src;
+    size_t size;
+    ExecutionSpace dst_space;
+    ExecutionSpace src_space;
+  };
+
+  /*!
+   * \brief A capture of the last launch of a kernel, and the generation its
+   *        record was left with.
+   */
+  struct CachedCapture {
+    PointerRecord* record;
+    std::uint64_t generation;
+  };
+
+  /*!
+   * \brief Record that the state of a record changed.
+   */
+  void updateGeneration(PointerRecord* record)
+  {
+    record->m_generation = ++m_generation;
+  }
+
+  /*!
+   * \brief Look up the cached captures of the kernel being launched.
+   *
+   * \param record The first record the kernel captures.
+   */
+  void findCaptureSite(PointerRecord* record);
+
+  /*!
+   * \brief Cache the captures of the kernel that is ending.
+   */
+  void endCaptureSite();
+
+  /*!
+   * \brief Stop caching the captures of the current kernel.
+   */
+  void abandonCaptureSite();
+
+  /*!
+   * \brief Remove a record that is about to be deleted from everything that
+   *        keeps it.
+   */
+  void forgetRecord(PointerRecord* record);
+
+  /*!
+   * \brief Remove a record that is about to be deleted from the captures of
+   *        the current kernel.
+   */
+  void forgetCapture(PointerRecord* record);
+
+  /*!
+   * \brief Remove a record that is about to be deleted from the captures
+   *        waiting for recordLaunchEvent.
+   */
+  void forgetResourceCapture(PointerRecord* record);
 
   /*!
    * \brief Move data in PointerRecord to the corresponding ExecutionSpace.
@@ -447,6 +848,104 @@ private:
    * \param space
    */
   void move(PointerRecord* record, ExecutionSpace space);
+
+  /*!
+   * \brief Whether the allocation of record in space was made for space,
+   *        rather than being a UM or PINNED allocation seen from it.
+   */
+  bool ownsAllocation(PointerRecord const* record, int space) const;
+
+  /*!
+   * \brief Perform everything a move does before copying the data.
+   *
+   * \param record
+   * \param space
+   * \param transfer Filled with the copy to perform.
+   *
+   * \return true if the transfer must be issued with issueTransfers.
+   */
+  bool captureRecord(PointerRecord* record,
+                     ExecutionSpace space,
+                     Transfer& transfer);
+
+  /*!
+   * \brief Copy a batch of transfers, or defer them, and complete their
+   *        moves.
+   */
+  void issueTransfers(Transfer const* transfers, size_t count);
+
+  /*!
+   * \brief Perform everything a move does up to the copy itself.
+   *
+   * Allocates the destination if needed.
+   *
+   * \param record
+   * \param space
+   * \param transfer Filled with the copy to perform.
+   *
+   * \return true if the move must be completed with copyTransfers and
+   *         finishMove, false if there is nothing left to do.
+   */
+  bool prepareMove(PointerRecord* record,
+                   ExecutionSpace space,
+                   Transfer& transfer);
+
+  /*!
+   * \brief Complete a move once its transfer has been copied.
+   */
+  void finishMove(Transfer const& transfer);
+
+  /*!
+   * \brief Report a capture to the instruments that are on.
+   *
+   * \param value Passed on to the OperationRecorder.
+   */
+  CHAISHAREDDLL_API void instrumentCapture(PointerRecord* record,
+                                           ExecutionSpace space,
+                                           size_t value);
+
+  /*!
+   * \brief Copy a batch of transfers.
+   *
+   * Large copies between host accessible spaces are split into blocks and
+   * spread over the ThreadPool; everything else goes through umpire.
+   */
+  void copyTransfers(Transfer const* transfers, size_t count);
+
+  /*!
+   * \brief Record the copies of a batch of transfers that started at start.
+   */
+  void traceTransfers(Transfer const* transfers,
+                      size_t count,
+                      std::uint64_t start);
+
+  /*!
+   * \brief Hash the sources of a batch of transfers for the TransferChecker.
+   *
+   * Sources that are not accessible on the host are staged on the host.
+   */
+  void checkTransfers(Transfer const* transfers, size_t count);
+
+  /*!
+   * \brief Issue the planned moves of the next kernel of the replay.
+   */
+  void replayKernel(ExecutionSpace space);
+
+  /*!
+   * \brief Check a capture against the next capture of the replay.
+   */
+  void replayCapture(PointerRecord* record, ExecutionSpace space);
+
+  /*!
+   * \brief Complete the next capture of the replay if the planned moves have
+   *        already put its array where the capture needs it.
+   *
+   * \return true if the capture is complete, false if it must take the
+   *         normal path, which also ends a replay that no longer matches.
+   */
+  CHAISHAREDDLL_API bool captureReplayed(PointerRecord* record,
+                                         ExecutionSpace space,
+                                         bool write);
   
     /*!
    * \brief Execute a user callback if callbacks are active
@@ -518,11 +1017,186 @@ private:
    */
   bool m_device_synchronize = false;
 
+  /*!
+   * Whether large host copies are split across the ThreadPool.
+   */
+  bool m_parallel_copies = false;
+
   /*!
    * Whether or not a synchronize has been performed since the launch of the last
    * GPU context
    */
   bool m_synced_since_last_kernel = false;
+
+  /*!
+   * Whether the current GPU kernel has an event, so that it need not be
+   * waited for by the next synchronize.
+   */
+  bool m_kernel_has_event = false;
+
+  /*!
+   * Whether moves are currently deferring their copies.
+   */
+  bool m_defer_transfers = false;
+
+  /*!
+   * Copies left by moves made while deferring.
+   */
+  std::vector<Transfer> m_deferred_transfers;
+
+  /*!
+   * Plan being recorded, if any.
+   */
+  MovePlan* m_capture_plan = nullptr;
+
+  /*!
+   * Plan being replayed, if any.
+   */
+  MovePlan const* m_replay_plan = nullptr;
+
+  /*!
+   * Number of kernels started, and captures made by the current kernel,
+   * since the replay began.
+   */
+  size_t m_replay_kernel = 0;
+  size_t m_replay_capture = 0;
+
+  /*!
+   * Whether the replay has matched the plan so far.
+   */
+  bool m_replay_matched = false;
+
+  /*!
+   * Where captures are recorded, if anywhere.
+   */
+  std::vector<Access>* m_recorded_accesses = nullptr;
+
+  /*!
+   * Where moves and allocations are attributed to kernels.
+   */
+  KernelStatistics* m_kernel_statistics;
+
+  /*!
+   * Where the traffic of every array is recorded.
+   */
+  ArrayStatistics* m_array_statistics;
+
+  /*!
+   * Where memory and traffic are accounted by name.
+   */
+  TagStatistics* m_tag_statistics;
+
+  /*!
+   * Where the timeline of the work is recorded.
+   */
+  Tracer* m_tracer;
+
+  /*!
+   * Where the operations are logged for replay.
+   */
+  OperationRecorder* m_operation_recorder;
+
+  /*!
+   * Where moves of unchanged data are found.
+   */
+  TransferChecker* m_transfer_checker;
+
+  /*!
+   * Where the call sites holding memory are found.
+   */
+  AllocationProfiler* m_allocation_profiler;
+
+  /*!
+   * Where the traffic of each region of the program is counted. Regions are
+   * used until the last array is freed, so they must outlive the
+   * ArrayManager.
+   */
+  RegionStatistics* m_region_statistics;
+
+  /*!
+   * Counters and histograms of the work of the ArrayManager.
+   */
+  Metrics m_metrics;
+
+  /*!
+   * Time the current kernel started capturing its arrays.
+   */
+  std::uint64_t m_launch_start = 0;
+
+  /*!
+   * Whether captures are cached. Off until enableCaptureCache is called.
+   */
+  bool m_capture_cache_active = false;
+
+  /*!
+   * Cached captures of every launch site, by execution space.
+   */
+  std::unordered_map<void const*, std::vector<CachedCapture>>
+      m_capture_sites[NUM_EXECUTION_SPACES];
+
+  /*!
+   * Launch site given to setCaptureSite for the next kernel.
+   */
+  void const* m_next_capture_site = nullptr;
+
+  /*!
+   * Whether the current kernel still has to look up its launch site.
+   */
+  bool m_capture_site_pending = false;
+
+  /*!
+   * Cached captures of the current kernel, if they are being cached.
+   */
+  std::vector<CachedCapture>* m_capture_site = nullptr;
+
+  /*!
+   * Number of captures made by the current kernel.
+   */
+  size_t m_capture_index = 0;
+
+  /*!
+   * Whether the captures of the current kernel have all hit the cache.
+   */
+  bool m_capture_site_matched = false;
+
+  /*!
+   * Resource the following kernels are launched on, if m_has_resource.
+   */
+  camp::resources::Resource m_resource{camp::resources::Host{}};
+
+  bool m_has_resource = false;
+
+  /*!
+   * Whether m_resource is a device stream, which copies are queued on.
+   */
+  bool m_resource_on_device = false;
+
+  /*!
+   * Whether the current kernel is launched on m_resource.
+   */
+  bool m_resource_launch = false;
+
+  /*!
+   * Execution space of the last kernel launched on m_resource, and the
+   * records it captured.
+   */
+  ExecutionSpace m_resource_space = NONE;
+  std::vector<PointerRecord*> m_resource_captures;
+
+  /*!
+   * Number of captures completed from the cache.
+   */
+  size_t m_num_cached_captures = 0;
+
+  /*!
+   * Number of captures completed by captureReplayed.
+   */
+  size_t m_num_replayed_captures = 0;
+
+  /*!
+   * Last generation given to a record.
+   */
+  std::uint64_t m_generation = 0;
 };
 
 }  // end of namespace chai
@@ -28,6 +28,13 @@ void* ArrayManager::reallocate(void* pointer, size_t elems, PointerRecord* point
 {
   ExecutionSpace my_space = CPU;
 
+  waitForEvent(pointer_record);
+
+#if defined(CHAI_ENABLE_GPU_SIMULATION_MODE)
+  // Kernels that are still running may be using the old allocations
+  syncIfNeeded();
+#endif
+
   for (int space = CPU; space < NUM_EXECUTION_SPACES; ++space) {
     if (pointer_record->m_pointers[space] == pointer) {
       my_space = static_cast<ExecutionSpace>(space);
@@ -42,13 +49,39 @@ void* ArrayManager::reallocate(void* pointer, size_t elems, PointerRecord* point
     }
   }
 
+  m_operation_recorder->record(OPERATION_REALLOCATE, pointer_record, my_space,
+                               sizeof(T) * elems);
+
+  // Whether the allocation in each space is accounted in the TagStatistics
+  // once it is reallocated
+  bool tagged[NUM_EXECUTION_SPACES];
+
   // Call callback with ACTION_FREE before changing the size
   for (int space = CPU; space < NUM_EXECUTION_SPACES; ++space) {
+    tagged[space] = false;
+
+    if (ownsAllocation(pointer_record, space)) {
+       if (pointer_record->m_tagged[space]) {
+         m_tag_statistics->recordFree(pointer_record->m_name,
+                                      ExecutionSpace(space),
+                                      pointer_record->m_size);
+         pointer_record->m_tagged[space] = false;
+       }
+       if (m_metrics.isEnabled()) {
+         m_metrics.recordFree(ExecutionSpace(space), pointer_record->m_size);
+       }
+       tagged[space] = m_tag_statistics->isEnabled();
+    }
+
     if (pointer_record->m_pointers[space]) {
        callback(pointer_record, ACTION_FREE, ExecutionSpace(space));
+       m_tracer->recordInstant(Tracer::TRACE_FREE, ExecutionSpace(space),
+                               pointer_record->m_size);
     }
   }
 
+  updateGeneration(pointer_record);
+
   // Update the pointer record size
   size_t old_size = pointer_record->m_size;
   size_t new_size = sizeof(T) * elems;
@@ -61,12 +94,33 @@ void* ArrayManager::reallocate(void* pointer, size_t elems, PointerRecord* point
     void* old_ptr = pointer_record->m_pointers[space];
 
     if (old_ptr) {
+      const bool timed = m_metrics.isEnabled();
+      const Metrics::Clock::time_point begin =
+          timed ? Metrics::Clock::now() : Metrics::Clock::time_point();
       void* new_ptr = m_allocators[space]->allocate(new_size);
+      if (timed) {
+        m_metrics.recordAllocation(ExecutionSpace(space), new_size,
+                                   Metrics::Clock::now() - begin);
+      }
+      if (m_region_statistics->isEnabled()) {
+        RegionStatistics::current()->recordAllocation(new_size);
+      }
       m_resource_manager.copy(new_ptr, old_ptr, num_bytes_to_copy);
       m_allocators[space]->deallocate(old_ptr);
+      m_allocation_profiler->recordFree(old_ptr);
+      m_allocation_profiler->recordAllocation(new_ptr, ExecutionSpace(space),
+                                              new_size);
 
       pointer_record->m_pointers[space] = new_ptr;
       callback(pointer_record, ACTION_ALLOC, ExecutionSpace(space));
+      m_tracer->recordInstant(Tracer::TRACE_ALLOCATE, ExecutionSpace(space),
+                              new_size);
+      if (tagged[space]) {
+        m_tag_statistics->recordAllocation(pointer_record->m_name,
+                                           ExecutionSpace(space),
+                                           new_size);
+        pointer_record->m_tagged[space] = true;
+      }
 
       m_pointer_map.erase(old_ptr);
       m_pointer_map.insert(new_ptr, pointer_record);
@@ -82,6 +136,9 @@ CHAI_INLINE
 typename ArrayManager::T_non_const<T> ArrayManager::pick(T* src_ptr, size_t index)
 {
   T_non_const<T> val;
+#if defined(CHAI_ENABLE_GPU_SIMULATION_MODE)
+  syncIfNeeded();
+#endif
   m_resource_manager.registerAllocation(const_cast<T_non_const<T>*>(&val), umpire::util::AllocationRecord{const_cast<T_non_const<T>*>(&val), sizeof(T), m_resource_manager.getAllocator("HOST").getAllocationStrategy()});
   m_resource_manager.copy(const_cast<T_non_const<T>*>(&val), const_cast<T_non_const<T>*>(src_ptr+index), sizeof(T));
   m_resource_manager.deregisterAllocation(&val);
@@ -92,6 +149,9 @@ template<typename T>
 CHAI_INLINE
 void ArrayManager::set(T* dst_ptr, size_t index, const T& val)
 {
+#if defined(CHAI_ENABLE_GPU_SIMULATION_MODE)
+  syncIfNeeded();
+#endif
   m_resource_manager.registerAllocation(const_cast<T_non_const<T>*>(&val), umpire::util::AllocationRecord{const_cast<T_non_const<T>*>(&val), sizeof(T), m_resource_manager.getAllocator("HOST").getAllocationStrategy()});
   m_resource_manager.copy(const_cast<T_non_const<T>*>(dst_ptr+index), const_cast<T_non_const<T>*>(&val), sizeof(T));
   m_resource_manager.deregisterAllocation(const_cast<T_non_const<T>*>(&val));
@@ -116,7 +176,9 @@ void ArrayManager::setAllocator(ExecutionSpace space, umpire::Allocator &allocat
 CHAI_INLINE
 bool ArrayManager::syncIfNeeded() {
   if (!m_synced_since_last_kernel) {
+     const std::uint64_t start = m_tracer->isEnabled() ? m_tracer->now() : 0;
      synchronize();
+     m_tracer->recordSpan(Tracer::TRACE_SYNCHRONIZE, NONE, NONE, 0, start);
      m_synced_since_last_kernel = true;
      return true;
   }
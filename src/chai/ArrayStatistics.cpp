@@ -0,0 +1,326 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#include "chai/ArrayStatistics.hpp"
+
+#include "chai/Instrumentation.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace chai
+{
+
+namespace {
+
+const char* spaceName(int space)
+{
+  switch (space) {
+    case CPU:
+      return "CPU";
+    case GPU:
+      return "GPU";
+    case UM:
+      return "UM";
+    case PINNED:
+      return "PINNED";
+    default:
+      return "NONE";
+  }
+}
+
+}  // end of anonymous namespace
+
+constexpr size_t ArrayStatistics::s_history;
+
+ArrayStatistics* ArrayStatistics::getInstance()
+{
+  static ArrayStatistics s_array_statistics_instance;
+  return &s_array_statistics_instance;
+}
+
+ArrayStatistics::ArrayStatistics() :
+  m_enabled{false},
+  m_output{},
+  m_kernels{0},
+  m_max_round_trips{2},
+  m_round_trip_kernels{10},
+  m_live{},
+  m_freed{},
+  m_freed_names{}
+{
+  // Moves point to regions, so the regions must outlive the ArrayStatistics.
+  RegionStatistics::getInstance();
+
+  const char* env = std::getenv("CHAI_ARRAY_STATISTICS");
+  if (env && *env) {
+    m_output = env;
+    setEnabled(true);
+  }
+}
+
+ArrayStatistics::~ArrayStatistics()
+{
+  if (m_output.empty()) {
+    return;
+  }
+
+  if (m_output == "1") {
+    report(std::cerr);
+  } else {
+    std::ofstream file(m_output);
+    report(file);
+  }
+}
+
+void ArrayStatistics::setEnabled(bool enabled)
+{
+  m_enabled = enabled;
+  Instrumentation::setEnabled(INSTRUMENT_ARRAY_STATISTICS, enabled);
+
+  if (!enabled) {
+    // Records deleted from now on are not forgotten, and their addresses
+    // may be reused by new records
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (auto& live : m_live) {
+      fold(live.second);
+    }
+
+    m_live.clear();
+  }
+}
+
+void ArrayStatistics::setPingPongThreshold(size_t round_trips,
+                                           std::uint64_t kernels)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_max_round_trips = round_trips;
+  m_round_trip_kernels = kernels;
+}
+
+void ArrayStatistics::addCapture(PointerRecord const* record,
+                                 ExecutionSpace space)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ++entry(record).captures[space];
+}
+
+void ArrayStatistics::recordMove(PointerRecord const* record,
+                                 ExecutionSpace source,
+                                 ExecutionSpace destination,
+                                 size_t bytes)
+{
+  if (!isEnabled()) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  Entry& moved = entry(record);
+  ++moved.moves;
+  moved.bytes_moved += bytes;
+
+  if (moved.history.size() == s_history) {
+    moved.history.erase(moved.history.begin());
+  }
+
+  Move move;
+  move.source = source;
+  move.destination = destination;
+  move.bytes = bytes;
+  move.kernel = m_kernels.load(std::memory_order_relaxed);
+  move.region = RegionStatistics::current();
+  moved.history.push_back(move);
+}
+
+void ArrayStatistics::forgetRecord(PointerRecord const* record)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  auto live = m_live.find(record);
+  if (live != m_live.end()) {
+    fold(live->second);
+    m_live.erase(live);
+  }
+}
+
+std::vector<ArrayStatistics::Entry> ArrayStatistics::getEntries() const
+{
+  std::vector<Entry> entries;
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    entries.reserve(m_live.size() + m_freed.size());
+
+    for (auto const& live : m_live) {
+      entries.push_back(live.second);
+      classify(entries.back());
+    }
+
+    entries.insert(entries.end(), m_freed.begin(), m_freed.end());
+  }
+
+  std::stable_sort(entries.begin(), entries.end(), [] (Entry const& a, Entry const& b) {
+    return a.bytes_moved > b.bytes_moved;
+  });
+
+  return entries;
+}
+
+void ArrayStatistics::report(std::ostream& stream, size_t max_entries) const
+{
+  std::vector<Entry> entries = getEntries();
+
+  if (max_entries > 0 && entries.size() > max_entries) {
+    entries.resize(max_entries);
+  }
+
+  std::vector<std::string> arrays;
+  size_t array_width = 5;
+
+  for (Entry const& entry : entries) {
+    std::ostringstream array;
+    if (entry.name) {
+      array << entry.name;
+    } else if (entry.pointer) {
+      array << entry.pointer;
+    } else {
+      array << "unnamed";
+    }
+
+    if (entry.arrays > 1) {
+      array << " (" << entry.arrays << " freed)";
+    } else if (entry.freed) {
+      array << " (freed)";
+    }
+
+    arrays.push_back(array.str());
+    array_width = std::max(array_width, arrays.back().size());
+  }
+
+  stream << std::left << std::setw(array_width) << "array" << std::right
+         << std::setw(14) << "size";
+
+  for (int space = CPU; space < NUM_EXECUTION_SPACES; ++space) {
+    stream << std::setw(10) << (std::string(spaceName(space)) + " caps");
+  }
+
+  stream << std::setw(8) << "moves"
+         << std::setw(16) << "bytes moved"
+         << std::setw(13) << "round trips" << "\n";
+
+  for (size_t i = 0; i < entries.size(); ++i) {
+    Entry const& entry = entries[i];
+
+    stream << std::left << std::setw(array_width) << arrays[i] << std::right
+           << std::setw(14) << entry.size;
+
+    for (int space = CPU; space < NUM_EXECUTION_SPACES; ++space) {
+      stream << std::setw(10) << entry.captures[space];
+    }
+
+    stream << std::setw(8) << entry.moves
+           << std::setw(16) << entry.bytes_moved
+           << std::setw(13) << entry.round_trips
+           << (entry.ping_pong ? "  PING-PONG" : "") << "\n";
+  }
+}
+
+void ArrayStatistics::clear()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_live.clear();
+  m_freed.clear();
+  m_freed_names.clear();
+}
+
+ArrayStatistics::Entry& ArrayStatistics::entry(PointerRecord const* record)
+{
+  auto live = m_live.find(record);
+  if (live != m_live.end()) {
+    Entry& found = live->second;
+    found.size = record->m_size;
+    found.name = record->m_name;
+    return found;
+  }
+
+  Entry& created = m_live[record];
+  created.size = record->m_size;
+  created.name = record->m_name;
+  created.pointer = record->m_pointers[CPU];
+
+  for (int space = CPU; space < NUM_EXECUTION_SPACES && !created.pointer; ++space) {
+    created.pointer = record->m_pointers[space];
+  }
+
+  return created;
+}
+
+void ArrayStatistics::fold(Entry& entry)
+{
+  classify(entry);
+  entry.history.clear();
+  entry.freed = true;
+
+  const std::string name = entry.name ? entry.name : "";
+  auto found = m_freed_names.find(name);
+
+  if (found == m_freed_names.end()) {
+    m_freed_names[name] = m_freed.size();
+    m_freed.push_back(std::move(entry));
+    return;
+  }
+
+  Entry& total = m_freed[found->second];
+  total.pointer = nullptr;
+  total.size = std::max(total.size, entry.size);
+
+  for (int space = CPU; space < NUM_EXECUTION_SPACES; ++space) {
+    total.captures[space] += entry.captures[space];
+  }
+
+  total.moves += entry.moves;
+  total.bytes_moved += entry.bytes_moved;
+  total.round_trips += entry.round_trips;
+  total.ping_pong = total.ping_pong || entry.ping_pong;
+  total.arrays += entry.arrays;
+}
+
+void ArrayStatistics::classify(Entry& entry) const
+{
+  if (entry.freed) {
+    return;
+  }
+
+  entry.round_trips = 0;
+
+  if (entry.history.empty()) {
+    entry.ping_pong = false;
+    return;
+  }
+
+  const std::uint64_t last = entry.history.back().kernel;
+
+  for (size_t i = 1; i < entry.history.size(); ++i) {
+    Move const& before = entry.history[i - 1];
+    Move const& move = entry.history[i];
+
+    if (last - move.kernel < m_round_trip_kernels &&
+        move.source == before.destination &&
+        move.destination == before.source) {
+      ++entry.round_trips;
+    }
+  }
+
+  entry.ping_pong = entry.round_trips > m_max_round_trips;
+}
+
+}  // end of namespace chai
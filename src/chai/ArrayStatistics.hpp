@@ -0,0 +1,288 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#ifndef CHAI_ArrayStatistics_HPP
+#define CHAI_ArrayStatistics_HPP
+
+#include "chai/config.hpp"
+#include "chai/ExecutionSpaces.hpp"
+#include "chai/PointerRecord.hpp"
+#include "chai/RegionStatistics.hpp"
+#include "chai/Types.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace chai
+{
+
+/*!
+ * \brief Singleton keeping a heat map of the traffic of every array.
+ *
+ * For every PointerRecord, the ArrayManager reports the captures in each
+ * execution space and the moves, of which the last s_history are kept. A
+ * move that undoes the move before it is a round trip. An array ping-pongs
+ * when more than getMaxRoundTrips round trips were made within the last
+ * getRoundTripKernels kernel launches before its last move, which usually
+ * means a kernel runs in the wrong space, or host code touches the array
+ * every cycle.
+ *
+ * Only the arrays that are live keep an entry of their own. The entry of an
+ * array that is freed is added to the totals of the freed arrays of its
+ * name, and those of the arrays without a name to a single total, so the
+ * number of entries stays bounded by the live arrays and the names.
+ *
+ * Collection is off by default. Setting the CHAI_ARRAY_STATISTICS
+ * environment variable turns it on, and prints the report at shutdown: to
+ * standard error if the variable is 1, and to the file it names otherwise.
+ */
+class ArrayStatistics
+{
+public:
+  /*!
+   * Number of moves kept for every array.
+   */
+  static constexpr size_t s_history = 16;
+
+  /*!
+   * \brief A move of an array.
+   */
+  struct Move {
+    ExecutionSpace source;
+    ExecutionSpace destination;
+    size_t bytes;
+
+    /*!
+     * Number of kernels launched before the move.
+     */
+    std::uint64_t kernel;
+
+    /*!
+     * Region the move was made in.
+     */
+    Region const* region;
+  };
+
+  /*!
+   * \brief Traffic of one array.
+   */
+  struct Entry {
+    /*!
+     * Host pointer of the array, or its first pointer in another space,
+     * identifying arrays without a name.
+     */
+    const void* pointer = nullptr;
+
+    /*!
+     * Name of the array, or null.
+     */
+    const char* name = nullptr;
+
+    /*!
+     * Size of the array in bytes, or of the largest array of a total.
+     */
+    size_t size = 0;
+
+    size_t captures[NUM_EXECUTION_SPACES] = {};
+    size_t moves = 0;
+    size_t bytes_moved = 0;
+
+    /*!
+     * The last moves, oldest first.
+     */
+    std::vector<Move> history;
+
+    /*!
+     * Round trips within the last getRoundTripKernels launches before the
+     * last move.
+     */
+    size_t round_trips = 0;
+    bool ping_pong = false;
+
+    /*!
+     * Whether the entry is the total of arrays that are no longer followed,
+     * because they were freed or collection was turned off. Such an entry
+     * keeps no history, and its round trips are those counted when each of
+     * its arrays was added.
+     */
+    bool freed = false;
+
+    /*!
+     * Number of arrays added up in the entry.
+     */
+    size_t arrays = 1;
+  };
+
+  /*!
+   * \brief Get the singleton instance.
+   *
+   * \return Pointer to the ArrayStatistics instance.
+   */
+  CHAISHAREDDLL_API static ArrayStatistics* getInstance();
+
+  /*!
+   * \brief Print the report if CHAI_ARRAY_STATISTICS is set.
+   */
+  ~ArrayStatistics();
+
+  /*!
+   * \brief Turn collection on or off.
+   *
+   * Records are not followed while collection is off, so turning it off
+   * adds the entries of the arrays that are live to the totals of their
+   * names, as if they were freed.
+   */
+  CHAISHAREDDLL_API void setEnabled(bool enabled);
+
+  /*!
+   * \brief Whether collection is on.
+   */
+  bool isEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+  /*!
+   * \brief Set when arrays are flagged as ping-ponging.
+   *
+   * \param round_trips Most round trips an array may make within kernels
+   *        launches without being flagged.
+   * \param kernels Number of kernel launches round trips are counted over.
+   */
+  CHAISHAREDDLL_API void setPingPongThreshold(size_t round_trips,
+                                              std::uint64_t kernels);
+
+  size_t getMaxRoundTrips() const { return m_max_round_trips; }
+
+  std::uint64_t getRoundTripKernels() const { return m_round_trip_kernels; }
+
+  /*!
+   * \brief Count the launch of a kernel.
+   */
+  void beginKernel()
+  {
+    if (isEnabled()) {
+      m_kernels.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  /*!
+   * \brief Count a capture of record in space.
+   */
+  void recordCapture(PointerRecord const* record, ExecutionSpace space)
+  {
+    if (isEnabled()) {
+      addCapture(record, space);
+    }
+  }
+
+  /*!
+   * \brief Add a move of record from source to destination.
+   */
+  CHAISHAREDDLL_API void recordMove(PointerRecord const* record,
+                                    ExecutionSpace source,
+                                    ExecutionSpace destination,
+                                    size_t bytes);
+
+  /*!
+   * \brief Mark the entry of a record that is about to be deleted as freed.
+   */
+  void forget(PointerRecord const* record)
+  {
+    if (isEnabled()) {
+      forgetRecord(record);
+    }
+  }
+
+  /*!
+   * \brief Get the entries of every array, by decreasing bytes moved.
+   */
+  CHAISHAREDDLL_API std::vector<Entry> getEntries() const;
+
+  /*!
+   * \brief Print the entries as a table, flagging the arrays that ping-pong.
+   *
+   * \param stream Where to print.
+   * \param max_entries Number of entries to print, or 0 to print all of them.
+   */
+  CHAISHAREDDLL_API void report(std::ostream& stream,
+                                size_t max_entries = 0) const;
+
+  /*!
+   * \brief Forget all entries.
+   */
+  CHAISHAREDDLL_API void clear();
+
+protected:
+  /*!
+   * \brief Construct a new ArrayStatistics.
+   *
+   * The constructor is a protected member, ensuring that it can
+   * only be called by the singleton getInstance method.
+   */
+  ArrayStatistics();
+
+private:
+  CHAISHAREDDLL_API void addCapture(PointerRecord const* record,
+                                    ExecutionSpace space);
+
+  CHAISHAREDDLL_API void forgetRecord(PointerRecord const* record);
+
+  /*!
+   * \brief Get the entry of a live record, creating it if needed.
+   */
+  Entry& entry(PointerRecord const* record);
+
+  /*!
+   * \brief Add the entry of an array that is no longer followed to the
+   *        total of its name.
+   */
+  void fold(Entry& entry);
+
+  /*!
+   * \brief Count the recent round trips of an entry and flag it.
+   */
+  void classify(Entry& entry) const;
+
+  std::atomic<bool> m_enabled;
+
+  /*!
+   * Value of CHAI_ARRAY_STATISTICS, if set.
+   */
+  std::string m_output;
+
+  std::atomic<std::uint64_t> m_kernels;
+
+  size_t m_max_round_trips;
+
+  std::uint64_t m_round_trip_kernels;
+
+  mutable std::mutex m_mutex;
+
+  /*!
+   * Entry of every live record.
+   */
+  std::unordered_map<PointerRecord const*, Entry> m_live;
+
+  /*!
+   * Totals of the freed arrays, one for each name and one for the arrays
+   * without a name.
+   */
+  std::vector<Entry> m_freed;
+
+  /*!
+   * Index in m_freed of the total of every name, the empty name standing
+   * for arrays without one.
+   */
+  std::unordered_map<std::string, size_t> m_freed_names;
+};
+
+}  // end of namespace chai
+
+#endif  // CHAI_ArrayStatistics_HPP
@@ -11,6 +11,9 @@
 
 #include "umpire/util/Macros.hpp"
 
+#include <iostream>
+#include <sstream>
+
 #if defined(CHAI_ENABLE_CUDA)
 
 #include <cuda_runtime_api.h>
@@ -68,25 +71,81 @@
 
 #define CHAI_INLINE inline
 
+#if defined(_MSC_VER)
+#define CHAI_RESTRICT __restrict
+#else
+#define CHAI_RESTRICT __restrict__
+#endif
+
 #define CHAI_UNUSED_ARG(X)
 
+/*!
+ * Severities of CHAI_LOG, from the most verbose. CHAI_LOG_LEVEL is the least
+ * severe level compiled in, and the sites below it are removed entirely,
+ * including the evaluation of their messages.
+ */
+#define CHAI_LOG_LEVEL_DEBUG 0
+#define CHAI_LOG_LEVEL_INFO 1
+#define CHAI_LOG_LEVEL_WARNING 2
+#define CHAI_LOG_LEVEL_ERROR 3
+#define CHAI_LOG_LEVEL_OFF 4
+
+#if !defined(CHAI_LOG_LEVEL)
+#if defined(CHAI_DEBUG)
+#define CHAI_LOG_LEVEL CHAI_LOG_LEVEL_DEBUG
+#elif defined(CHAI_DISABLE_RM)
+#define CHAI_LOG_LEVEL CHAI_LOG_LEVEL_OFF
+#else
+#define CHAI_LOG_LEVEL CHAI_LOG_LEVEL_WARNING
+#endif
+#endif
+
 #if !defined(CHAI_DISABLE_RM)
 
-#define CHAI_LOG(level, msg) \
-  UMPIRE_LOG(level, msg);
+// Sites that are compiled in are filtered at runtime by the umpire log level
+#define CHAI_LOG_WRITE(level, msg) \
+  do { UMPIRE_LOG(level, msg); } while (false)
 
 #else
 
-#if defined(CHAI_DEBUG)
+#define CHAI_LOG_WRITE(level, msg) \
+  do { std::cerr << "[" << __FILE__ << "] " << msg << std::endl; } while (false)
 
-#define CHAI_LOG(level, msg) \
-  std::cerr << "[" << __FILE__ << "] " << msg << std::endl;
+#endif
+
+// The message of a removed site is still compiled, so that it keeps using the
+// variables it names, but never evaluated
+#define CHAI_LOG_DISCARD(msg) \
+  do { if (false) { std::ostringstream chai_log_stream; chai_log_stream << msg; } } while (false)
 
+#if CHAI_LOG_LEVEL <= CHAI_LOG_LEVEL_DEBUG
+#define CHAI_LOG_Debug(msg) CHAI_LOG_WRITE(Debug, msg)
 #else
+#define CHAI_LOG_Debug(msg) CHAI_LOG_DISCARD(msg)
+#endif
 
-#define CHAI_LOG(level, msg)
+#if CHAI_LOG_LEVEL <= CHAI_LOG_LEVEL_INFO
+#define CHAI_LOG_Info(msg) CHAI_LOG_WRITE(Info, msg)
+#else
+#define CHAI_LOG_Info(msg) CHAI_LOG_DISCARD(msg)
+#endif
 
+#if CHAI_LOG_LEVEL <= CHAI_LOG_LEVEL_WARNING
+#define CHAI_LOG_Warning(msg) CHAI_LOG_WRITE(Warning, msg)
+#else
+#define CHAI_LOG_Warning(msg) CHAI_LOG_DISCARD(msg)
 #endif
+
+#if CHAI_LOG_LEVEL <= CHAI_LOG_LEVEL_ERROR
+#define CHAI_LOG_Error(msg) CHAI_LOG_WRITE(Error, msg)
+#else
+#define CHAI_LOG_Error(msg) CHAI_LOG_DISCARD(msg)
 #endif
 
+/*!
+ * Log msg, a chain of stream insertions, at level, which is one of Debug,
+ * Info, Warning or Error.
+ */
+#define CHAI_LOG(level, msg) CHAI_LOG_##level(msg)
+
 #endif  // CHAI_ChaiMacros_HPP
@@ -0,0 +1,113 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#include "chai/Event.hpp"
+
+#include "chai/ArrayManager.hpp"
+#include "chai/KernelQueue.hpp"
+
+namespace chai
+{
+
+Event::Event() :
+  m_queue{nullptr},
+  m_ticket{0},
+  m_space{NONE}
+{
+}
+
+Event::Event(KernelQueue* queue, std::uint64_t ticket, ExecutionSpace space) :
+  m_queue{queue},
+  m_ticket{ticket},
+  m_space{space}
+{
+}
+
+Event::Event(camp::resources::Event const& event, ExecutionSpace space) :
+  m_queue{nullptr},
+  m_ticket{0},
+  m_space{space},
+  m_resource_event{std::make_shared<camp::resources::Event>(event)}
+{
+}
+
+#if defined(CHAI_ENABLE_CUDA)
+Event Event::recordDevice()
+{
+  cudaEvent_t event;
+  CHAI_GPU_ERROR_CHECK(cudaEventCreateWithFlags(&event, cudaEventDisableTiming));
+  CHAI_GPU_ERROR_CHECK(cudaEventRecord(event));
+
+  Event result;
+  result.m_space = GPU;
+  result.m_device_event = std::shared_ptr<void>(event, [] (void* e) {
+    cudaEventDestroy(static_cast<cudaEvent_t>(e));
+  });
+
+  return result;
+}
+#elif defined(CHAI_ENABLE_HIP)
+Event Event::recordDevice()
+{
+  hipEvent_t event;
+  CHAI_GPU_ERROR_CHECK(hipEventCreateWithFlags(&event, hipEventDisableTiming));
+  CHAI_GPU_ERROR_CHECK(hipEventRecord(event));
+
+  Event result;
+  result.m_space = GPU;
+  result.m_device_event = std::shared_ptr<void>(event, [] (void* e) {
+    hipEventDestroy(static_cast<hipEvent_t>(e));
+  });
+
+  return result;
+}
+#endif
+
+bool Event::isComplete() const
+{
+#if defined(CHAI_ENABLE_CUDA)
+  if (m_device_event) {
+    return cudaEventQuery(static_cast<cudaEvent_t>(m_device_event.get())) !=
+           cudaErrorNotReady;
+  }
+#elif defined(CHAI_ENABLE_HIP)
+  if (m_device_event) {
+    return hipEventQuery(static_cast<hipEvent_t>(m_device_event.get())) !=
+           hipErrorNotReady;
+  }
+#endif
+
+  if (m_resource_event) {
+    return m_resource_event->check();
+  }
+
+  return !m_queue || m_queue->isComplete(m_ticket);
+}
+
+void Event::wait() const
+{
+#if defined(CHAI_ENABLE_CUDA)
+  if (m_device_event) {
+    CHAI_GPU_ERROR_CHECK(
+        cudaEventSynchronize(static_cast<cudaEvent_t>(m_device_event.get())));
+  }
+#elif defined(CHAI_ENABLE_HIP)
+  if (m_device_event) {
+    CHAI_GPU_ERROR_CHECK(
+        hipEventSynchronize(static_cast<hipEvent_t>(m_device_event.get())));
+  }
+#endif
+
+  if (m_resource_event) {
+    m_resource_event->wait();
+  }
+
+  if (m_queue) {
+    m_queue->wait(m_ticket);
+  }
+}
+
+}  // end of namespace chai
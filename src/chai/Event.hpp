@@ -0,0 +1,119 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#ifndef CHAI_Event_HPP
+#define CHAI_Event_HPP
+
+#include "chai/config.hpp"
+#include "chai/ExecutionSpaces.hpp"
+#include "chai/Types.hpp"
+
+#include "camp/resource.hpp"
+
+#include <cstdint>
+#include <memory>
+
+namespace chai
+{
+
+class KernelQueue;
+
+/*!
+ * \brief Handle on the completion of an asynchronous kernel.
+ *
+ * Asynchronous forall policies return an Event for the kernel they launched.
+ * A kernel run by a KernelQueue is identified by the queue and its ticket,
+ * which takes no allocation. On CUDA and HIP, device kernels are followed by
+ * an event recorded on the default stream, and kernels launched on a camp
+ * resource are followed by an event of the resource. Those events are shared
+ * by the copies of the Event through std::shared_ptr, so copying an Event
+ * updates reference counts atomically.
+ *
+ * A default-constructed Event is complete.
+ */
+class Event
+{
+public:
+  /*!
+   * \brief Create a complete Event.
+   */
+  CHAISHAREDDLL_API Event();
+
+  /*!
+   * \brief Create an Event for a kernel launched on a KernelQueue.
+   *
+   * \param queue The queue the kernel was launched on.
+   * \param ticket The ticket returned by KernelQueue::launch.
+   * \param space The execution space the kernel runs in.
+   */
+  CHAISHAREDDLL_API Event(KernelQueue* queue,
+                          std::uint64_t ticket,
+                          ExecutionSpace space);
+
+  /*!
+   * \brief Create an Event for a kernel launched on a camp resource.
+   *
+   * \param event Event recorded on the resource after the kernel.
+   * \param space The execution space the kernel runs in.
+   */
+  CHAISHAREDDLL_API Event(camp::resources::Event const& event,
+                          ExecutionSpace space);
+
+#if defined(CHAI_ENABLE_CUDA) || defined(CHAI_ENABLE_HIP)
+  /*!
+   * \brief Record an Event after the work launched so far on the default
+   *        stream of the device.
+   */
+  CHAISHAREDDLL_API static Event recordDevice();
+#endif
+
+  /*!
+   * \brief Whether the kernel has completed.
+   */
+  CHAISHAREDDLL_API bool isComplete() const;
+
+  /*!
+   * \brief Wait for the kernel to complete.
+   */
+  CHAISHAREDDLL_API void wait() const;
+
+  /*!
+   * \brief Get the execution space the kernel runs in.
+   */
+  ExecutionSpace getSpace() const { return m_space; }
+
+  /*!
+   * \brief Get the event of the resource the kernel was launched on, or null
+   *        if it was not launched on a resource.
+   */
+  camp::resources::Event* getResourceEvent() const
+  {
+    return m_resource_event.get();
+  }
+
+private:
+  KernelQueue* m_queue;
+
+  std::uint64_t m_ticket;
+
+  ExecutionSpace m_space;
+
+  /*!
+   * Event of the resource, shared by the copies of the Event.
+   */
+  std::shared_ptr<camp::resources::Event> m_resource_event;
+
+#if defined(CHAI_ENABLE_CUDA) || defined(CHAI_ENABLE_HIP)
+  /*!
+   * Device event, destroyed with the last copy of the Event.
+   */
+  std::shared_ptr<void> m_device_event;
+#endif
+};
+
+}  // end of namespace chai
+
+#endif  // CHAI_Event_HPP
@@ -0,0 +1,24 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#include "chai/Instrumentation.hpp"
+
+namespace chai
+{
+
+std::atomic<unsigned> Instrumentation::s_enabled{0};
+
+void Instrumentation::setEnabled(Instrument instrument, bool enabled)
+{
+  if (enabled) {
+    s_enabled.fetch_or(instrument, std::memory_order_relaxed);
+  } else {
+    s_enabled.fetch_and(~static_cast<unsigned>(instrument),
+                        std::memory_order_relaxed);
+  }
+}
+
+}  // end of namespace chai
@@ -0,0 +1,62 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#ifndef CHAI_Instrumentation_HPP
+#define CHAI_Instrumentation_HPP
+
+#include "chai/config.hpp"
+#include "chai/Types.hpp"
+
+#include <atomic>
+
+namespace chai
+{
+
+/*!
+ * \brief The tools that observe the ArrayManager.
+ */
+enum Instrument : unsigned {
+  INSTRUMENT_TRACER = 1u << 0,
+  INSTRUMENT_ARRAY_STATISTICS = 1u << 1,
+  INSTRUMENT_METRICS = 1u << 2,
+  INSTRUMENT_REGION_STATISTICS = 1u << 3,
+  INSTRUMENT_OPERATION_RECORDER = 1u << 4,
+  INSTRUMENT_TRANSFER_CHECKER = 1u << 5,
+  INSTRUMENT_ALLOCATION_PROFILER = 1u << 6,
+  INSTRUMENT_KERNEL_STATISTICS = 1u << 7,
+  INSTRUMENT_TAG_STATISTICS = 1u << 8
+};
+
+/*!
+ * \brief Which instruments are turned on.
+ *
+ * Every instrument reports here when it is turned on or off, so that the
+ * ArrayManager skips all of them on its hot paths with a single check when
+ * none is on.
+ */
+class Instrumentation
+{
+public:
+  /*!
+   * \brief Whether any instrument is on.
+   */
+  static bool isEnabled()
+  {
+    return s_enabled.load(std::memory_order_relaxed) != 0;
+  }
+
+  /*!
+   * \brief Turn instrument on or off.
+   */
+  CHAISHAREDDLL_API static void setEnabled(Instrument instrument, bool enabled);
+
+private:
+  CHAISHAREDDLL_API static std::atomic<unsigned> s_enabled;
+};
+
+}  // end of namespace chai
+
+#endif  // CHAI_Instrumentation_HPP
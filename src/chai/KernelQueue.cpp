@@ -0,0 +1,128 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#include "chai/KernelQueue.hpp"
+
+#include "chai/ArrayManager.hpp"
+#include "chai/ThreadPool.hpp"
+
+namespace chai
+{
+
+KernelQueue* KernelQueue::getHostInstance()
+{
+  static KernelQueue s_host_queue_instance;
+  return &s_host_queue_instance;
+}
+
+KernelQueue::KernelQueue() :
+  m_thread{},
+  m_kernels{},
+  m_num_launched{0},
+  m_num_completed{0},
+  m_stop{false}
+{
+  // Kernels run on the ThreadPool, so it must outlive the queue.
+  ThreadPool::getInstance();
+
+  m_thread = std::thread(&KernelQueue::run, this);
+}
+
+KernelQueue::~KernelQueue()
+{
+  synchronize();
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_launched.notify_one();
+
+  m_thread.join();
+}
+
+std::uint64_t KernelQueue::launch(Kernel kernel)
+{
+  std::uint64_t ticket = 0;
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_kernels.push_back(std::move(kernel));
+    ticket = ++m_num_launched;
+  }
+
+  m_launched.notify_one();
+
+  return ticket;
+}
+
+void KernelQueue::wait(std::uint64_t ticket)
+{
+  if (isComplete(ticket)) {
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_completed_kernel.wait(lock, [=] { return isComplete(ticket); });
+}
+
+bool KernelQueue::isComplete(std::uint64_t ticket) const
+{
+  return m_num_completed.load(std::memory_order_acquire) >= ticket;
+}
+
+void KernelQueue::synchronize()
+{
+  std::uint64_t ticket = 0;
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ticket = m_num_launched;
+  }
+
+  wait(ticket);
+}
+
+bool KernelQueue::busy()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_num_completed.load() < m_num_launched;
+}
+
+void KernelQueue::run()
+{
+  ArrayManager::setKernelThread(true);
+
+  while (true) {
+    Kernel kernel;
+
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_launched.wait(lock, [this] { return m_stop || !m_kernels.empty(); });
+
+      if (m_kernels.empty()) {
+        return;
+      }
+
+      kernel = std::move(m_kernels.front());
+      m_kernels.pop_front();
+    }
+
+    kernel();
+
+    // Release whatever the kernel captured before reporting completion
+    kernel = nullptr;
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_num_completed.fetch_add(1, std::memory_order_release);
+    }
+
+    m_completed_kernel.notify_all();
+  }
+}
+
+}  // end of namespace chai
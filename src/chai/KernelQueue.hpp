@@ -0,0 +1,106 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#ifndef CHAI_KernelQueue_HPP
+#define CHAI_KernelQueue_HPP
+
+#include "chai/config.hpp"
+#include "chai/Types.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace chai
+{
+
+/*!
+ * \brief In-order queue of kernels run by a dedicated thread.
+ *
+ * launch returns immediately with a ticket numbering the kernel. Kernels run
+ * one after the other in launch order, so a kernel has completed once the
+ * number of completed kernels has reached its ticket.
+ */
+class KernelQueue
+{
+public:
+  using Kernel = std::function<void()>;
+
+  /*!
+   * \brief Get the queue running asynchronous host kernels.
+   *
+   * \return Pointer to the host KernelQueue instance.
+   */
+  CHAISHAREDDLL_API static KernelQueue* getHostInstance();
+
+  CHAISHAREDDLL_API KernelQueue();
+
+  /*!
+   * \brief Wait for every launched kernel, then stop the thread.
+   */
+  CHAISHAREDDLL_API virtual ~KernelQueue();
+
+  /*!
+   * \brief Queue a kernel for execution.
+   *
+   * \param kernel The kernel to run.
+   *
+   * \return Ticket of the kernel, to pass to wait and isComplete.
+   */
+  CHAISHAREDDLL_API std::uint64_t launch(Kernel kernel);
+
+  /*!
+   * \brief Wait for the kernel with the given ticket to complete.
+   */
+  CHAISHAREDDLL_API void wait(std::uint64_t ticket);
+
+  /*!
+   * \brief Whether the kernel with the given ticket has completed.
+   */
+  CHAISHAREDDLL_API bool isComplete(std::uint64_t ticket) const;
+
+  /*!
+   * \brief Wait for all launched kernels to complete.
+   */
+  CHAISHAREDDLL_API void synchronize();
+
+  /*!
+   * \brief Whether any launched kernel has not completed yet.
+   */
+  CHAISHAREDDLL_API bool busy();
+
+private:
+  void run();
+
+  std::thread m_thread;
+
+  std::mutex m_mutex;
+  std::condition_variable m_launched;
+  std::condition_variable m_completed_kernel;
+
+  std::deque<Kernel> m_kernels;
+
+  /*!
+   * Number of kernels launched, and ticket of the last one.
+   */
+  std::uint64_t m_num_launched;
+
+  /*!
+   * Number of kernels completed. Written under m_mutex, but read without it
+   * by isComplete.
+   */
+  std::atomic<std::uint64_t> m_num_completed;
+
+  bool m_stop;
+};
+
+}  // end of namespace chai
+
+#endif  // CHAI_KernelQueue_HPP
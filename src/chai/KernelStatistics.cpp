@@ -0,0 +1,283 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#include "chai/KernelStatistics.hpp"
+
+#include "chai/Instrumentation.hpp"
+#include "chai/RegionStatistics.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace chai
+{
+
+namespace {
+
+const char* const s_outside_kernels = "(outside kernels)";
+
+std::string defaultKernelName(ExecutionSpace space)
+{
+  switch (space) {
+    case CPU:
+      return "CPU kernel";
+    case GPU:
+      return "GPU kernel";
+    case UM:
+      return "UM kernel";
+    case PINNED:
+      return "PINNED kernel";
+    default:
+      return "kernel";
+  }
+}
+
+}  // end of anonymous namespace
+
+KernelStatistics* KernelStatistics::getInstance()
+{
+  static KernelStatistics s_kernel_statistics_instance;
+  return &s_kernel_statistics_instance;
+}
+
+KernelStatistics::KernelStatistics() :
+  m_enabled{false},
+  m_output{},
+  m_entries{},
+  m_kernel_name{},
+  m_named{false},
+  m_current{nullptr},
+  m_capturing{false},
+  m_kernel_start{}
+{
+  // Entries point to regions, so the regions must outlive the KernelStatistics.
+  RegionStatistics::getInstance();
+
+  const char* env = std::getenv("CHAI_KERNEL_STATISTICS");
+  if (env && *env) {
+    m_output = env;
+    setEnabled(true);
+  }
+}
+
+KernelStatistics::~KernelStatistics()
+{
+  if (m_output.empty()) {
+    return;
+  }
+
+  if (m_output == "1") {
+    report(std::cerr);
+  } else {
+    std::ofstream file(m_output);
+    report(file);
+  }
+}
+
+void KernelStatistics::setEnabled(bool enabled)
+{
+  m_enabled = enabled;
+  Instrumentation::setEnabled(INSTRUMENT_KERNEL_STATISTICS, enabled);
+}
+
+void KernelStatistics::setKernelName(std::string const& name)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_kernel_name = name;
+  m_named = !name.empty();
+}
+
+std::string KernelStatistics::getNextKernelName() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_kernel_name;
+}
+
+std::string KernelStatistics::getKernelName(ExecutionSpace space) const
+{
+  if (space == NONE) {
+    return s_outside_kernels;
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_kernel_name.empty() ? defaultKernelName(space) : m_kernel_name;
+}
+
+void KernelStatistics::beginKernel(ExecutionSpace space)
+{
+  if (!isEnabled()) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  if (m_current && m_capturing) {
+    m_current->capture_seconds +=
+        std::chrono::duration<double>(Clock::now() - m_kernel_start).count();
+  }
+
+  const std::string name =
+      m_kernel_name.empty() ? defaultKernelName(space) : m_kernel_name;
+
+  Entry& launched = entry(name);
+  ++launched.launches;
+
+  m_current = &launched;
+  m_capturing = true;
+  m_kernel_start = Clock::now();
+}
+
+void KernelStatistics::endCaptures()
+{
+  if (!isEnabled()) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  if (m_current && m_capturing) {
+    m_current->capture_seconds +=
+        std::chrono::duration<double>(Clock::now() - m_kernel_start).count();
+  }
+
+  m_capturing = false;
+}
+
+void KernelStatistics::endKernel()
+{
+  // The name is forgotten whether or not collection is on, since the
+  // TransferChecker names kernels too
+  if (!isEnabled() && !m_named.load(std::memory_order_relaxed)) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  m_kernel_name.clear();
+  m_named = false;
+
+  if (m_current && m_capturing) {
+    m_current->capture_seconds +=
+        std::chrono::duration<double>(Clock::now() - m_kernel_start).count();
+  }
+
+  m_current = nullptr;
+  m_capturing = false;
+}
+
+void KernelStatistics::recordMove(size_t size)
+{
+  if (!isEnabled()) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  Entry& entry = current();
+  ++entry.moves;
+  entry.bytes_moved += size;
+}
+
+void KernelStatistics::recordAllocation(size_t size)
+{
+  if (!isEnabled()) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  Entry& entry = current();
+  ++entry.allocations;
+  entry.bytes_allocated += size;
+}
+
+std::vector<KernelStatistics::Entry> KernelStatistics::getEntries() const
+{
+  std::vector<Entry> entries;
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto const& entry : m_entries) {
+      entries.push_back(entry.second);
+      entries.back().region = entry.first.first->getPath();
+    }
+  }
+
+  std::sort(entries.begin(), entries.end(), [] (Entry const& a, Entry const& b) {
+    if (a.bytes_moved != b.bytes_moved) {
+      return a.bytes_moved > b.bytes_moved;
+    }
+    return a.name != b.name ? a.name < b.name : a.region < b.region;
+  });
+
+  return entries;
+}
+
+void KernelStatistics::report(std::ostream& stream) const
+{
+  const std::vector<Entry> entries = getEntries();
+
+  std::vector<std::string> names;
+  size_t name_width = 6;
+  for (auto const& entry : entries) {
+    names.push_back(entry.region.empty()
+                        ? entry.name
+                        : entry.name + " [" + entry.region + "]");
+    name_width = std::max(name_width, names.back().size());
+  }
+
+  stream << std::left << std::setw(name_width) << "kernel" << std::right
+         << std::setw(10) << "launches"
+         << std::setw(10) << "moves"
+         << std::setw(16) << "bytes moved"
+         << std::setw(8) << "allocs"
+         << std::setw(16) << "bytes allocated"
+         << std::setw(14) << "capture (ms)" << "\n";
+
+  for (size_t i = 0; i < entries.size(); ++i) {
+    Entry const& entry = entries[i];
+
+    stream << std::left << std::setw(name_width) << names[i] << std::right
+           << std::setw(10) << entry.launches
+           << std::setw(10) << entry.moves
+           << std::setw(16) << entry.bytes_moved
+           << std::setw(8) << entry.allocations
+           << std::setw(16) << entry.bytes_allocated
+           << std::setw(14) << std::fixed << std::setprecision(3)
+           << entry.capture_seconds * 1.0e3 << "\n";
+  }
+}
+
+void KernelStatistics::clear()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_entries.clear();
+  m_current = nullptr;
+  m_capturing = false;
+}
+
+KernelStatistics::Entry& KernelStatistics::current()
+{
+  if (m_current) {
+    return *m_current;
+  }
+
+  return entry(s_outside_kernels);
+}
+
+KernelStatistics::Entry& KernelStatistics::entry(std::string const& name)
+{
+  Entry& found = m_entries[Key(RegionStatistics::current(), name)];
+  if (found.name.empty()) {
+    found.name = name;
+  }
+  return found;
+}
+
+}  // end of namespace chai
@@ -0,0 +1,223 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#ifndef CHAI_KernelStatistics_HPP
+#define CHAI_KernelStatistics_HPP
+
+#include "chai/config.hpp"
+#include "chai/ExecutionSpaces.hpp"
+#include "chai/Types.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <iosfwd>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace chai
+{
+
+class Region;
+
+/*!
+ * \brief Singleton attributing data movement to the kernels that caused it.
+ *
+ * The ArrayManager opens a kernel scope whenever the execution space is set
+ * to a space other than NONE, which the forall policies and the RAJA plugin
+ * do around every capture, and closes it when the space is set back to NONE.
+ * The moves and allocations made while a scope is open, and the time spent
+ * in it, are added to the entry for the kernel's name. The next kernel is
+ * named with setKernelName, and otherwise kernels are named after the space
+ * they run in. A kernel launched in several regions has an entry for each
+ * region.
+ *
+ * Collection is off by default. Setting the CHAI_KERNEL_STATISTICS
+ * environment variable turns it on, and prints the table at shutdown: to
+ * standard error if the variable is 1, and to the file it names otherwise.
+ */
+class KernelStatistics
+{
+public:
+  /*!
+   * \brief Totals for all the launches of one kernel.
+   */
+  struct Entry {
+    std::string name;
+
+    /*!
+     * Path of the region the kernel was launched in, or an empty string
+     * outside regions.
+     */
+    std::string region;
+
+    size_t launches = 0;
+    size_t moves = 0;
+    size_t bytes_moved = 0;
+    size_t allocations = 0;
+    size_t bytes_allocated = 0;
+    double capture_seconds = 0.0;
+  };
+
+  /*!
+   * \brief Get the singleton instance.
+   *
+   * \return Pointer to the KernelStatistics instance.
+   */
+  CHAISHAREDDLL_API static KernelStatistics* getInstance();
+
+  /*!
+   * \brief Print the table if CHAI_KERNEL_STATISTICS is set.
+   */
+  ~KernelStatistics();
+
+  /*!
+   * \brief Turn collection on or off.
+   */
+  CHAISHAREDDLL_API void setEnabled(bool enabled);
+
+  /*!
+   * \brief Whether collection is on.
+   */
+  bool isEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+  /*!
+   * \brief Name the next kernel launched.
+   *
+   * The name is forgotten when the kernel's scope closes, so the kernels
+   * after it are named after their execution space again.
+   *
+   * \param name Name of the next kernel, or an empty string to name it after
+   *        its execution space.
+   */
+  CHAISHAREDDLL_API void setKernelName(std::string const& name);
+
+  /*!
+   * \brief Get the name set for the next kernel, or an empty string if none
+   *        was set.
+   */
+  CHAISHAREDDLL_API std::string getNextKernelName() const;
+
+  /*!
+   * \brief Get the name of a kernel launched now in space.
+   *
+   * \param space The execution space of the kernel, or NONE outside kernels.
+   */
+  CHAISHAREDDLL_API std::string getKernelName(ExecutionSpace space) const;
+
+  /*!
+   * \brief Open the scope of a kernel running in space.
+   */
+  CHAISHAREDDLL_API void beginKernel(ExecutionSpace space);
+
+  /*!
+   * \brief Stop timing the captures of the current kernel, whose body is
+   *        about to run.
+   *
+   * Moves and allocations made by the body are still attributed to the
+   * kernel until its scope closes.
+   */
+  CHAISHAREDDLL_API void endCaptures();
+
+  /*!
+   * \brief Close the scope of the current kernel.
+   */
+  CHAISHAREDDLL_API void endKernel();
+
+  /*!
+   * \brief Attribute a move of size bytes to the current kernel.
+   */
+  CHAISHAREDDLL_API void recordMove(size_t size);
+
+  /*!
+   * \brief Attribute an allocation of size bytes to the current kernel.
+   */
+  CHAISHAREDDLL_API void recordAllocation(size_t size);
+
+  /*!
+   * \brief Get the entries of every kernel, by decreasing bytes moved.
+   *
+   * Moves and allocations made outside of any kernel are reported under the
+   * name "(outside kernels)".
+   */
+  CHAISHAREDDLL_API std::vector<Entry> getEntries() const;
+
+  /*!
+   * \brief Print the entries as a table.
+   */
+  CHAISHAREDDLL_API void report(std::ostream& stream) const;
+
+  /*!
+   * \brief Forget all entries.
+   */
+  CHAISHAREDDLL_API void clear();
+
+protected:
+  /*!
+   * \brief Construct a new KernelStatistics.
+   *
+   * The constructor is a protected member, ensuring that it can
+   * only be called by the singleton getInstance method.
+   */
+  KernelStatistics();
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  /*!
+   * Entries are keyed by region and kernel name, so that finding the entry of
+   * a launch does not format the path of its region.
+   */
+  using Key = std::pair<Region const*, std::string>;
+
+  /*!
+   * \brief Entry that moves and allocations are currently attributed to.
+   */
+  Entry& current();
+
+  /*!
+   * \brief Get the entry of the kernel name in the current region.
+   */
+  Entry& entry(std::string const& name);
+
+  std::atomic<bool> m_enabled;
+
+  /*!
+   * Value of CHAI_KERNEL_STATISTICS, if set.
+   */
+  std::string m_output;
+
+  mutable std::mutex m_mutex;
+
+  std::map<Key, Entry> m_entries;
+
+  std::string m_kernel_name;
+
+  /*!
+   * Whether m_kernel_name is set, so that closing a kernel scope only takes
+   * the lock when there is a name to forget.
+   */
+  std::atomic<bool> m_named;
+
+  /*!
+   * Entry of the open kernel scope, or null outside kernels.
+   */
+  Entry* m_current;
+
+  /*!
+   * Whether the captures of the open kernel scope are still being timed.
+   */
+  bool m_capturing;
+
+  Clock::time_point m_kernel_start;
+};
+
+}  // end of namespace chai
+
+#endif  // CHAI_KernelStatistics_HPP
@@ -11,6 +11,7 @@
 
 #include "chai/ArrayManager.hpp"
 #include "chai/ChaiMacros.hpp"
+#include "chai/Simd.hpp"
 #include "chai/Types.hpp"
 
 #include "umpire/Allocator.hpp"
@@ -98,6 +99,19 @@ public:
    */
   CHAI_HOST_DEVICE ManagedArray(size_t elems, ExecutionSpace space = get_default_space());
 
+  /*!
+   * \brief Constructor to create a named ManagedArray with specified size,
+   * allocated in the provided space.
+   *
+   * \param elems Number of elements in the array.
+   * \param space Execution space in which to allocate the array.
+   * \param name Name with static storage, such as a string literal. Tags
+   *        separated by slashes group arrays in the TagStatistics.
+   */
+  CHAI_HOST_DEVICE ManagedArray(size_t elems,
+                                ExecutionSpace space,
+                                const char* name);
+
   CHAI_HOST_DEVICE ManagedArray(
       size_t elems,
       std::initializer_list<chai::ExecutionSpace> spaces,
@@ -129,11 +143,26 @@ public:
    * \param elems Number of elements to allocate.
    * \param space Execution space in which to allocate data.
    * \param cback User defined callback for memory events (alloc, free, move)
+   * \param name Name of the array, or null to keep its current name.
    */
   CHAI_HOST void allocate(size_t elems,
                           ExecutionSpace space = CPU,
                           UserCallback const& cback =
-                          [] (const PointerRecord*, Action, ExecutionSpace) {});
+                          [] (const PointerRecord*, Action, ExecutionSpace) {},
+                          const char* name = nullptr);
+
+  /*!
+   * \brief Name the array.
+   *
+   * \param name Name with static storage, such as a string literal, or null
+   *        to remove the name.
+   */
+  CHAI_HOST void setName(const char* name);
+
+  /*!
+   * \brief Get the name of the array, or null if it has none.
+   */
+  CHAI_HOST const char* getName() const;
 
 
 
@@ -188,6 +217,29 @@ public:
   template <typename Idx>
   CHAI_HOST_DEVICE T& operator[](const Idx i) const;
 
+  /*!
+   * \brief Return the elements of a batch of a simd loop.
+   *
+   * \param i Batch to load.
+   */
+  CHAI_HOST_DEVICE Pack<T_non_const> load(SimdIndex i) const
+  {
+    return loadPack<T>(m_active_pointer, i);
+  }
+
+  /*!
+   * \brief Set the elements of a batch of a simd loop.
+   *
+   * Only the lanes of the batch that are inside the loop are stored.
+   *
+   * \param i Batch to store.
+   * \param values Values of the lanes.
+   */
+  CHAI_HOST_DEVICE void store(SimdIndex i, Pack<T_non_const> const& values) const
+  {
+    storePack<T>(m_active_pointer, i, values);
+  }
+
   /*!
    * \brief get access to m_active_pointer
    * @return a copy of m_active_base_pointer
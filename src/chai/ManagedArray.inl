@@ -58,6 +58,21 @@ CHAI_HOST_DEVICE ManagedArray<T>::ManagedArray(
 #endif
 }
 
+template<typename T>
+CHAI_INLINE
+CHAI_HOST_DEVICE ManagedArray<T>::ManagedArray(
+    size_t elems,
+    ExecutionSpace space,
+    const char* name) :
+  ManagedArray()
+{
+#if !defined(CHAI_DEVICE_COMPILE)
+  this->allocate(elems, space,
+                 [] (const PointerRecord*, Action, ExecutionSpace) {},
+                 name);
+#endif
+}
+
 template<typename T>
 CHAI_INLINE
 CHAI_HOST_DEVICE ManagedArray<T>::ManagedArray(
@@ -114,7 +129,13 @@ CHAI_HOST_DEVICE ManagedArray<T>::ManagedArray(ManagedArray const& other):
      if (m_pointer_record && !m_is_slice) {
         m_elems = m_pointer_record->m_size/sizeof(T);
      }
-     move(m_resource_manager->getExecutionSpace());
+
+     // Copies made outside of a capture, including those made by kernel
+     // bodies on the threads running them, have nothing to move
+     const ExecutionSpace space = m_resource_manager->getExecutionSpace();
+     if (space != NONE) {
+        move(space);
+     }
   }
 #endif
 }
@@ -146,7 +167,8 @@ template<typename T>
 CHAI_HOST void ManagedArray<T>::allocate(
     size_t elems,
     ExecutionSpace space, 
-    const UserCallback& cback) 
+    const UserCallback& cback,
+    const char* name)
 {
   if(!m_is_slice) {
      if (elems > 0) {
@@ -161,6 +183,11 @@ CHAI_HOST void ManagedArray<T>::allocate(
          }
        }
 
+       // Named before the allocation, so that it is accounted to the name
+       if (name) {
+         m_resource_manager->setName(m_pointer_record, name);
+       }
+
        m_pointer_record->m_user_callback = cback;
        m_elems = elems;
        m_pointer_record->m_size = sizeof(T)*elems;
@@ -207,6 +234,20 @@ CHAI_HOST void ManagedArray<T>::allocate(
 
 
 
+template<typename T>
+CHAI_INLINE
+CHAI_HOST void ManagedArray<T>::setName(const char* name)
+{
+  m_resource_manager->setName(m_pointer_record, name);
+}
+
+template<typename T>
+CHAI_INLINE
+CHAI_HOST const char* ManagedArray<T>::getName() const
+{
+  return m_pointer_record ? m_pointer_record->m_name : nullptr;
+}
+
 template<typename T>
 CHAI_INLINE
 CHAI_HOST void ManagedArray<T>::reallocate(size_t elems)
@@ -305,6 +346,7 @@ CHAI_INLINE
 CHAI_HOST_DEVICE
 typename ManagedArray<T>::T_non_const ManagedArray<T>::pick(size_t i) const { 
   #if !defined(CHAI_DEVICE_COMPILE)
+    m_resource_manager->waitForEvent(m_pointer_record);
     #if defined(CHAI_ENABLE_UM)
       if(m_pointer_record->m_pointers[UM] == m_active_base_pointer) {
         synchronize();
@@ -328,6 +370,7 @@ template<typename T>
 CHAI_INLINE
 CHAI_HOST_DEVICE void ManagedArray<T>::set(size_t i, T val) const { 
   #if !defined(CHAI_DEVICE_COMPILE)
+    m_resource_manager->waitForEvent(m_pointer_record);
     #if defined(CHAI_ENABLE_UM)
       if(m_pointer_record->m_pointers[UM] == m_active_pointer) {
         synchronize();
@@ -340,7 +383,8 @@ CHAI_HOST_DEVICE void ManagedArray<T>::set(size_t i, T val) const {
        m_pointer_record->m_last_space = CPU;
     }
 
-    m_pointer_record->m_touched[m_pointer_record->m_last_space] = true;
+    m_resource_manager->registerTouch(m_pointer_record,
+                                      m_pointer_record->m_last_space);
     m_resource_manager->set(static_cast<T*>((void*)((char*)m_pointer_record->m_pointers[m_pointer_record->m_last_space]+sizeof(T)*m_offset)), i, val);
   #else
     m_active_pointer[i] = val; 
@@ -389,6 +433,14 @@ CHAI_HOST
 void ManagedArray<T>::move(ExecutionSpace space, bool registerTouch) const
 {
   if (m_pointer_record != &ArrayManager::s_null_record) {
+     // Nested arrays are captured by moveInnerImpl, so they are never cached
+     if (!std::is_base_of<CHAICopyable, T>::value &&
+         m_resource_manager->captureCached(m_pointer_record, space, registerTouch)) {
+        m_active_base_pointer = static_cast<T*>(m_pointer_record->m_pointers[space]);
+        m_active_pointer = m_active_base_pointer + m_offset;
+        return;
+     }
+
      ExecutionSpace prev_space = m_pointer_record->m_last_space;
      if (prev_space == CPU || prev_space == NONE) {
         /// Move nested ManagedArrays first, so they are working with a valid m_active_pointer for the host,
@@ -483,7 +535,7 @@ T* ManagedArray<T>::data() const {
 #if !defined(CHAI_DEVICE_COMPILE)
   if (m_active_pointer) {
      if (m_pointer_record == nullptr || m_pointer_record == &ArrayManager::s_null_record) {
-        CHAI_LOG(Warning, "nullptr pointer_record associated with non-nullptr active_pointer")
+        CHAI_LOG(Warning, "nullptr pointer_record associated with non-nullptr active_pointer");
      }
 
      move(CPU);
@@ -506,7 +558,7 @@ const T* ManagedArray<T>::cdata() const {
 #if !defined(CHAI_DEVICE_COMPILE)
   if (m_active_pointer) {
      if (m_pointer_record == nullptr || m_pointer_record == &ArrayManager::s_null_record) {
-        CHAI_LOG(Warning, "nullptr pointer_record associated with non-nullptr active_pointer")
+        CHAI_LOG(Warning, "nullptr pointer_record associated with non-nullptr active_pointer");
      }
 
      move(CPU, false);
@@ -12,9 +12,15 @@
 #if defined(CHAI_ENABLE_RAJA_PLUGIN)
 
 #include "chai/ManagedArray.hpp"
+#if !defined(CHAI_DISABLE_RM)
+#include "chai/PointerTable.hpp"
+#endif
 
 #include "RAJA/util/View.hpp"
 
+#include <type_traits>
+#include <utility>
+
 namespace chai {
 
   template <typename ValueType, typename LayoutType>
@@ -36,6 +42,133 @@ using ManagedArrayMultiView =
                     chai::ManagedArray<ValueType> *,
                     chai::ManagedArray<camp::type::cv::rem<ValueType>> *>;
 
+#if !defined(CHAI_DISABLE_RM)
+/*!
+ * \brief MultiView of a set of ManagedArrays that moves them as one batch.
+ *
+ * Unlike ManagedArrayMultiView, the view indexes a PointerTable of its
+ * arrays instead of the arrays themselves, so copying it into a kernel moves
+ * all of the arrays to the execution space as one batch and hands the kernel
+ * the table of their pointers there.
+ *
+ * The view does not own its arrays. Copies of the view share its table,
+ * which is released along with the last copy made on the host.
+ */
+template <typename ValueType, typename LayoutType, RAJA::Index_type P2Pidx = 0>
+class ManagedArrayBatchMultiView
+    : public RAJA::MultiView<ValueType,
+                             LayoutType,
+                             P2Pidx,
+                             ValueType **,
+                             camp::type::cv::rem<ValueType> **>
+{
+  using Base = RAJA::MultiView<ValueType,
+                               LayoutType,
+                               P2Pidx,
+                               ValueType **,
+                               camp::type::cv::rem<ValueType> **>;
+
+public:
+  /*!
+   * \brief Create a view of num_arrays arrays with the given layout.
+   */
+  CHAI_HOST ManagedArrayBatchMultiView(ManagedArray<ValueType> const* arrays,
+                                       size_t num_arrays,
+                                       LayoutType layout) :
+    Base(nullptr, std::move(layout)),
+    m_table(new PointerTable(arrays, num_arrays))
+  {
+    m_table->retain();
+    this->data = toData(m_table->get(CPU));
+  }
+
+  /*!
+   * \brief Create a view of an array of arrays with the given layout.
+   */
+  template <size_t N>
+  CHAI_HOST ManagedArrayBatchMultiView(ManagedArray<ValueType> (&arrays)[N],
+                                       LayoutType layout) :
+    ManagedArrayBatchMultiView(arrays, N, std::move(layout))
+  {
+  }
+
+  /*!
+   * \brief Copy a view, capturing its arrays in the current execution space.
+   */
+  CHAI_HOST_DEVICE ManagedArrayBatchMultiView(
+      ManagedArrayBatchMultiView const& other) :
+    Base(other),
+    m_table(other.m_table)
+  {
+#if !defined(CHAI_DEVICE_COMPILE)
+    if (m_table) {
+      m_table->retain();
+
+      const ExecutionSpace space =
+          ArrayManager::getInstance()->getExecutionSpace();
+
+      if (space != NONE) {
+        this->data =
+            toData(m_table->capture(space, !std::is_const<ValueType>::value));
+      }
+    }
+#endif
+  }
+
+  /*!
+   * \brief Make this view share the table of other.
+   */
+  CHAI_HOST ManagedArrayBatchMultiView& operator=(
+      ManagedArrayBatchMultiView const& other)
+  {
+    if (other.m_table) {
+      other.m_table->retain();
+    }
+
+    if (m_table) {
+      m_table->release();
+    }
+
+    Base::operator=(other);
+    m_table = other.m_table;
+
+    return *this;
+  }
+
+  /*!
+   * \brief Drop this view's reference to the table.
+   */
+  CHAI_HOST_DEVICE ~ManagedArrayBatchMultiView()
+  {
+#if !defined(CHAI_DEVICE_COMPILE)
+    if (m_table) {
+      m_table->release();
+    }
+#endif
+  }
+
+  /*!
+   * \brief Move every array to space as one batch and view them there.
+   *
+   * \param space The execution space to view the arrays in.
+   */
+  CHAI_HOST void move(ExecutionSpace space)
+  {
+    this->data =
+        toData(m_table->capture(space, !std::is_const<ValueType>::value));
+  }
+
+private:
+  CHAI_HOST static ValueType** toData(void** table)
+  {
+    return const_cast<ValueType**>(
+        reinterpret_cast<camp::type::cv::rem<ValueType>**>(table));
+  }
+
+  PointerTable* m_table;
+};
+#endif
+
 } // end of namespace chai
 
 #endif // defined(CHAI_ENABLE_RAJA_PLUGIN)
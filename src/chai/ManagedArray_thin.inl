@@ -56,6 +56,15 @@ CHAI_HOST_DEVICE ManagedArray<T>::ManagedArray(size_t elems, ExecutionSpace spac
 }
 
 
+template<typename T>
+CHAI_INLINE
+CHAI_HOST_DEVICE ManagedArray<T>::ManagedArray(size_t elems,
+                                               ExecutionSpace space,
+                                               const char*) :
+  ManagedArray(elems, space)
+{
+}
+
 template <typename T>
 CHAI_INLINE CHAI_HOST_DEVICE ManagedArray<T>::ManagedArray(std::nullptr_t)
     : m_active_pointer(nullptr),
@@ -140,7 +149,8 @@ template<typename T>
 CHAI_INLINE
 CHAI_HOST void ManagedArray<T>::allocate(size_t elems,
                                          ExecutionSpace space,
-                                         UserCallback const &) {
+                                         UserCallback const &,
+                                         const char*) {
   if (!m_is_slice) {
     (void) space; // Quiet compiler warning when CHAI_LOG does nothing
     CHAI_LOG(Debug, "Allocating array of size " << elems
@@ -163,6 +173,19 @@ CHAI_HOST void ManagedArray<T>::allocate(size_t elems,
   m_active_base_pointer = m_active_pointer;
 }
 
+template<typename T>
+CHAI_INLINE
+CHAI_HOST void ManagedArray<T>::setName(const char*)
+{
+}
+
+template<typename T>
+CHAI_INLINE
+CHAI_HOST const char* ManagedArray<T>::getName() const
+{
+  return nullptr;
+}
+
 template<typename T>
 CHAI_INLINE
 CHAI_HOST void ManagedArray<T>::reallocate(size_t new_elems)
@@ -0,0 +1,263 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#ifndef CHAI_ManagedReduceArray_HPP
+#define CHAI_ManagedReduceArray_HPP
+
+#include "chai/config.hpp"
+#include "chai/ChaiMacros.hpp"
+#include "chai/ManagedArray.hpp"
+#include "chai/Reducers.hpp"
+#include "chai/ThreadPool.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+
+#if defined(__GNUC__)
+#define CHAI_HAS_HOST_ATOMICS
+#endif
+
+namespace chai
+{
+
+/*!
+ * \brief Enum listing the ways a ManagedReduceArray can combine the updates
+ *        made by different threads.
+ */
+enum ReduceStrategy {
+  /*! Choose from the size of the array and the number of threads. */
+  REDUCE_AUTO = 0,
+  /*! Add directly into the array with atomic operations. */
+  REDUCE_ATOMIC,
+  /*! Add into a private copy per thread, and merge the copies afterwards. */
+  REDUCE_PRIVATIZE
+};
+
+/*!
+ * \brief Wraps a ManagedArray that loops scatter-add into.
+ *
+ * Under REDUCE_PRIVATIZE, every thread of the ThreadPool adds into its own
+ * zero-initialized copy of the array, and the copies are merged into the
+ * array with a tree reduction after the loop. Under REDUCE_ATOMIC, threads
+ * add straight into the array with atomics. Privatization avoids contention
+ * on the elements, at the cost of memory and of the merge, so REDUCE_AUTO
+ * privatizes when each copy is small enough to stay in cache and the pool
+ * has more than one thread.
+ *
+ * Like the reducers, a ManagedReduceArray is passed to forall ahead of the
+ * loop body, which resets the copies before the loop and merges them after
+ * it:
+ *
+ * \code
+ * chai::ManagedReduceArray<double> node_mass(mass);
+ * forall(parallel_host(), 0, num_zones, node_mass, [=] (int zone) {
+ *   node_mass.add(zone_to_node[zone], zone_mass[zone]);
+ * });
+ * node_mass.free();
+ * \endcode
+ *
+ * The private copies are released by free; the wrapped array is not.
+ */
+template <typename T>
+class ManagedReduceArray : public ReducerBase
+{
+public:
+  /*!
+   * \brief Largest array, in bytes, that REDUCE_AUTO privatizes.
+   */
+  static constexpr size_t s_privatize_bytes = 1 << 20;
+
+  /*!
+   * \brief Strategy REDUCE_AUTO picks for an array.
+   *
+   * \param elems Number of elements in the array.
+   * \param num_threads Number of threads adding into it.
+   */
+  CHAI_HOST static ReduceStrategy chooseStrategy(size_t elems, int num_threads)
+  {
+#if defined(CHAI_HAS_HOST_ATOMICS)
+    if (num_threads == 1 || elems * sizeof(T) > s_privatize_bytes) {
+      return REDUCE_ATOMIC;
+    }
+#endif
+    return REDUCE_PRIVATIZE;
+  }
+
+  /*!
+   * \brief Create a ManagedReduceArray adding into array.
+   *
+   * \param array The array to add into.
+   * \param strategy How to combine the updates of different threads.
+   */
+  CHAI_HOST ManagedReduceArray(ManagedArray<T> array,
+                               ReduceStrategy strategy = REDUCE_AUTO) :
+    m_array(array),
+    m_copies(),
+    m_elems(array.size()),
+    m_num_copies(ThreadPool::getInstance()->getNumThreads()),
+    m_stride(0),
+    m_strategy(strategy)
+  {
+    if (m_strategy == REDUCE_AUTO) {
+      m_strategy = chooseStrategy(m_elems, m_num_copies);
+    }
+
+#if !defined(CHAI_HAS_HOST_ATOMICS)
+    m_strategy = REDUCE_PRIVATIZE;
+#endif
+
+    if (m_strategy == REDUCE_PRIVATIZE) {
+      // Round each copy up to whole cache lines
+      const size_t line = sizeof(T) < 64 ? 64 / sizeof(T) : 1;
+      m_stride = (m_elems + line - 1) / line * line;
+
+      m_copies.allocate(m_num_copies * m_stride, CPU);
+    }
+  }
+
+  /*!
+   * \brief Add value to element i.
+   */
+  CHAI_HOST void add(size_t i, T value) const
+  {
+    if (m_strategy == REDUCE_PRIVATIZE) {
+      m_copies[ThreadPool::getThreadId() * m_stride + i] += value;
+    } else {
+#if defined(CHAI_HAS_HOST_ATOMICS)
+      T* address = &m_array[i];
+      T expected;
+      T desired;
+      __atomic_load(address, &expected, __ATOMIC_RELAXED);
+      do {
+        desired = expected + value;
+      } while (!__atomic_compare_exchange(address, &expected, &desired, true,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+#endif
+    }
+  }
+
+  /*!
+   * \brief Get the strategy in use.
+   */
+  CHAI_HOST ReduceStrategy getStrategy() const
+  {
+    return m_strategy;
+  }
+
+  /*!
+   * \brief Get the array added into.
+   */
+  CHAI_HOST ManagedArray<T> getArray() const
+  {
+    return m_array;
+  }
+
+  /*!
+   * \brief Zero the private copies, in the current space.
+   */
+  CHAI_HOST void resetSlots() const
+  {
+    if (m_strategy != REDUCE_PRIVATIZE || m_elems == 0) {
+      return;
+    }
+
+    T* copies = &m_copies[0];
+
+    parallelForRanges(m_num_copies * m_stride, [=] (size_t begin, size_t end) {
+      std::fill(copies + begin, copies + end, T(0));
+    });
+  }
+
+  /*!
+   * \brief Merge the private copies into the array, in the current space.
+   *
+   * Blocks of elements are spread over the ThreadPool. Within a block, the
+   * copies are added pairwise, halving their number at every level, with
+   * the innermost loop running over contiguous elements.
+   */
+  CHAI_HOST void combineSlots() const
+  {
+    if (m_strategy != REDUCE_PRIVATIZE || m_elems == 0) {
+      return;
+    }
+
+    T* copies = &m_copies[0];
+    T* array = &m_array[0];
+    const size_t stride = m_stride;
+    const size_t num_copies = m_num_copies;
+
+    parallelForRanges(m_elems, [=] (size_t begin, size_t end) {
+      for (size_t step = 1; step < num_copies; step *= 2) {
+        for (size_t copy = 0; copy + step < num_copies; copy += 2 * step) {
+          T* CHAI_RESTRICT dst = copies + copy * stride;
+          const T* CHAI_RESTRICT src = copies + (copy + step) * stride;
+
+          for (size_t i = begin; i < end; ++i) {
+            dst[i] += src[i];
+          }
+        }
+      }
+
+      for (size_t i = begin; i < end; ++i) {
+        array[i] += copies[i];
+      }
+    });
+  }
+
+  /*!
+   * \brief Release the private copies.
+   */
+  CHAI_HOST void free()
+  {
+    if (m_strategy == REDUCE_PRIVATIZE) {
+      m_copies.free();
+    }
+  }
+
+private:
+  /*!
+   * \brief Split [0, size) into ranges run on the ThreadPool.
+   *
+   * The pool indexes loops with int, so ranges of more than INT_MAX
+   * elements are split into blocks of several elements each.
+   */
+  template <typename RANGE_BODY>
+  CHAI_HOST static void parallelForRanges(size_t size, RANGE_BODY const& body)
+  {
+    const size_t block =
+        size / static_cast<size_t>(std::numeric_limits<int>::max()) + 1;
+    const int num_blocks = static_cast<int>((size + block - 1) / block);
+
+    ThreadPool::getInstance()->parallelFor(0, num_blocks, SCHEDULE_STATIC,
+      [=, &body] (int begin, int end) {
+        body(static_cast<size_t>(begin) * block,
+             std::min(static_cast<size_t>(end) * block, size));
+      });
+  }
+
+  ManagedArray<T> m_array;
+
+  ManagedArray<T> m_copies;
+
+  size_t m_elems;
+
+  size_t m_num_copies;
+
+  /*!
+   * Distance between the private copies, in elements.
+   */
+  size_t m_stride;
+
+  ReduceStrategy m_strategy;
+};
+
+template <typename T>
+constexpr size_t ManagedReduceArray<T>::s_privatize_bytes;
+
+}  // end of namespace chai
+
+#endif  // CHAI_ManagedReduceArray_HPP
@@ -0,0 +1,539 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#include "chai/Metrics.hpp"
+
+#include "chai/ChaiMacros.hpp"
+#include "chai/Instrumentation.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <ostream>
+
+namespace chai
+{
+
+namespace {
+
+const char* spaceName(int space)
+{
+  switch (space) {
+    case CPU:
+      return "CPU";
+    case GPU:
+      return "GPU";
+    case UM:
+      return "UM";
+    case PINNED:
+      return "PINNED";
+    default:
+      return "NONE";
+  }
+}
+
+int bucketOf(std::uint64_t value)
+{
+  int bucket = 0;
+  while (value) {
+    ++bucket;
+    value >>= 1;
+  }
+  return bucket;
+}
+
+std::uint64_t nanoseconds(Metrics::Clock::duration duration)
+{
+  return static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+}
+
+bool endsWith(std::string const& string, std::string const& suffix)
+{
+  return string.size() >= suffix.size() &&
+         string.compare(string.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+/*!
+ * Quote a string for a JSON string or a Prometheus label value, which escape
+ * the same characters.
+ */
+std::string quoted(std::string const& string)
+{
+  std::string result{"\""};
+  for (char c : string) {
+    if (c == '\\' || c == '"') {
+      result += '\\';
+      result += c;
+    } else if (c == '\n') {
+      result += "\\n";
+    } else {
+      result += c;
+    }
+  }
+  return result + "\"";
+}
+
+void writeJsonSpaces(std::ostream& stream,
+                     const char* name,
+                     std::uint64_t const* values)
+{
+  stream << "  \"" << name << "\": {";
+  for (int space = CPU; space < NUM_EXECUTION_SPACES; ++space) {
+    stream << (space == CPU ? "" : ", ") << "\"" << spaceName(space)
+           << "\": " << values[space];
+  }
+  stream << "},\n";
+}
+
+void writeJsonHistogram(std::ostream& stream,
+                        Metrics::Histogram const& histogram)
+{
+  stream << "{\"count\": " << histogram.count << ", \"sum\": "
+         << histogram.sum << ", \"buckets\": [";
+
+  bool first = true;
+  for (int b = 0; b < Metrics::s_buckets; ++b) {
+    if (histogram.buckets[b]) {
+      stream << (first ? "" : ", ") << "{\"le\": "
+             << Metrics::Histogram::upperBound(b) << ", \"count\": "
+             << histogram.buckets[b] << "}";
+      first = false;
+    }
+  }
+
+  stream << "]}";
+}
+
+void writePrometheusHeader(std::ostream& stream,
+                           const char* name,
+                           const char* type,
+                           const char* help)
+{
+  stream << "# HELP " << name << " " << help << "\n"
+         << "# TYPE " << name << " " << type << "\n";
+}
+
+void writePrometheusSpaces(std::ostream& stream,
+                           const char* name,
+                           const char* type,
+                           const char* label,
+                           const char* help,
+                           std::uint64_t const* values)
+{
+  writePrometheusHeader(stream, name, type, help);
+  for (int space = CPU; space < NUM_EXECUTION_SPACES; ++space) {
+    stream << name << "{" << label << "=\"" << spaceName(space) << "\"} "
+           << values[space] << "\n";
+  }
+}
+
+/*!
+ * Buckets are cumulative, and end at the last bucket holding a value.
+ */
+void writePrometheusHistogram(std::ostream& stream,
+                              const char* name,
+                              std::string const& labels,
+                              Metrics::Histogram const& histogram)
+{
+  const std::string prefix = labels.empty() ? "{" : "{" + labels + ",";
+  const std::string suffix = labels.empty() ? "" : "{" + labels + "}";
+
+  int last = -1;
+  for (int b = 0; b < Metrics::s_buckets; ++b) {
+    if (histogram.buckets[b]) {
+      last = b;
+    }
+  }
+
+  std::uint64_t cumulative = 0;
+  for (int b = 0; b <= last; ++b) {
+    cumulative += histogram.buckets[b];
+    stream << name << "_bucket" << prefix << "le=\""
+           << Metrics::Histogram::upperBound(b) << "\"} " << cumulative
+           << "\n";
+  }
+
+  stream << name << "_bucket" << prefix << "le=\"+Inf\"} " << histogram.count
+         << "\n"
+         << name << "_sum" << suffix << " " << histogram.sum << "\n"
+         << name << "_count" << suffix << " " << histogram.count << "\n";
+}
+
+}  // end of anonymous namespace
+
+constexpr int Metrics::s_buckets;
+
+std::uint64_t Metrics::Histogram::upperBound(int bucket)
+{
+  if (bucket >= 64) {
+    return std::numeric_limits<std::uint64_t>::max();
+  }
+
+  return (std::uint64_t(1) << bucket) - 1;
+}
+
+void Metrics::Snapshot::writeJson(std::ostream& stream) const
+{
+  stream << "{\n";
+
+  writeJsonSpaces(stream, "allocations", allocations);
+  writeJsonSpaces(stream, "bytes_allocated", bytes_allocated);
+  writeJsonSpaces(stream, "frees", frees);
+  writeJsonSpaces(stream, "bytes_freed", bytes_freed);
+
+  std::uint64_t in_use[NUM_EXECUTION_SPACES] = {};
+  for (int space = CPU; space < NUM_EXECUTION_SPACES; ++space) {
+    in_use[space] = bytesInUse(ExecutionSpace(space));
+  }
+  writeJsonSpaces(stream, "bytes_in_use", in_use);
+
+  stream << "  \"allocation_latency_ns\": {";
+  for (int space = CPU; space < NUM_EXECUTION_SPACES; ++space) {
+    stream << (space == CPU ? "" : ", ") << "\"" << spaceName(space)
+           << "\": ";
+    writeJsonHistogram(stream, allocation_latency[space]);
+  }
+  stream << "},\n";
+
+  writeJsonSpaces(stream, "moves", moves);
+  writeJsonSpaces(stream, "bytes_moved", bytes_moved);
+
+  stream << "  \"move_size_bytes\": ";
+  writeJsonHistogram(stream, move_size);
+  stream << ",\n  \"move_latency_ns\": ";
+  writeJsonHistogram(stream, move_latency);
+  stream << ",\n";
+
+  writeJsonSpaces(stream, "kernels", kernels);
+
+  stream << "  \"captures\": " << captures << ",\n"
+         << "  \"kernel_captures\": ";
+  writeJsonHistogram(stream, kernel_captures);
+  stream << ",\n"
+         << "  \"evictions\": " << evictions << ",\n"
+         << "  \"bytes_evicted\": " << bytes_evicted << ",\n"
+         << "  \"regions\": [";
+
+  for (size_t i = 0; i < regions.size(); ++i) {
+    RegionStatistics::Entry const& region = regions[i];
+
+    stream << (i == 0 ? "\n" : ",\n") << "    {\"path\": "
+           << quoted(region.path) << ", \"captures\": " << region.captures
+           << ", \"allocations\": " << region.allocations
+           << ", \"bytes_allocated\": " << region.bytes_allocated
+           << ", \"bytes_moved\": {";
+    for (int space = CPU; space < NUM_EXECUTION_SPACES; ++space) {
+      stream << (space == CPU ? "" : ", ") << "\"" << spaceName(space)
+             << "\": " << region.bytes_moved[space];
+    }
+    stream << "}}";
+  }
+
+  stream << (regions.empty() ? "]\n" : "\n  ]\n") << "}\n";
+}
+
+void Metrics::Snapshot::writePrometheus(std::ostream& stream) const
+{
+  writePrometheusSpaces(stream, "chai_allocations_total", "counter", "space",
+                        "Allocations made by CHAI.", allocations);
+  writePrometheusSpaces(stream, "chai_allocated_bytes_total", "counter",
+                        "space", "Bytes allocated by CHAI.", bytes_allocated);
+  writePrometheusSpaces(stream, "chai_frees_total", "counter", "space",
+                        "Allocations freed by CHAI.", frees);
+  writePrometheusSpaces(stream, "chai_freed_bytes_total", "counter", "space",
+                        "Bytes freed by CHAI.", bytes_freed);
+
+  std::uint64_t in_use[NUM_EXECUTION_SPACES] = {};
+  for (int space = CPU; space < NUM_EXECUTION_SPACES; ++space) {
+    in_use[space] = bytesInUse(ExecutionSpace(space));
+  }
+  writePrometheusSpaces(stream, "chai_memory_bytes", "gauge", "space",
+                        "Bytes allocated by CHAI and not yet freed.", in_use);
+
+  writePrometheusHeader(stream, "chai_allocation_latency_nanoseconds",
+                        "histogram", "Time taken by allocations.");
+  for (int space = CPU; space < NUM_EXECUTION_SPACES; ++space) {
+    writePrometheusHistogram(
+        stream, "chai_allocation_latency_nanoseconds",
+        std::string("space=\"") + spaceName(space) + "\"",
+        allocation_latency[space]);
+  }
+
+  writePrometheusSpaces(stream, "chai_moves_total", "counter", "destination",
+                        "Moves made by CHAI.", moves);
+  writePrometheusSpaces(stream, "chai_moved_bytes_total", "counter",
+                        "destination", "Bytes moved by CHAI.", bytes_moved);
+
+  writePrometheusHeader(stream, "chai_move_size_bytes", "histogram",
+                        "Size of moves.");
+  writePrometheusHistogram(stream, "chai_move_size_bytes", "", move_size);
+
+  writePrometheusHeader(stream, "chai_move_latency_nanoseconds", "histogram",
+                        "Time taken by batches of copies.");
+  writePrometheusHistogram(stream, "chai_move_latency_nanoseconds", "",
+                           move_latency);
+
+  writePrometheusSpaces(stream, "chai_kernels_total", "counter", "space",
+                        "Kernels launched.", kernels);
+
+  writePrometheusHeader(stream, "chai_captures_total", "counter",
+                        "Arrays captured.");
+  stream << "chai_captures_total " << captures << "\n";
+
+  writePrometheusHeader(stream, "chai_kernel_captures", "histogram",
+                        "Arrays captured by each kernel.");
+  writePrometheusHistogram(stream, "chai_kernel_captures", "",
+                           kernel_captures);
+
+  writePrometheusHeader(stream, "chai_evictions_total", "counter",
+                        "Evictions of a space.");
+  stream << "chai_evictions_total " << evictions << "\n";
+
+  writePrometheusHeader(stream, "chai_evicted_bytes_total", "counter",
+                        "Bytes moved by evictions.");
+  stream << "chai_evicted_bytes_total " << bytes_evicted << "\n";
+
+  if (regions.empty()) {
+    return;
+  }
+
+  writePrometheusHeader(stream, "chai_region_captures_total", "counter",
+                        "Arrays captured in a region and the regions it "
+                        "encloses.");
+  for (RegionStatistics::Entry const& region : regions) {
+    stream << "chai_region_captures_total{region=" << quoted(region.path)
+           << "} " << region.captures << "\n";
+  }
+
+  writePrometheusHeader(stream, "chai_region_allocated_bytes_total",
+                        "counter",
+                        "Bytes allocated in a region and the regions it "
+                        "encloses.");
+  for (RegionStatistics::Entry const& region : regions) {
+    stream << "chai_region_allocated_bytes_total{region="
+           << quoted(region.path) << "} " << region.bytes_allocated << "\n";
+  }
+
+  writePrometheusHeader(stream, "chai_region_moved_bytes_total", "counter",
+                        "Bytes moved in a region and the regions it "
+                        "encloses.");
+  for (RegionStatistics::Entry const& region : regions) {
+    for (int space = CPU; space < NUM_EXECUTION_SPACES; ++space) {
+      stream << "chai_region_moved_bytes_total{region=" << quoted(region.path)
+             << ",destination=\"" << spaceName(space) << "\"} "
+             << region.bytes_moved[space] << "\n";
+    }
+  }
+}
+
+Metrics::AtomicHistogram::AtomicHistogram()
+{
+  clear();
+}
+
+void Metrics::AtomicHistogram::record(std::uint64_t value)
+{
+  buckets[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+  count.fetch_add(1, std::memory_order_relaxed);
+  sum.fetch_add(value, std::memory_order_relaxed);
+}
+
+void Metrics::AtomicHistogram::load(Histogram& histogram) const
+{
+  for (int b = 0; b < s_buckets; ++b) {
+    histogram.buckets[b] = buckets[b].load(std::memory_order_relaxed);
+  }
+  histogram.count = count.load(std::memory_order_relaxed);
+  histogram.sum = sum.load(std::memory_order_relaxed);
+}
+
+void Metrics::AtomicHistogram::clear()
+{
+  for (int b = 0; b < s_buckets; ++b) {
+    buckets[b] = 0;
+  }
+  count = 0;
+  sum = 0;
+}
+
+Metrics::Metrics() :
+  m_enabled{false},
+  m_output{}
+{
+  // Snapshots read the regions, so the regions must outlive the Metrics.
+  RegionStatistics::getInstance();
+
+  clear();
+
+  const char* env = std::getenv("CHAI_METRICS");
+  if (env && *env) {
+    m_output = env;
+    setEnabled(true);
+  }
+}
+
+Metrics::~Metrics()
+{
+  if (!m_output.empty()) {
+    write(m_output);
+  }
+}
+
+void Metrics::setEnabled(bool enabled)
+{
+  m_enabled = enabled;
+  Instrumentation::setEnabled(INSTRUMENT_METRICS, enabled);
+}
+
+void Metrics::recordAllocation(ExecutionSpace space,
+                               size_t size,
+                               Clock::duration latency)
+{
+  m_allocations[space].fetch_add(1, std::memory_order_relaxed);
+  m_bytes_allocated[space].fetch_add(size, std::memory_order_relaxed);
+  m_allocation_latency[space].record(nanoseconds(latency));
+}
+
+void Metrics::recordFree(ExecutionSpace space, size_t size)
+{
+  m_frees[space].fetch_add(1, std::memory_order_relaxed);
+  m_bytes_freed[space].fetch_add(size, std::memory_order_relaxed);
+}
+
+void Metrics::recordMove(ExecutionSpace destination, size_t size)
+{
+  m_moves[destination].fetch_add(1, std::memory_order_relaxed);
+  m_bytes_moved[destination].fetch_add(size, std::memory_order_relaxed);
+  m_move_size.record(size);
+}
+
+void Metrics::recordMoveLatency(Clock::duration latency)
+{
+  m_move_latency.record(nanoseconds(latency));
+}
+
+void Metrics::beginKernel(ExecutionSpace space)
+{
+  endKernel();
+  m_kernels[space].fetch_add(1, std::memory_order_relaxed);
+  m_current_captures.store(0, std::memory_order_relaxed);
+}
+
+void Metrics::endKernel()
+{
+  const std::int64_t captures =
+      m_current_captures.exchange(-1, std::memory_order_relaxed);
+
+  if (captures >= 0) {
+    m_kernel_captures.record(static_cast<std::uint64_t>(captures));
+  }
+}
+
+void Metrics::recordCapture()
+{
+  m_captures.fetch_add(1, std::memory_order_relaxed);
+
+  if (m_current_captures.load(std::memory_order_relaxed) >= 0) {
+    m_current_captures.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void Metrics::recordEviction(size_t size)
+{
+  m_evictions.fetch_add(1, std::memory_order_relaxed);
+  m_bytes_evicted.fetch_add(size, std::memory_order_relaxed);
+}
+
+Metrics::Snapshot Metrics::snapshot() const
+{
+  Snapshot snapshot;
+
+  for (int space = CPU; space < NUM_EXECUTION_SPACES; ++space) {
+    snapshot.allocations[space] =
+        m_allocations[space].load(std::memory_order_relaxed);
+    snapshot.bytes_allocated[space] =
+        m_bytes_allocated[space].load(std::memory_order_relaxed);
+    snapshot.frees[space] = m_frees[space].load(std::memory_order_relaxed);
+    snapshot.bytes_freed[space] =
+        m_bytes_freed[space].load(std::memory_order_relaxed);
+    m_allocation_latency[space].load(snapshot.allocation_latency[space]);
+
+    snapshot.moves[space] = m_moves[space].load(std::memory_order_relaxed);
+    snapshot.bytes_moved[space] =
+        m_bytes_moved[space].load(std::memory_order_relaxed);
+
+    snapshot.kernels[space] = m_kernels[space].load(std::memory_order_relaxed);
+  }
+
+  m_move_size.load(snapshot.move_size);
+  m_move_latency.load(snapshot.move_latency);
+
+  snapshot.captures = m_captures.load(std::memory_order_relaxed);
+  m_kernel_captures.load(snapshot.kernel_captures);
+
+  snapshot.evictions = m_evictions.load(std::memory_order_relaxed);
+  snapshot.bytes_evicted = m_bytes_evicted.load(std::memory_order_relaxed);
+
+  RegionStatistics* regions = RegionStatistics::getInstance();
+  if (regions->isEnabled()) {
+    snapshot.regions = regions->getEntries();
+    snapshot.regions.erase(snapshot.regions.begin());
+  }
+
+  return snapshot;
+}
+
+bool Metrics::write(std::string const& path) const
+{
+  const Snapshot values = snapshot();
+  const std::string temporary = path + ".tmp";
+
+  {
+    std::ofstream file(temporary);
+    if (!file) {
+      CHAI_LOG(Warning, "Cannot write metrics to " << path);
+      return false;
+    }
+
+    if (endsWith(path, ".json")) {
+      values.writeJson(file);
+    } else {
+      values.writePrometheus(file);
+    }
+
+    if (!file) {
+      return false;
+    }
+  }
+
+  return std::rename(temporary.c_str(), path.c_str()) == 0;
+}
+
+void Metrics::clear()
+{
+  for (int space = 0; space < NUM_EXECUTION_SPACES; ++space) {
+    m_allocations[space] = 0;
+    m_bytes_allocated[space] = 0;
+    m_frees[space] = 0;
+    m_bytes_freed[space] = 0;
+    m_allocation_latency[space].clear();
+    m_moves[space] = 0;
+    m_bytes_moved[space] = 0;
+    m_kernels[space] = 0;
+  }
+
+  m_move_size.clear();
+  m_move_latency.clear();
+  m_captures = 0;
+  m_kernel_captures.clear();
+  m_current_captures = -1;
+  m_evictions = 0;
+  m_bytes_evicted = 0;
+}
+
+}  // end of namespace chai
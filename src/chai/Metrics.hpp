@@ -0,0 +1,258 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#ifndef CHAI_Metrics_HPP
+#define CHAI_Metrics_HPP
+
+#include "chai/config.hpp"
+#include "chai/ExecutionSpaces.hpp"
+#include "chai/RegionStatistics.hpp"
+#include "chai/Types.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace chai
+{
+
+/*!
+ * \brief Counters and histograms of the work of the ArrayManager.
+ *
+ * The ArrayManager owns a registry, returned by ArrayManager::getMetrics,
+ * that counts allocations, frees, moves, kernel launches, captures and
+ * evictions. Sizes and latencies are kept in histograms with power of two
+ * buckets. Every metric is a relaxed atomic counter, so snapshot copies the
+ * counters without stopping the ArrayManager.
+ *
+ * The ArrayManager only records, and only reads the clock for latencies,
+ * while the registry is enabled, so the metrics count the work done while it
+ * was on. Setting the CHAI_METRICS environment variable to a file name turns
+ * recording on, and writes the metrics to that file at shutdown, as JSON if
+ * the name ends in .json and as Prometheus text otherwise. Snapshots are
+ * exported in the same formats, to a stream or a local file. While
+ * RegionStatistics collects, snapshots also hold the traffic of every region,
+ * exported with the region's path as a label.
+ */
+class Metrics
+{
+public:
+  using Clock = std::chrono::steady_clock;
+
+  /*!
+   * Number of buckets of a histogram. Bucket 0 counts zeros, and bucket i
+   * counts the values from 2^(i-1) to 2^i - 1.
+   */
+  static constexpr int s_buckets = 65;
+
+  /*!
+   * \brief Values recorded in a histogram.
+   */
+  struct Histogram {
+    std::uint64_t buckets[s_buckets] = {};
+    std::uint64_t count = 0;
+    std::uint64_t sum = 0;
+
+    /*!
+     * \brief Largest value counted by bucket.
+     */
+    static std::uint64_t upperBound(int bucket);
+  };
+
+  /*!
+   * \brief Values of every metric at one point in time.
+   *
+   * Metrics indexed by execution space are indexed by the space allocated
+   * or freed, the destination of moves, and the space kernels run in.
+   */
+  struct Snapshot {
+    std::uint64_t allocations[NUM_EXECUTION_SPACES] = {};
+    std::uint64_t bytes_allocated[NUM_EXECUTION_SPACES] = {};
+    std::uint64_t frees[NUM_EXECUTION_SPACES] = {};
+    std::uint64_t bytes_freed[NUM_EXECUTION_SPACES] = {};
+
+    /*!
+     * Time taken by allocations, in nanoseconds.
+     */
+    Histogram allocation_latency[NUM_EXECUTION_SPACES];
+
+    std::uint64_t moves[NUM_EXECUTION_SPACES] = {};
+    std::uint64_t bytes_moved[NUM_EXECUTION_SPACES] = {};
+
+    /*!
+     * Size of moves, in bytes.
+     */
+    Histogram move_size;
+
+    /*!
+     * Time taken by each batch of copies, in nanoseconds. A move that is
+     * not batched with others is a batch of one.
+     */
+    Histogram move_latency;
+
+    std::uint64_t kernels[NUM_EXECUTION_SPACES] = {};
+    std::uint64_t captures = 0;
+
+    /*!
+     * Number of arrays captured by each kernel.
+     */
+    Histogram kernel_captures;
+
+    std::uint64_t evictions = 0;
+    std::uint64_t bytes_evicted = 0;
+
+    /*!
+     * Totals of every region but the root, if RegionStatistics collects.
+     */
+    std::vector<RegionStatistics::Entry> regions;
+
+    /*!
+     * \brief Bytes allocated and not yet freed in space.
+     *
+     * Frees of allocations made before recording was turned on are counted
+     * without the allocations, so the difference stops at zero.
+     */
+    std::uint64_t bytesInUse(ExecutionSpace space) const
+    {
+      return bytes_allocated[space] > bytes_freed[space]
+                 ? bytes_allocated[space] - bytes_freed[space]
+                 : 0;
+    }
+
+    /*!
+     * \brief Write the snapshot as a JSON object.
+     */
+    CHAISHAREDDLL_API void writeJson(std::ostream& stream) const;
+
+    /*!
+     * \brief Write the snapshot in the Prometheus text format.
+     */
+    CHAISHAREDDLL_API void writePrometheus(std::ostream& stream) const;
+  };
+
+  /*!
+   * \brief Construct a registry with every metric at zero.
+   */
+  CHAISHAREDDLL_API Metrics();
+
+  /*!
+   * \brief Write the metrics if CHAI_METRICS is set.
+   */
+  CHAISHAREDDLL_API ~Metrics();
+
+  Metrics(Metrics const&) = delete;
+  Metrics& operator=(Metrics const&) = delete;
+
+  /*!
+   * \brief Turn recording by the ArrayManager on or off.
+   */
+  CHAISHAREDDLL_API void setEnabled(bool enabled);
+
+  /*!
+   * \brief Whether the ArrayManager records the metrics.
+   */
+  bool isEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+  CHAISHAREDDLL_API void recordAllocation(ExecutionSpace space,
+                                          size_t size,
+                                          Clock::duration latency);
+
+  CHAISHAREDDLL_API void recordFree(ExecutionSpace space, size_t size);
+
+  CHAISHAREDDLL_API void recordMove(ExecutionSpace destination, size_t size);
+
+  CHAISHAREDDLL_API void recordMoveLatency(Clock::duration latency);
+
+  /*!
+   * \brief Count a kernel launched in space, ending the current kernel.
+   */
+  CHAISHAREDDLL_API void beginKernel(ExecutionSpace space);
+
+  /*!
+   * \brief Count the captures of the current kernel.
+   */
+  CHAISHAREDDLL_API void endKernel();
+
+  CHAISHAREDDLL_API void recordCapture();
+
+  CHAISHAREDDLL_API void recordEviction(size_t size);
+
+  /*!
+   * \brief Get the values of every metric.
+   */
+  CHAISHAREDDLL_API Snapshot snapshot() const;
+
+  /*!
+   * \brief Write a snapshot to the file at path.
+   *
+   * The snapshot is written to a temporary file that is then renamed, so
+   * that a scraper never reads a partial file.
+   *
+   * \param path File to write, as JSON if it ends in .json and as Prometheus
+   *        text otherwise.
+   *
+   * \return false if the file could not be written.
+   */
+  CHAISHAREDDLL_API bool write(std::string const& path) const;
+
+  /*!
+   * \brief Set every metric back to zero.
+   */
+  CHAISHAREDDLL_API void clear();
+
+private:
+  struct AtomicHistogram {
+    std::atomic<std::uint64_t> buckets[s_buckets];
+    std::atomic<std::uint64_t> count;
+    std::atomic<std::uint64_t> sum;
+
+    AtomicHistogram();
+
+    void record(std::uint64_t value);
+
+    void load(Histogram& histogram) const;
+
+    void clear();
+  };
+
+  std::atomic<std::uint64_t> m_allocations[NUM_EXECUTION_SPACES];
+  std::atomic<std::uint64_t> m_bytes_allocated[NUM_EXECUTION_SPACES];
+  std::atomic<std::uint64_t> m_frees[NUM_EXECUTION_SPACES];
+  std::atomic<std::uint64_t> m_bytes_freed[NUM_EXECUTION_SPACES];
+  AtomicHistogram m_allocation_latency[NUM_EXECUTION_SPACES];
+
+  std::atomic<std::uint64_t> m_moves[NUM_EXECUTION_SPACES];
+  std::atomic<std::uint64_t> m_bytes_moved[NUM_EXECUTION_SPACES];
+  AtomicHistogram m_move_size;
+  AtomicHistogram m_move_latency;
+
+  std::atomic<std::uint64_t> m_kernels[NUM_EXECUTION_SPACES];
+  std::atomic<std::uint64_t> m_captures;
+  AtomicHistogram m_kernel_captures;
+
+  /*!
+   * Captures of the current kernel, or -1 outside kernels.
+   */
+  std::atomic<std::int64_t> m_current_captures;
+
+  std::atomic<std::uint64_t> m_evictions;
+  std::atomic<std::uint64_t> m_bytes_evicted;
+
+  std::atomic<bool> m_enabled;
+
+  /*!
+   * Value of CHAI_METRICS, if set.
+   */
+  std::string m_output;
+};
+
+}  // end of namespace chai
+
+#endif  // CHAI_Metrics_HPP
@@ -0,0 +1,87 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#include "chai/MovePlan.hpp"
+
+#include <unordered_map>
+
+namespace chai
+{
+
+size_t MovePlan::getNumKernels() const
+{
+  return m_kernels.size();
+}
+
+size_t MovePlan::getNumCaptures() const
+{
+  size_t num_captures = 0;
+
+  for (auto const& kernel : m_kernels) {
+    num_captures += kernel.captures.size();
+  }
+
+  return num_captures;
+}
+
+size_t MovePlan::getNumMoves() const
+{
+  return m_num_moves;
+}
+
+size_t MovePlan::getNumHoistedMoves() const
+{
+  return m_num_hoisted_moves;
+}
+
+void MovePlan::clear()
+{
+  m_kernels.clear();
+  m_num_moves = 0;
+  m_num_hoisted_moves = 0;
+}
+
+void MovePlan::optimize()
+{
+  m_num_moves = 0;
+  m_num_hoisted_moves = 0;
+
+  for (auto& kernel : m_kernels) {
+    kernel.moves.clear();
+  }
+
+  // Index of the kernel after the last one that captured each record. Until
+  // then the record is in use, so its next move cannot start any earlier.
+  std::unordered_map<PointerRecord*, size_t> available;
+
+  for (size_t k = 0; k < m_kernels.size(); ++k) {
+    for (auto const& capture : m_kernels[k].captures) {
+      PointerRecord* record = capture.move.record;
+      auto found = available.find(record);
+      const bool captured_before = found != available.end();
+
+      // A second capture by the same kernel is never the one that moves
+      if (capture.moved && !(captured_before && found->second > k)) {
+        size_t slot = k;
+
+        if (capture.source == GPU) {
+          slot = captured_before ? found->second : 0;
+        }
+
+        m_kernels[slot].moves.push_back(capture.move);
+
+        ++m_num_moves;
+        if (slot < k) {
+          ++m_num_hoisted_moves;
+        }
+      }
+
+      available[record] = k + 1;
+    }
+  }
+}
+
+}  // end of namespace chai
@@ -0,0 +1,132 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#ifndef CHAI_MovePlan_HPP
+#define CHAI_MovePlan_HPP
+
+#include "chai/config.hpp"
+#include "chai/ExecutionSpaces.hpp"
+#include "chai/PointerRecord.hpp"
+#include "chai/Types.hpp"
+
+#include <cstddef>
+#include <vector>
+
+namespace chai
+{
+
+class ArrayManager;
+
+/*!
+ * \brief Recorded sequence of kernels and their captures, with the moves
+ *        they need grouped and hoisted.
+ *
+ * A MovePlan is filled in by ArrayManager::beginCapture and
+ * ArrayManager::endCapture, and replayed with ArrayManager::beginReplay and
+ * ArrayManager::endReplay. A kernel is everything between two calls to
+ * ArrayManager::setExecutionSpace with a space other than NONE.
+ *
+ * The moves each kernel needed during the recording are issued in one batch
+ * when the kernel starts, before its body is captured. Moves out of the GPU
+ * space are hoisted further, to the start of the first kernel after the
+ * previous capture of the same array: data there can only change through
+ * captures, whereas host code between kernels may write host data directly.
+ * Captures that did not need a move during the recording are not planned.
+ *
+ * During a replay, a capture that matches the plan and finds its array where
+ * it needs it completes without deciding whether to move the array. Planned
+ * moves still go through the ArrayManager, so a replay that differs from the
+ * recording never produces stale data; a kernel or capture that does not
+ * match the plan ends the replay, and the rest of the sequence takes the
+ * normal path.
+ *
+ * \code
+ * chai::MovePlan plan;
+ * rm->beginCapture(plan);
+ * timestep();
+ * rm->endCapture();
+ *
+ * for (int cycle = 1; cycle < num_cycles; ++cycle) {
+ *   rm->beginReplay(plan);
+ *   timestep();
+ *   rm->endReplay();
+ * }
+ * \endcode
+ */
+class MovePlan
+{
+public:
+  /*!
+   * \brief Get the number of kernels recorded.
+   */
+  CHAISHAREDDLL_API size_t getNumKernels() const;
+
+  /*!
+   * \brief Get the number of captures recorded, across all kernels.
+   */
+  CHAISHAREDDLL_API size_t getNumCaptures() const;
+
+  /*!
+   * \brief Get the number of moves issued by a replay of the plan.
+   */
+  CHAISHAREDDLL_API size_t getNumMoves() const;
+
+  /*!
+   * \brief Get the number of moves issued before the kernel that needs them.
+   */
+  CHAISHAREDDLL_API size_t getNumHoistedMoves() const;
+
+  /*!
+   * \brief Forget everything recorded.
+   */
+  CHAISHAREDDLL_API void clear();
+
+private:
+  friend class ArrayManager;
+
+  /*!
+   * \brief A move issued at the start of a kernel.
+   *
+   * key and size identify the allocation the record described during the
+   * recording, so that records freed since are not moved.
+   */
+  struct Move {
+    PointerRecord* record;
+    ExecutionSpace space;
+    void* key;
+    size_t size;
+  };
+
+  /*!
+   * \brief A ManagedArray captured by a kernel.
+   */
+  struct Capture {
+    Move move;
+    ExecutionSpace source;
+    bool moved;
+  };
+
+  struct Kernel {
+    ExecutionSpace space;
+    std::vector<Capture> captures;
+    std::vector<Move> moves;
+  };
+
+  /*!
+   * \brief Assign the moves of the recorded captures to kernels.
+   */
+  void optimize();
+
+  std::vector<Kernel> m_kernels;
+
+  size_t m_num_moves = 0;
+
+  size_t m_num_hoisted_moves = 0;
+};
+
+}  // end of namespace chai
+
+#endif  // CHAI_MovePlan_HPP
@@ -0,0 +1,382 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#include "chai/OperationLog.hpp"
+
+#include "chai/ArrayManager.hpp"
+#include "chai/ChaiMacros.hpp"
+#include "chai/Instrumentation.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <istream>
+
+namespace chai
+{
+
+namespace {
+
+const char s_magic[8] = {'C', 'H', 'A', 'I', 'O', 'P', 'S', 1};
+
+const size_t s_flush_size = 1 << 16;
+
+/*!
+ * Spaces are logged with codes that do not depend on the spaces enabled in
+ * the build.
+ */
+unsigned char spaceCode(ExecutionSpace space)
+{
+  switch (space) {
+    case CPU:
+      return 1;
+    case GPU:
+      return 2;
+    case UM:
+      return 3;
+    case PINNED:
+      return 4;
+    default:
+      return 0;
+  }
+}
+
+ExecutionSpace spaceFromCode(unsigned code)
+{
+  ExecutionSpace space = NONE;
+
+  switch (code) {
+    case 1:
+      space = CPU;
+      break;
+    case 2:
+      space = GPU;
+      break;
+    case 3:
+      space = UM;
+      break;
+    case 4:
+      space = PINNED;
+      break;
+    default:
+      return NONE;
+  }
+
+  return space < NUM_EXECUTION_SPACES ? space : CPU;
+}
+
+bool hasArray(Operation operation)
+{
+  return operation != OPERATION_SET_SPACE && operation != OPERATION_EVICT;
+}
+
+bool hasSize(Operation operation)
+{
+  return operation == OPERATION_ALLOCATE || operation == OPERATION_REALLOCATE;
+}
+
+void writeInteger(std::vector<unsigned char>& buffer, std::uint64_t value)
+{
+  while (value >= 0x80) {
+    buffer.push_back(static_cast<unsigned char>(value | 0x80));
+    value >>= 7;
+  }
+
+  buffer.push_back(static_cast<unsigned char>(value));
+}
+
+bool readInteger(std::istream& stream, std::uint64_t& value)
+{
+  value = 0;
+
+  for (int shift = 0; shift < 64; shift += 7) {
+    const int byte = stream.get();
+    if (byte == std::istream::traits_type::eof()) {
+      return false;
+    }
+
+    value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+
+    if (!(byte & 0x80)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+}  // end of anonymous namespace
+
+OperationRecorder* OperationRecorder::getInstance()
+{
+  static OperationRecorder s_operation_recorder_instance;
+  return &s_operation_recorder_instance;
+}
+
+OperationRecorder::OperationRecorder() :
+  m_recording{false},
+  m_file{},
+  m_buffer{},
+  m_ids{},
+  m_next_id{0}
+{
+  const char* env = std::getenv("CHAI_RECORD");
+  if (env && *env) {
+    start(env);
+  }
+}
+
+OperationRecorder::~OperationRecorder()
+{
+  stop();
+}
+
+bool OperationRecorder::start(std::string const& path)
+{
+  stop();
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  m_file.open(path, std::ios::binary | std::ios::trunc);
+  if (!m_file) {
+    CHAI_LOG(Warning, "Cannot record operations to " << path);
+    return false;
+  }
+
+  m_file.write(s_magic, sizeof(s_magic));
+  m_ids.clear();
+  m_next_id = 0;
+  m_recording = true;
+  Instrumentation::setEnabled(INSTRUMENT_OPERATION_RECORDER, true);
+
+  return true;
+}
+
+void OperationRecorder::stop()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  if (!m_recording) {
+    return;
+  }
+
+  m_recording = false;
+  Instrumentation::setEnabled(INSTRUMENT_OPERATION_RECORDER, false);
+  flush();
+  m_file.close();
+}
+
+void OperationRecorder::append(Operation operation,
+                               PointerRecord const* record,
+                               ExecutionSpace space,
+                               ExecutionSpace other,
+                               size_t value)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  if (!m_recording) {
+    return;
+  }
+
+  std::uint64_t id = 0;
+
+  if (hasArray(operation)) {
+    auto found = m_ids.find(record);
+
+    if (found != m_ids.end()) {
+      id = found->second;
+    } else {
+      id = m_next_id++;
+      m_ids[record] = id;
+
+      // Arrays the ArrayManager did not allocate appear where they are
+      if (operation != OPERATION_ALLOCATE) {
+        ExecutionSpace first = CPU;
+        for (int s = NUM_EXECUTION_SPACES - 1; s >= CPU; --s) {
+          if (record->m_pointers[s]) {
+            first = ExecutionSpace(s);
+          }
+        }
+
+        write(OPERATION_ALLOCATE, first, NONE, false, id, record->m_size);
+      }
+    }
+  }
+
+  write(operation, space, other,
+        operation == OPERATION_CAPTURE && value != 0,
+        id,
+        hasSize(operation) ? value : 0);
+
+  if (m_buffer.size() >= s_flush_size) {
+    flush();
+  }
+}
+
+void OperationRecorder::forgetRecord(PointerRecord const* record)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_ids.erase(record);
+}
+
+void OperationRecorder::write(Operation operation,
+                              ExecutionSpace space,
+                              ExecutionSpace other,
+                              bool flag,
+                              std::uint64_t id,
+                              std::uint64_t size)
+{
+  m_buffer.push_back(static_cast<unsigned char>(operation | (flag ? 0x80 : 0)));
+  m_buffer.push_back(
+      static_cast<unsigned char>(spaceCode(space) | (spaceCode(other) << 4)));
+
+  if (hasArray(operation)) {
+    writeInteger(m_buffer, id);
+  }
+
+  if (hasSize(operation)) {
+    writeInteger(m_buffer, size);
+  }
+}
+
+void OperationRecorder::flush()
+{
+  if (!m_buffer.empty()) {
+    m_file.write(reinterpret_cast<const char*>(m_buffer.data()),
+                 static_cast<std::streamsize>(m_buffer.size()));
+    m_buffer.clear();
+  }
+
+  m_file.flush();
+}
+
+bool OperationReplayer::replay(std::string const& path)
+{
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    CHAI_LOG(Warning, "Cannot open operation log " << path);
+    return false;
+  }
+
+  return replay(file);
+}
+
+bool OperationReplayer::replay(std::istream& stream)
+{
+  char magic[sizeof(s_magic)];
+  if (!stream.read(magic, sizeof(magic)) ||
+      std::memcmp(magic, s_magic, sizeof(magic)) != 0) {
+    CHAI_LOG(Warning, "Not an operation log");
+    return false;
+  }
+
+  ArrayManager* manager = ArrayManager::getInstance();
+
+  while (true) {
+    const int code = stream.get();
+    if (code == std::istream::traits_type::eof()) {
+      return true;
+    }
+
+    const int spaces = stream.get();
+    if (spaces == std::istream::traits_type::eof()) {
+      return false;
+    }
+
+    const Operation operation = static_cast<Operation>(code & 0x7f);
+    const bool flag = (code & 0x80) != 0;
+    const ExecutionSpace space = spaceFromCode(spaces & 0xf);
+    const ExecutionSpace other = spaceFromCode(spaces >> 4);
+
+    std::uint64_t id = 0;
+    std::uint64_t size = 0;
+
+    if ((hasArray(operation) && !readInteger(stream, id)) ||
+        (hasSize(operation) && !readInteger(stream, size))) {
+      return false;
+    }
+
+    ++m_num_operations;
+
+    if (operation == OPERATION_SET_SPACE) {
+      manager->setExecutionSpace(space);
+      continue;
+    }
+
+    if (operation == OPERATION_EVICT) {
+      manager->evict(space, other);
+      continue;
+    }
+
+    PointerRecord*& record = m_records[id];
+
+    if (operation == OPERATION_ALLOCATE) {
+      if (!record) {
+        record = new PointerRecord();
+        record->m_size = size;
+        for (int s = CPU; s < NUM_EXECUTION_SPACES; ++s) {
+          record->m_allocators[s] =
+              manager->getAllocatorId(ExecutionSpace(s));
+        }
+      }
+
+      // Moves allocate their destination, which the log also holds
+      if (space != NONE && !record->m_pointers[space]) {
+        manager->allocate(record, space);
+      }
+
+      continue;
+    }
+
+    if (!record) {
+      m_records.erase(id);
+      continue;
+    }
+
+    switch (operation) {
+      case OPERATION_FREE:
+        manager->free(record, space);
+        if (space == NONE) {
+          m_records.erase(id);
+        }
+        break;
+      case OPERATION_REALLOCATE: {
+        void* pointer = nullptr;
+        for (int s = CPU; s < NUM_EXECUTION_SPACES && !pointer; ++s) {
+          pointer = record->m_pointers[s];
+        }
+        manager->reallocate<unsigned char>(pointer, size, record);
+        break;
+      }
+      case OPERATION_CAPTURE:
+        manager->move(&record, 1, space, flag);
+        break;
+      case OPERATION_TOUCH:
+        manager->registerTouch(record, space);
+        break;
+      default:
+        CHAI_LOG(Warning, "Unknown operation " << code << " in operation log");
+        return false;
+    }
+  }
+}
+
+void OperationReplayer::clear()
+{
+  ArrayManager* manager = ArrayManager::getInstance();
+
+  for (auto& entry : m_records) {
+    manager->free(entry.second);
+  }
+
+  m_records.clear();
+}
+
+OperationReplayer::~OperationReplayer()
+{
+  clear();
+}
+
+}  // end of namespace chai
@@ -0,0 +1,232 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#ifndef CHAI_OperationLog_HPP
+#define CHAI_OperationLog_HPP
+
+#include "chai/config.hpp"
+#include "chai/ExecutionSpaces.hpp"
+#include "chai/PointerRecord.hpp"
+#include "chai/Types.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace chai
+{
+
+/*!
+ * \brief Operations of the ArrayManager kept in an operation log.
+ */
+enum Operation {
+  OPERATION_ALLOCATE = 1,
+  OPERATION_FREE,
+  OPERATION_REALLOCATE,
+  OPERATION_CAPTURE,
+  OPERATION_TOUCH,
+  OPERATION_EVICT,
+  OPERATION_SET_SPACE
+};
+
+/*!
+ * \brief Singleton writing the operations of the ArrayManager to a compact
+ *        binary log.
+ *
+ * Arrays are identified in the log by a number given to their record the
+ * first time it is seen, and an array that was not allocated by the
+ * ArrayManager is logged as allocated in its first space when it is first
+ * seen. Each operation takes two bytes, followed by variable-length integers
+ * for the array and size it applies to, so a log stays small enough to keep
+ * for a whole production run.
+ *
+ * A log is replayed by OperationReplayer, or the chai-replay executable,
+ * without the application that wrote it.
+ *
+ * Recording is off by default, and costs a single check per operation while
+ * it is off. Setting the CHAI_RECORD environment variable to a file name
+ * records the whole run to that file.
+ */
+class OperationRecorder
+{
+public:
+  /*!
+   * \brief Get the singleton instance.
+   *
+   * \return Pointer to the OperationRecorder instance.
+   */
+  CHAISHAREDDLL_API static OperationRecorder* getInstance();
+
+  /*!
+   * \brief Stop recording.
+   */
+  ~OperationRecorder();
+
+  /*!
+   * \brief Start recording to the file at path, replacing it.
+   *
+   * \return false if the file could not be opened.
+   */
+  CHAISHAREDDLL_API bool start(std::string const& path);
+
+  /*!
+   * \brief Stop recording, and write what is left to the file.
+   */
+  CHAISHAREDDLL_API void stop();
+
+  /*!
+   * \brief Whether operations are being recorded.
+   */
+  bool isRecording() const
+  {
+    return m_recording.load(std::memory_order_relaxed);
+  }
+
+  /*!
+   * \brief Record an operation on an array.
+   *
+   * \param operation The operation.
+   * \param record The record of the array.
+   * \param space The execution space of the operation.
+   * \param value Size in bytes for allocations and reallocations, and whether
+   *        the array may be written for captures.
+   */
+  void record(Operation operation,
+              PointerRecord const* record,
+              ExecutionSpace space,
+              size_t value = 0)
+  {
+    if (isRecording()) {
+      append(operation, record, space, NONE, value);
+    }
+  }
+
+  /*!
+   * \brief Record an operation that applies to no array.
+   *
+   * \param operation OPERATION_SET_SPACE or OPERATION_EVICT.
+   * \param space The space set, or evicted.
+   * \param destination The space evicted to.
+   */
+  void record(Operation operation,
+              ExecutionSpace space,
+              ExecutionSpace destination = NONE)
+  {
+    if (isRecording()) {
+      append(operation, nullptr, space, destination, 0);
+    }
+  }
+
+  /*!
+   * \brief Forget a record that is about to be deleted.
+   */
+  void forget(PointerRecord const* record)
+  {
+    if (isRecording()) {
+      forgetRecord(record);
+    }
+  }
+
+protected:
+  /*!
+   * \brief Construct a new OperationRecorder.
+   *
+   * The constructor is a protected member, ensuring that it can
+   * only be called by the singleton getInstance method.
+   */
+  OperationRecorder();
+
+private:
+  CHAISHAREDDLL_API void append(Operation operation,
+                                PointerRecord const* record,
+                                ExecutionSpace space,
+                                ExecutionSpace other,
+                                size_t value);
+
+  CHAISHAREDDLL_API void forgetRecord(PointerRecord const* record);
+
+  /*!
+   * \brief Write an operation to the buffer.
+   */
+  void write(Operation operation,
+             ExecutionSpace space,
+             ExecutionSpace other,
+             bool flag,
+             std::uint64_t id,
+             std::uint64_t size);
+
+  void flush();
+
+  std::atomic<bool> m_recording;
+
+  std::mutex m_mutex;
+
+  std::ofstream m_file;
+
+  std::vector<unsigned char> m_buffer;
+
+  /*!
+   * Number of the array of every record seen.
+   */
+  std::unordered_map<PointerRecord const*, std::uint64_t> m_ids;
+
+  std::uint64_t m_next_id;
+};
+
+/*!
+ * \brief Drives the ArrayManager with the operations of a log written by
+ *        OperationRecorder.
+ *
+ * Every array of the log is replayed as an array of bytes. Spaces
+ * that do not exist in the replaying build are replayed on the CPU, so that a
+ * log written on a GPU machine can be replayed in GPU simulation mode.
+ */
+class OperationReplayer
+{
+public:
+  /*!
+   * \brief Replay the log at path.
+   *
+   * \return false if the file is not a log, or ends in the middle of an
+   *         operation. The operations before that point are replayed.
+   */
+  CHAISHAREDDLL_API bool replay(std::string const& path);
+
+  /*!
+   * \brief Replay a log read from stream.
+   */
+  CHAISHAREDDLL_API bool replay(std::istream& stream);
+
+  /*!
+   * \brief Get the number of operations replayed.
+   */
+  size_t getNumOperations() const { return m_num_operations; }
+
+  /*!
+   * \brief Free the arrays left allocated by the log.
+   */
+  CHAISHAREDDLL_API void clear();
+
+  CHAISHAREDDLL_API ~OperationReplayer();
+
+private:
+  size_t m_num_operations = 0;
+
+  /*!
+   * Records of the arrays of the log, by number.
+   */
+  std::unordered_map<std::uint64_t, PointerRecord*> m_records;
+};
+
+}  // end of namespace chai
+
+#endif  // CHAI_OperationLog_HPP
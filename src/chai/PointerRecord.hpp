@@ -7,10 +7,12 @@
 #ifndef CHAI_PointerRecord_HPP
 #define CHAI_PointerRecord_HPP
 
+#include "chai/Event.hpp"
 #include "chai/ExecutionSpaces.hpp"
 #include "chai/Types.hpp"
 
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 
 namespace chai
@@ -56,16 +58,40 @@ struct PointerRecord {
 
   int m_allocators[NUM_EXECUTION_SPACES];
 
+  /*!
+   * Completion of the last asynchronous kernel that captured this array.
+   */
+  Event m_event;
+
+  /*!
+   * Name of the array, or null. Names must have static storage, such as
+   * string literals, so that records can share them without copying.
+   */
+  const char* m_name;
+
+  /*!
+   * Whether the allocation in each execution space is accounted in the
+   * TagStatistics, which only accounts the memory allocated while it is on.
+   */
+  bool m_tagged[NUM_EXECUTION_SPACES];
+
+  /*!
+   * Changed by the ArrayManager whenever the state of the record changes, so
+   * that a cached capture can tell that the record is as it left it.
+   */
+  std::uint64_t m_generation;
+
   /*!
    * \brief Default constructor
    *
    */
-  PointerRecord() : m_size(0), m_last_space(NONE) { 
+  PointerRecord() : m_size(0), m_last_space(NONE), m_name(nullptr), m_generation(0) { 
      m_user_callback = [] (const PointerRecord*, Action, ExecutionSpace) {};
      for (int space = 0; space < NUM_EXECUTION_SPACES; ++space ) {
         m_pointers[space] = nullptr;
         m_touched[space] = false;
         m_owned[space] = true;
+        m_tagged[space] = false;
         m_allocators[space] = 0;
      }
   }
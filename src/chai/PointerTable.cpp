@@ -0,0 +1,115 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#include "chai/PointerTable.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace chai
+{
+
+PointerTable::PointerTable(std::vector<PointerRecord*> records,
+                           std::vector<size_t> offsets) :
+  m_records{std::move(records)},
+  m_offsets{std::move(offsets)},
+  m_tables{},
+  m_contents{},
+  m_staging{nullptr},
+  m_references{0}
+{
+}
+
+PointerTable::~PointerTable()
+{
+  ArrayManager* manager = ArrayManager::getInstance();
+
+  bool device_tables = false;
+  for (int space = CPU + 1; space < NUM_EXECUTION_SPACES; ++space) {
+    device_tables = device_tables || m_tables[space];
+  }
+
+  // Kernels launched with the tables may still be reading them
+  if (device_tables) {
+    synchronize();
+  }
+
+  for (int space = CPU; space < NUM_EXECUTION_SPACES; ++space) {
+    if (m_tables[space]) {
+      manager->getAllocator(static_cast<ExecutionSpace>(space))
+          .deallocate(m_tables[space]);
+    }
+  }
+
+  if (m_staging) {
+    manager->getAllocator(CPU).deallocate(m_staging);
+  }
+}
+
+void** PointerTable::capture(ExecutionSpace space, bool touch)
+{
+  if (space == NONE) {
+    return nullptr;
+  }
+
+  ArrayManager::getInstance()->move(m_records.data(),
+                                    m_records.size(),
+                                    space,
+                                    touch);
+
+  return get(space);
+}
+
+void** PointerTable::get(ExecutionSpace space)
+{
+  if (space == NONE || m_records.empty()) {
+    return nullptr;
+  }
+
+  std::vector<void*> pointers(m_records.size(), nullptr);
+
+  for (size_t i = 0; i < m_records.size(); ++i) {
+    char* base = static_cast<char*>(m_records[i]->m_pointers[space]);
+    if (base) {
+      pointers[i] = base + m_offsets[i];
+    }
+  }
+
+  void**& table = m_tables[space];
+
+  if (table && pointers == m_contents[space]) {
+    return table;
+  }
+
+  ArrayManager* manager = ArrayManager::getInstance();
+  const size_t bytes = pointers.size() * sizeof(void*);
+
+  if (table) {
+    // Kernels launched with the old contents may still be reading them
+    if (space != CPU) {
+      synchronize();
+    }
+  } else {
+    table = static_cast<void**>(manager->getAllocator(space).allocate(bytes));
+  }
+
+  if (space == CPU) {
+    std::copy(pointers.begin(), pointers.end(), table);
+  } else {
+    if (!m_staging) {
+      m_staging = static_cast<void**>(manager->getAllocator(CPU).allocate(bytes));
+    }
+
+    std::copy(pointers.begin(), pointers.end(), m_staging);
+    manager->copy(table, m_staging, bytes);
+  }
+
+  m_contents[space] = std::move(pointers);
+
+  return table;
+}
+
+}  // end of namespace chai
@@ -0,0 +1,157 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#ifndef CHAI_PointerTable_HPP
+#define CHAI_PointerTable_HPP
+
+#include "chai/config.hpp"
+#include "chai/ArrayManager.hpp"
+#include "chai/ExecutionSpaces.hpp"
+#include "chai/ManagedArray.hpp"
+#include "chai/PointerRecord.hpp"
+#include "chai/Types.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace chai
+{
+
+/*!
+ * \brief Table of the pointers to a set of ManagedArrays, kept in every
+ *        execution space.
+ *
+ * Capturing the table moves all of its arrays to a space as one batch, and
+ * returns an array of their pointers in that space, allocated in that space
+ * so that kernels running there can index it. The table of a space is
+ * allocated once, and only rewritten when the arrays have moved to
+ * different addresses since it was last written.
+ */
+class PointerTable
+{
+public:
+  /*!
+   * \brief Create a table of count arrays.
+   *
+   * The arrays must outlive the table. Slices keep their offset.
+   */
+  template <typename T>
+  CHAI_HOST PointerTable(ManagedArray<T> const* arrays, size_t count);
+
+  /*!
+   * \brief Create a table of count records.
+   *
+   * \param records The records of the arrays.
+   * \param offsets Offset, in bytes, of every array from the start of its
+   *        record's allocation.
+   */
+  CHAISHAREDDLL_API PointerTable(std::vector<PointerRecord*> records,
+                                 std::vector<size_t> offsets);
+
+  /*!
+   * \brief Free the table in every space. The arrays are left alone.
+   */
+  CHAISHAREDDLL_API ~PointerTable();
+
+  PointerTable(PointerTable const&) = delete;
+  PointerTable& operator=(PointerTable const&) = delete;
+
+  /*!
+   * \brief Move every array to space as one batch, and get the table there.
+   *
+   * \param space The execution space to capture the arrays in.
+   * \param touch Whether the arrays may be written in space.
+   *
+   * \return The pointers of the arrays in space, readable in space.
+   */
+  CHAISHAREDDLL_API void** capture(ExecutionSpace space, bool touch);
+
+  /*!
+   * \brief Get the table of the pointers the arrays have in space, without
+   *        moving them.
+   *
+   * Arrays that are not allocated in space have a null pointer.
+   */
+  CHAISHAREDDLL_API void** get(ExecutionSpace space);
+
+  /*!
+   * \brief Get the number of arrays in the table.
+   */
+  size_t size() const { return m_records.size(); }
+
+  /*!
+   * \brief Add a reference to a table created with new.
+   */
+  void retain() { m_references.fetch_add(1, std::memory_order_relaxed); }
+
+  /*!
+   * \brief Drop a reference to the table, deleting it with the last one.
+   */
+  void release()
+  {
+    if (m_references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      delete this;
+    }
+  }
+
+private:
+  /*!
+   * Records of the arrays.
+   */
+  std::vector<PointerRecord*> m_records;
+
+  /*!
+   * Offset of every array in its allocation, in bytes.
+   */
+  std::vector<size_t> m_offsets;
+
+  /*!
+   * Table of every space, or null if it was never needed.
+   */
+  void** m_tables[NUM_EXECUTION_SPACES];
+
+  /*!
+   * Pointers last written to the table of every space.
+   */
+  std::vector<void*> m_contents[NUM_EXECUTION_SPACES];
+
+  /*!
+   * Host buffer the tables of other spaces are copied from.
+   */
+  void** m_staging;
+
+  /*!
+   * Number of references to the table.
+   */
+  std::atomic<int> m_references;
+};
+
+template <typename T>
+CHAI_HOST PointerTable::PointerTable(ManagedArray<T> const* arrays,
+                                     size_t count) :
+  PointerTable(std::vector<PointerRecord*>(count, &ArrayManager::s_null_record),
+               std::vector<size_t>(count, 0))
+{
+  using T_non_const = typename std::remove_const<T>::type;
+
+  ArrayManager* manager = ArrayManager::getInstance();
+
+  for (size_t i = 0; i < count; ++i) {
+    T* base = arrays[i].getActiveBasePointer();
+
+    if (base) {
+      m_records[i] =
+          manager->getPointerRecord(const_cast<T_non_const*>(base));
+      m_offsets[i] = (arrays[i].getActivePointer() - base) * sizeof(T);
+    }
+  }
+}
+
+}  // end of namespace chai
+
+#endif  // CHAI_PointerTable_HPP
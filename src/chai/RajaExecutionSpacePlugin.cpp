@@ -10,34 +10,78 @@
 
 #include "chai/ArrayManager.hpp"
 
+#include <algorithm>
+
 namespace chai {
 
 RajaExecutionSpacePlugin::RajaExecutionSpacePlugin() :
-  m_arraymanager(chai::ArrayManager::getInstance())
+  m_arraymanager(chai::ArrayManager::getInstance()),
+  m_warned_platforms{0}
 {
 }
 
 void
 RajaExecutionSpacePlugin::preCapture(const RAJA::util::PluginContext& p)
 {
+  // The body is captured once per launch, on the launching thread. Copies
+  // made afterwards, such as the private copy each OpenMP thread takes, see
+  // the NONE space and do not move anything.
   switch (p.platform) {
+    case RAJA::Platform::undefined:
+      m_arraymanager->setExecutionSpace(chai::NONE); break;
     case RAJA::Platform::host:
       m_arraymanager->setExecutionSpace(chai::CPU); break;
 #if defined(CHAI_ENABLE_CUDA)
     case RAJA::Platform::cuda:
       m_arraymanager->setExecutionSpace(chai::GPU); break;
+#endif
+#if defined(CHAI_ENABLE_HIP)
+    case RAJA::Platform::hip:
+      m_arraymanager->setExecutionSpace(chai::GPU); break;
+#endif
+#if defined(CHAI_ENABLE_CUDA) || defined(CHAI_ENABLE_HIP)
+    // Target regions run on the same device as the CUDA or HIP kernels
+    case RAJA::Platform::omp_target:
+      m_arraymanager->setExecutionSpace(chai::GPU); break;
 #endif
     default:
+      warnUnsupported(p.platform);
       m_arraymanager->setExecutionSpace(chai::NONE);
   }
 }
 
+void
+RajaExecutionSpacePlugin::warnUnsupported(RAJA::Platform platform)
+{
+  // Platforms past the width of the mask share its last bit
+  const unsigned index = std::min(static_cast<unsigned>(platform),
+                                  unsigned(sizeof(unsigned) * 8 - 1));
+  const unsigned bit = 1u << index;
+
+  if (m_warned_platforms.load(std::memory_order_relaxed) & bit) {
+    return;
+  }
+
+  if (!(m_warned_platforms.fetch_or(bit, std::memory_order_relaxed) & bit)) {
+    CHAI_LOG(Warning, "RAJA platform " << static_cast<int>(platform)
+             << " has no CHAI execution space, data will not be moved");
+  }
+}
+
 void
 RajaExecutionSpacePlugin::postCapture(const RAJA::util::PluginContext&)
 {
   m_arraymanager->setExecutionSpace(chai::NONE);
 }
 
+void
+RajaExecutionSpacePlugin::postLaunch(const RAJA::util::PluginContext&)
+{
+  // Kernels launched on a resource set with ArrayManager::setResource are
+  // queued by now, so their event follows them
+  m_arraymanager->recordLaunchEvent();
+}
+
 }
 RAJA_INSTANTIATE_REGISTRY(RAJA::util::PluginRegistry);
 
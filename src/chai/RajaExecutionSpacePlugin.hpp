@@ -9,6 +9,8 @@
 
 #include "RAJA/util/PluginStrategy.hpp"
 
+#include <atomic>
+
 namespace chai {
 
 class ArrayManager;
@@ -23,8 +25,21 @@ class RajaExecutionSpacePlugin :
 
     void postCapture(const RAJA::util::PluginContext& p) override;
 
+    void postLaunch(const RAJA::util::PluginContext& p) override;
+
   private:
+    /*!
+     * \brief Warn that platform has no execution space, the first time it
+     *        is launched on.
+     */
+    void warnUnsupported(RAJA::Platform platform);
+
     chai::ArrayManager* m_arraymanager;
+
+    /*!
+     * Bit i is set once platform i was warned about.
+     */
+    std::atomic<unsigned> m_warned_platforms;
 };
 
 void linkRajaPlugin();
@@ -0,0 +1,284 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#ifndef CHAI_Reducers_HPP
+#define CHAI_Reducers_HPP
+
+#include "chai/config.hpp"
+#include "chai/ChaiMacros.hpp"
+#include "chai/ManagedArray.hpp"
+#include "chai/ThreadPool.hpp"
+
+#include <cstddef>
+
+namespace chai
+{
+
+/*!
+ * \brief Tag base class of all reducers.
+ */
+struct ReducerBase {
+};
+
+/*!
+ * \brief Reduction over the threads of the ThreadPool.
+ *
+ * Every thread of the pool accumulates into a private slot, and the slots
+ * are combined when the result is needed. Slots are a cache line apart so
+ * that threads updating neighbouring slots do not share a line. The slots are
+ * held in a ManagedArray, so capturing a reducer in a loop body moves them to
+ * the space the loop runs in, and the combined result stays there until it
+ * is read.
+ *
+ * Reducers are copied into loop bodies like ManagedArrays, and all copies
+ * share the same slots, which must be released with free. The ThreadPool must
+ * not grow while a reducer is in use. Slots are indexed by ThreadPool thread,
+ * so reducers are updated on the host threads or the simulated device only.
+ *
+ * \tparam T Type of the values reduced.
+ * \tparam REDUCE_OP Callable combining two values of type T.
+ */
+template <typename T, typename REDUCE_OP>
+class Reducer : public ReducerBase
+{
+public:
+  /*!
+   * \brief Create a reducer.
+   *
+   * \param identity Value every slot starts from.
+   */
+  CHAI_HOST Reducer(T identity) :
+    m_values(),
+    m_identity(identity),
+    m_num_slots(ThreadPool::getInstance()->getNumThreads()),
+    m_stride((64 + sizeof(T) - 1) / sizeof(T))
+  {
+    m_values.allocate(m_num_slots * m_stride, CPU);
+
+    T* values = m_values.data();
+    for (size_t slot = 0; slot < m_num_slots; ++slot) {
+      values[slot * m_stride] = m_identity;
+    }
+  }
+
+  /*!
+   * \brief Combine the slots on the host and return the result.
+   */
+  CHAI_HOST T get() const
+  {
+    const T* values = m_values.cdata();
+
+    T result = m_identity;
+    for (size_t slot = 0; slot < m_num_slots; ++slot) {
+      result = REDUCE_OP()(result, values[slot * m_stride]);
+    }
+
+    return result;
+  }
+
+  /*!
+   * \brief Get an array holding the combined result once combineSlots has
+   *        run, in whatever space it ran in.
+   */
+  CHAI_HOST ManagedArray<T> getManaged() const
+  {
+    return m_values.slice(0, 1);
+  }
+
+  /*!
+   * \brief Set every slot back to the identity, in the current space.
+   */
+  CHAI_HOST void resetSlots() const
+  {
+    for (size_t slot = 0; slot < m_num_slots; ++slot) {
+      m_values[slot * m_stride] = m_identity;
+    }
+  }
+
+  /*!
+   * \brief Combine every slot into the first, in the current space.
+   */
+  CHAI_HOST void combineSlots() const
+  {
+    T result = m_values[0];
+    for (size_t slot = 1; slot < m_num_slots; ++slot) {
+      result = REDUCE_OP()(result, m_values[slot * m_stride]);
+      m_values[slot * m_stride] = m_identity;
+    }
+
+    m_values[0] = result;
+  }
+
+  /*!
+   * \brief Release the slots.
+   */
+  CHAI_HOST void free()
+  {
+    m_values.free();
+  }
+
+protected:
+  /*!
+   * \brief Slot of the calling thread.
+   */
+  CHAI_HOST T& slot() const
+  {
+    return m_values[ThreadPool::getThreadId() * m_stride];
+  }
+
+  ManagedArray<T> m_values;
+
+  T m_identity;
+
+  size_t m_num_slots;
+
+  /*!
+   * Distance between slots, in elements.
+   */
+  size_t m_stride;
+};
+
+/*!
+ * \brief Functors combining two values for the reducers.
+ */
+struct ReduceSumOp {
+  template <typename T>
+  CHAI_HOST_DEVICE T operator()(T a, T b) const { return a + b; }
+};
+
+struct ReduceMinOp {
+  template <typename T>
+  CHAI_HOST_DEVICE T operator()(T a, T b) const { return b < a ? b : a; }
+};
+
+struct ReduceMaxOp {
+  template <typename T>
+  CHAI_HOST_DEVICE T operator()(T a, T b) const { return a < b ? b : a; }
+};
+
+/*!
+ * \brief Sum of the values added with +=.
+ */
+template <typename T>
+class ReduceSum : public Reducer<T, ReduceSumOp>
+{
+public:
+  CHAI_HOST ReduceSum(T identity = T(0)) : Reducer<T, ReduceSumOp>(identity) {}
+
+  CHAI_HOST ReduceSum const& operator+=(T value) const
+  {
+    this->slot() += value;
+    return *this;
+  }
+};
+
+/*!
+ * \brief Smallest of the values passed to min.
+ */
+template <typename T>
+class ReduceMin : public Reducer<T, ReduceMinOp>
+{
+public:
+  CHAI_HOST ReduceMin(T identity) : Reducer<T, ReduceMinOp>(identity) {}
+
+  CHAI_HOST ReduceMin const& min(T value) const
+  {
+    T& slot = this->slot();
+    slot = ReduceMinOp()(slot, value);
+    return *this;
+  }
+};
+
+/*!
+ * \brief Largest of the values passed to max.
+ */
+template <typename T>
+class ReduceMax : public Reducer<T, ReduceMaxOp>
+{
+public:
+  CHAI_HOST ReduceMax(T identity) : Reducer<T, ReduceMaxOp>(identity) {}
+
+  CHAI_HOST ReduceMax const& max(T value) const
+  {
+    T& slot = this->slot();
+    slot = ReduceMaxOp()(slot, value);
+    return *this;
+  }
+};
+
+/*!
+ * \brief Value and location pair reduced by ReduceMinLoc.
+ */
+template <typename T, typename INDEX_TYPE>
+struct ValueLoc {
+  T value;
+  INDEX_TYPE loc;
+};
+
+/*!
+ * \brief Orders ValueLocs by value, then by location.
+ *
+ * Taking the smaller location on ties makes the result independent of how
+ * the loop was split across threads.
+ */
+struct ReduceMinLocOp {
+  template <typename T, typename INDEX_TYPE>
+  CHAI_HOST_DEVICE ValueLoc<T, INDEX_TYPE> operator()(
+      ValueLoc<T, INDEX_TYPE> a,
+      ValueLoc<T, INDEX_TYPE> b) const
+  {
+    return (b.value < a.value || (!(a.value < b.value) && b.loc < a.loc)) ? b
+                                                                         : a;
+  }
+};
+
+/*!
+ * \brief Smallest of the values passed to minloc, with its location.
+ */
+template <typename T, typename INDEX_TYPE = int>
+class ReduceMinLoc
+    : public Reducer<ValueLoc<T, INDEX_TYPE>, ReduceMinLocOp>
+{
+public:
+  using value_loc = ValueLoc<T, INDEX_TYPE>;
+
+  /*!
+   * \param identity Value larger than any value reduced.
+   * \param loc Location reported if nothing smaller than identity is found.
+   */
+  CHAI_HOST ReduceMinLoc(T identity, INDEX_TYPE loc = INDEX_TYPE(-1)) :
+    Reducer<value_loc, ReduceMinLocOp>(value_loc{identity, loc})
+  {
+  }
+
+  CHAI_HOST ReduceMinLoc const& minloc(T value, INDEX_TYPE loc) const
+  {
+    value_loc& slot = this->slot();
+    slot = ReduceMinLocOp()(slot, value_loc{value, loc});
+    return *this;
+  }
+
+  /*!
+   * \brief Combine the slots on the host and return the smallest value.
+   */
+  CHAI_HOST T get() const
+  {
+    return Reducer<value_loc, ReduceMinLocOp>::get().value;
+  }
+
+  /*!
+   * \brief Combine the slots on the host and return the location of the
+   *        smallest value.
+   */
+  CHAI_HOST INDEX_TYPE getLoc() const
+  {
+    return Reducer<value_loc, ReduceMinLocOp>::get().loc;
+  }
+};
+
+}  // end of namespace chai
+
+#endif  // CHAI_Reducers_HPP
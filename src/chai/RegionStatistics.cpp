@@ -0,0 +1,330 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#include "chai/RegionStatistics.hpp"
+
+#include "chai/ChaiMacros.hpp"
+#include "chai/Instrumentation.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace chai
+{
+
+namespace {
+
+const char* const s_root_name = "";
+
+thread_local Region* s_current_region = nullptr;
+
+const char* spaceName(int space)
+{
+  switch (space) {
+    case CPU:
+      return "CPU";
+    case GPU:
+      return "GPU";
+    case UM:
+      return "UM";
+    case PINNED:
+      return "PINNED";
+    default:
+      return "NONE";
+  }
+}
+
+bool sameName(const char* a, const char* b)
+{
+  return a == b || std::strcmp(a, b) == 0;
+}
+
+}  // end of anonymous namespace
+
+Region::Region(const char* name, Region* parent) :
+  m_name{name},
+  m_parent{parent},
+  m_first_child{nullptr},
+  m_next_sibling{nullptr},
+  m_entries{0},
+  m_captures{0},
+  m_allocations{0},
+  m_bytes_allocated{0}
+{
+  for (int space = 0; space < NUM_EXECUTION_SPACES; ++space) {
+    m_bytes_moved[space] = 0;
+  }
+}
+
+Region::~Region()
+{
+  Region* child = m_first_child.load(std::memory_order_acquire);
+  while (child) {
+    Region* next = child->m_next_sibling;
+    delete child;
+    child = next;
+  }
+}
+
+std::string Region::getPath() const
+{
+  if (!m_parent) {
+    return "";
+  }
+
+  const std::string parent = m_parent->getPath();
+  return parent.empty() ? std::string(m_name) : parent + "/" + m_name;
+}
+
+Region* Region::child(const char* name)
+{
+  Region* head = m_first_child.load(std::memory_order_acquire);
+  Region* searched = nullptr;
+  Region* created = nullptr;
+
+  while (true) {
+    // Only the children added since the last search need to be searched
+    for (Region* region = head; region != searched;
+         region = region->m_next_sibling) {
+      if (sameName(region->m_name, name)) {
+        delete created;
+        return region;
+      }
+    }
+
+    if (!created) {
+      created = new Region(name, this);
+    }
+
+    searched = head;
+    created->m_next_sibling = head;
+
+    if (m_first_child.compare_exchange_weak(head, created,
+                                            std::memory_order_release,
+                                            std::memory_order_acquire)) {
+      return created;
+    }
+  }
+}
+
+RegionStatistics* RegionStatistics::getInstance()
+{
+  static RegionStatistics s_region_statistics_instance;
+  return &s_region_statistics_instance;
+}
+
+RegionStatistics::RegionStatistics() :
+  m_enabled{false},
+  m_root{s_root_name, nullptr},
+  m_output{}
+{
+  const char* env = std::getenv("CHAI_REGION_STATISTICS");
+  if (env && *env) {
+    m_output = env;
+    setEnabled(true);
+  }
+}
+
+RegionStatistics::~RegionStatistics()
+{
+  if (m_output.empty()) {
+    return;
+  }
+
+  if (m_output == "1") {
+    report(std::cerr);
+  } else {
+    std::ofstream file(m_output);
+    report(file);
+  }
+}
+
+void RegionStatistics::setEnabled(bool enabled)
+{
+  m_enabled = enabled;
+  Instrumentation::setEnabled(INSTRUMENT_REGION_STATISTICS, enabled);
+}
+
+Region* RegionStatistics::current()
+{
+  return s_current_region ? s_current_region : &getInstance()->m_root;
+}
+
+Region* RegionStatistics::setCurrent(Region* region)
+{
+  Region* previous = s_current_region;
+  s_current_region = region;
+  return previous;
+}
+
+void RegionStatistics::push(const char* name)
+{
+  Region* parent = s_current_region;
+  if (!parent) {
+    parent = &getInstance()->m_root;
+  }
+
+  // Check the newest child inline before searching the others
+  Region* region = parent->m_first_child.load(std::memory_order_acquire);
+  if (!region || region->m_name != name) {
+    region = parent->child(name);
+  }
+
+  region->m_entries.fetch_add(1, std::memory_order_relaxed);
+  s_current_region = region;
+}
+
+void RegionStatistics::pop()
+{
+  Region* region = s_current_region;
+
+  if (!region || !region->m_parent) {
+    CHAI_LOG(Warning, "popRegion called outside of any region");
+    return;
+  }
+
+  s_current_region = region->m_parent;
+}
+
+std::vector<RegionStatistics::Entry> RegionStatistics::getEntries() const
+{
+  std::vector<Entry> entries;
+  collect(&m_root, 0, entries);
+  return entries;
+}
+
+RegionStatistics::Entry RegionStatistics::collect(
+    Region const* region,
+    int depth,
+    std::vector<Entry>& entries) const
+{
+  const size_t index = entries.size();
+
+  Entry entry;
+  entry.path = region->getPath();
+  entry.depth = depth;
+  entry.entries = region->m_entries.load(std::memory_order_relaxed);
+  entry.captures = region->m_captures.load(std::memory_order_relaxed);
+  entry.allocations = region->m_allocations.load(std::memory_order_relaxed);
+  entry.bytes_allocated =
+      region->m_bytes_allocated.load(std::memory_order_relaxed);
+  for (int space = 0; space < NUM_EXECUTION_SPACES; ++space) {
+    entry.bytes_moved[space] =
+        region->m_bytes_moved[space].load(std::memory_order_relaxed);
+  }
+
+  entries.push_back(entry);
+
+  // Children are listed newest first, but are reported in the order entered
+  std::vector<Region const*> children;
+  for (Region const* child = region->m_first_child.load(std::memory_order_acquire);
+       child; child = child->m_next_sibling) {
+    children.push_back(child);
+  }
+
+  for (auto child = children.rbegin(); child != children.rend(); ++child) {
+    const Entry total = collect(*child, depth + 1, entries);
+
+    Entry& inclusive = entries[index];
+    inclusive.captures += total.captures;
+    inclusive.allocations += total.allocations;
+    inclusive.bytes_allocated += total.bytes_allocated;
+    for (int space = 0; space < NUM_EXECUTION_SPACES; ++space) {
+      inclusive.bytes_moved[space] += total.bytes_moved[space];
+    }
+  }
+
+  return entries[index];
+}
+
+void RegionStatistics::report(std::ostream& stream) const
+{
+  const std::vector<Entry> entries = getEntries();
+  Entry const& total = entries.front();
+
+  std::vector<std::string> names;
+  size_t name_width = 6;
+
+  for (Entry const& entry : entries) {
+    std::string name;
+    if (entry.depth == 0) {
+      name = "(program)";
+    } else {
+      const size_t slash = entry.path.rfind('/');
+      name = std::string(2 * entry.depth, ' ') +
+             (slash == std::string::npos ? entry.path
+                                         : entry.path.substr(slash + 1));
+    }
+
+    names.push_back(name);
+    name_width = std::max(name_width, name.size());
+  }
+
+  stream << std::left << std::setw(name_width) << "region" << std::right
+         << std::setw(10) << "entries"
+         << std::setw(10) << "captures"
+         << std::setw(8) << "allocs"
+         << std::setw(16) << "bytes allocated";
+
+  for (int space = CPU; space < NUM_EXECUTION_SPACES; ++space) {
+    if (total.bytes_moved[space]) {
+      stream << std::setw(16)
+             << (std::string("moved to ") + spaceName(space))
+             << std::setw(8) << "%";
+    }
+  }
+
+  stream << "\n";
+
+  for (size_t i = 0; i < entries.size(); ++i) {
+    Entry const& entry = entries[i];
+
+    stream << std::left << std::setw(name_width) << names[i] << std::right
+           << std::setw(10) << entry.entries
+           << std::setw(10) << entry.captures
+           << std::setw(8) << entry.allocations
+           << std::setw(16) << entry.bytes_allocated;
+
+    for (int space = CPU; space < NUM_EXECUTION_SPACES; ++space) {
+      if (total.bytes_moved[space]) {
+        stream << std::setw(16) << entry.bytes_moved[space]
+               << std::setw(8) << std::fixed << std::setprecision(1)
+               << 100.0 * entry.bytes_moved[space] / total.bytes_moved[space];
+      }
+    }
+
+    stream << "\n";
+  }
+}
+
+void RegionStatistics::clear()
+{
+  std::vector<Region*> regions{&m_root};
+
+  while (!regions.empty()) {
+    Region* region = regions.back();
+    regions.pop_back();
+
+    region->m_entries = 0;
+    region->m_captures = 0;
+    region->m_allocations = 0;
+    region->m_bytes_allocated = 0;
+    for (int space = 0; space < NUM_EXECUTION_SPACES; ++space) {
+      region->m_bytes_moved[space] = 0;
+    }
+
+    for (Region* child = region->m_first_child.load(std::memory_order_acquire);
+         child; child = child->m_next_sibling) {
+      regions.push_back(child);
+    }
+  }
+}
+
+}  // end of namespace chai
@@ -0,0 +1,294 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#ifndef CHAI_RegionStatistics_HPP
+#define CHAI_RegionStatistics_HPP
+
+#include "chai/config.hpp"
+#include "chai/ExecutionSpaces.hpp"
+#include "chai/Types.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace chai
+{
+
+/*!
+ * \brief A region of the program, annotated with pushRegion and popRegion.
+ *
+ * Regions form a tree: a region pushed while another is current is its
+ * child. The ArrayManager adds the captures, allocations and moves it makes
+ * to the current region of the thread making them. Regions are only
+ * deleted with the RegionStatistics singleton, so pointers to them stay
+ * valid until the end of the program.
+ */
+class Region
+{
+public:
+  /*!
+   * \brief Get the name of the region, or an empty string for the root.
+   */
+  const char* getName() const { return m_name; }
+
+  /*!
+   * \brief Get the enclosing region, or null for the root.
+   */
+  Region const* getParent() const { return m_parent; }
+
+  /*!
+   * \brief Get the names of the enclosing regions and of this region,
+   *        separated by slashes.
+   */
+  CHAISHAREDDLL_API std::string getPath() const;
+
+  void recordCapture()
+  {
+    m_captures.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void recordAllocation(size_t size)
+  {
+    m_allocations.fetch_add(1, std::memory_order_relaxed);
+    m_bytes_allocated.fetch_add(size, std::memory_order_relaxed);
+  }
+
+  void recordMove(ExecutionSpace destination, size_t size)
+  {
+    m_bytes_moved[destination].fetch_add(size, std::memory_order_relaxed);
+  }
+
+private:
+  friend class RegionStatistics;
+
+  Region(const char* name, Region* parent);
+
+  /*!
+   * \brief Delete the regions enclosed by this region.
+   */
+  ~Region();
+
+  Region(Region const&) = delete;
+  Region& operator=(Region const&) = delete;
+
+  /*!
+   * \brief Get the child region named name, creating it if needed.
+   */
+  Region* child(const char* name);
+
+  const char* m_name;
+
+  Region* m_parent;
+
+  /*!
+   * Children are a list that is only ever prepended to, so it is searched
+   * without a lock.
+   */
+  std::atomic<Region*> m_first_child;
+
+  Region* m_next_sibling;
+
+  std::atomic<std::uint64_t> m_entries;
+  std::atomic<std::uint64_t> m_captures;
+  std::atomic<std::uint64_t> m_allocations;
+  std::atomic<std::uint64_t> m_bytes_allocated;
+  std::atomic<std::uint64_t> m_bytes_moved[NUM_EXECUTION_SPACES];
+};
+
+/*!
+ * \brief Singleton keeping the tree of regions and their statistics.
+ *
+ * Each thread has a stack of regions. pushRegion enters a child of the
+ * current region of the thread and popRegion leaves it, so regions nest.
+ * Entering a region looks up its name among the children of the current
+ * region, comparing pointers before strings, which takes a few nanoseconds
+ * for names with static storage such as string literals. The statistics of
+ * a region include those of the regions it encloses.
+ *
+ * Besides the traffic of each region, the region of every kernel in
+ * KernelStatistics and TransferChecker, of every move in ArrayStatistics, of
+ * every Tracer event, of the peaks in TagStatistics and of the sites in
+ * AllocationProfiler is recorded, and Metrics snapshots hold the traffic of
+ * every region. ThreadPool workers run in the region of the thread that
+ * launched the loop.
+ *
+ * The ArrayManager only adds its traffic to the regions while collection is
+ * on. Setting the CHAI_REGION_STATISTICS environment variable turns it on,
+ * and prints the tree of regions at shutdown: to standard error if the
+ * variable is 1, and to the file it names otherwise.
+ */
+class RegionStatistics
+{
+public:
+  /*!
+   * \brief Totals of one region, including the regions it encloses.
+   */
+  struct Entry {
+    std::string path;
+
+    /*!
+     * Number of regions enclosing the region.
+     */
+    int depth = 0;
+
+    size_t entries = 0;
+    size_t captures = 0;
+    size_t allocations = 0;
+    size_t bytes_allocated = 0;
+
+    /*!
+     * Bytes moved to each space.
+     */
+    size_t bytes_moved[NUM_EXECUTION_SPACES] = {};
+  };
+
+  /*!
+   * \brief Get the singleton instance.
+   *
+   * \return Pointer to the RegionStatistics instance.
+   */
+  CHAISHAREDDLL_API static RegionStatistics* getInstance();
+
+  /*!
+   * \brief Print the tree of regions if CHAI_REGION_STATISTICS is set, then
+   *        delete it.
+   */
+  ~RegionStatistics();
+
+  /*!
+   * \brief Turn collection of the traffic of each region on or off.
+   */
+  CHAISHAREDDLL_API void setEnabled(bool enabled);
+
+  /*!
+   * \brief Whether the traffic of each region is collected.
+   */
+  bool isEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+  /*!
+   * \brief Get the current region of the calling thread, or the root if no
+   *        region was pushed.
+   */
+  CHAISHAREDDLL_API static Region* current();
+
+  /*!
+   * \brief Make region the current region of the calling thread.
+   *
+   * Used to run work on behalf of another thread in that thread's region,
+   * such as the chunks of a loop handed to a ThreadPool worker.
+   *
+   * \param region Region to enter, or null for the root.
+   *
+   * \return The previous current region of the calling thread, to restore
+   *         once the work is done. Null stands for the root.
+   */
+  CHAISHAREDDLL_API static Region* setCurrent(Region* region);
+
+  /*!
+   * \brief Enter the child region name of the current region.
+   *
+   * \param name Name of the region. It is kept as a pointer, so it must have
+   *        static storage.
+   */
+  CHAISHAREDDLL_API static void push(const char* name);
+
+  /*!
+   * \brief Leave the current region.
+   */
+  CHAISHAREDDLL_API static void pop();
+
+  /*!
+   * \brief Get the root of the tree of regions.
+   */
+  Region const* getRoot() const { return &m_root; }
+
+  /*!
+   * \brief Get the entries of every region, depth first.
+   *
+   * The root comes first, with an empty path, and holds the totals of the
+   * whole program.
+   */
+  CHAISHAREDDLL_API std::vector<Entry> getEntries() const;
+
+  /*!
+   * \brief Print the tree of regions, with the share of the bytes moved to
+   *        each space that each region caused.
+   */
+  CHAISHAREDDLL_API void report(std::ostream& stream) const;
+
+  /*!
+   * \brief Set the statistics of every region back to zero.
+   */
+  CHAISHAREDDLL_API void clear();
+
+protected:
+  /*!
+   * \brief Construct a new RegionStatistics.
+   *
+   * The constructor is a protected member, ensuring that it can
+   * only be called by the singleton getInstance method.
+   */
+  RegionStatistics();
+
+private:
+  /*!
+   * \brief Add the entries of region and the regions it encloses.
+   *
+   * \return The entry of region.
+   */
+  Entry collect(Region const* region,
+                int depth,
+                std::vector<Entry>& entries) const;
+
+  std::atomic<bool> m_enabled;
+
+  Region m_root;
+
+  /*!
+   * Value of CHAI_REGION_STATISTICS, if set.
+   */
+  std::string m_output;
+};
+
+/*!
+ * \brief Enter a region of the program.
+ *
+ * \param name Name of the region, with static storage.
+ */
+inline void pushRegion(const char* name)
+{
+  RegionStatistics::push(name);
+}
+
+/*!
+ * \brief Leave the current region of the program.
+ */
+inline void popRegion()
+{
+  RegionStatistics::pop();
+}
+
+/*!
+ * \brief Region of the program entered for the lifetime of the object.
+ */
+class ScopedRegion
+{
+public:
+  explicit ScopedRegion(const char* name) { pushRegion(name); }
+
+  ~ScopedRegion() { popRegion(); }
+
+  ScopedRegion(ScopedRegion const&) = delete;
+  ScopedRegion& operator=(ScopedRegion const&) = delete;
+};
+
+}  // end of namespace chai
+
+#endif  // CHAI_RegionStatistics_HPP
@@ -0,0 +1,199 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#ifndef CHAI_Simd_HPP
+#define CHAI_Simd_HPP
+
+#include "chai/config.hpp"
+#include "chai/ChaiMacros.hpp"
+
+#include <type_traits>
+
+/*!
+ * Number of lanes in a SIMD batch. Defaults to the number of floats in the
+ * widest vector register the host compiler targets.
+ */
+#if !defined(CHAI_SIMD_WIDTH)
+#if defined(__AVX512F__)
+#define CHAI_SIMD_WIDTH 16
+#elif defined(__AVX__)
+#define CHAI_SIMD_WIDTH 8
+#else
+#define CHAI_SIMD_WIDTH 4
+#endif
+#endif
+
+namespace chai
+{
+
+/*!
+ * \brief Indices of one batch of lanes of a simd loop.
+ *
+ * Lane l of the batch is index first + l. Every batch of a loop holds
+ * CHAI_SIMD_WIDTH lanes, except the batches at either end of the range, and
+ * the first index of every full batch is a multiple of CHAI_SIMD_WIDTH.
+ */
+struct SimdIndex {
+  static constexpr int width = CHAI_SIMD_WIDTH;
+
+  int first;
+
+  int lanes;
+
+  /*!
+   * \brief Whether the batch holds a full CHAI_SIMD_WIDTH lanes.
+   */
+  CHAI_HOST_DEVICE bool full() const { return lanes == width; }
+
+  /*!
+   * \brief Index of lane l.
+   */
+  CHAI_HOST_DEVICE int operator[](int l) const { return first + l; }
+};
+
+/*!
+ * \brief One value of type T per lane of a SIMD batch.
+ *
+ * The operators work lane by lane over all CHAI_SIMD_WIDTH lanes, with a trip
+ * count known at compile time, so the compiler turns them into vector
+ * instructions. Lanes past the end of a partial batch are loaded as zero and
+ * are not stored.
+ *
+ * \tparam T Arithmetic type of the values.
+ */
+template <typename T>
+struct alignas(sizeof(T) * CHAI_SIMD_WIDTH) Pack {
+  static_assert(std::is_arithmetic<T>::value,
+                "Pack holds arithmetic types only");
+
+  static constexpr int width = CHAI_SIMD_WIDTH;
+
+  Pack() = default;
+
+  /*!
+   * \brief Set every lane to value.
+   */
+  CHAI_HOST_DEVICE Pack(T value)
+  {
+    for (int l = 0; l < width; ++l) {
+      lane[l] = value;
+    }
+  }
+
+  /*!
+   * \brief Pack holding the indices of a batch.
+   */
+  CHAI_HOST_DEVICE static Pack index(SimdIndex i)
+  {
+    Pack result;
+    for (int l = 0; l < width; ++l) {
+      result.lane[l] = static_cast<T>(i.first + l);
+    }
+    return result;
+  }
+
+  CHAI_HOST_DEVICE T& operator[](int l) { return lane[l]; }
+
+  CHAI_HOST_DEVICE T operator[](int l) const { return lane[l]; }
+
+  /*!
+   * \brief Sum of the first lanes lanes.
+   */
+  CHAI_HOST_DEVICE T sum(int lanes = width) const
+  {
+    T result = T(0);
+    for (int l = 0; l < lanes; ++l) {
+      result += lane[l];
+    }
+    return result;
+  }
+
+#define CHAI_PACK_OPERATOR(op)                                       \
+  CHAI_HOST_DEVICE Pack& operator op##=(Pack const& other)           \
+  {                                                                  \
+    for (int l = 0; l < width; ++l) {                                \
+      lane[l] op##= other.lane[l];                                   \
+    }                                                                \
+    return *this;                                                    \
+  }                                                                  \
+                                                                     \
+  CHAI_HOST_DEVICE friend Pack operator op(Pack const& a, Pack const& b) \
+  {                                                                  \
+    Pack result(a);                                                  \
+    return result op##= b;                                           \
+  }                                                                  \
+                                                                     \
+  CHAI_HOST_DEVICE friend Pack operator op(Pack const& a, T b)       \
+  {                                                                  \
+    Pack result(a);                                                  \
+    return result op##= Pack(b);                                     \
+  }                                                                  \
+                                                                     \
+  CHAI_HOST_DEVICE friend Pack operator op(T a, Pack const& b)       \
+  {                                                                  \
+    return Pack(a) op##= b;                                          \
+  }
+
+  CHAI_PACK_OPERATOR(+)
+  CHAI_PACK_OPERATOR(-)
+  CHAI_PACK_OPERATOR(*)
+  CHAI_PACK_OPERATOR(/)
+
+#undef CHAI_PACK_OPERATOR
+
+  T lane[CHAI_SIMD_WIDTH];
+};
+
+template <typename T>
+constexpr int Pack<T>::width;
+
+/*!
+ * \brief Load the lanes of batch i from data.
+ */
+template <typename T>
+CHAI_HOST_DEVICE Pack<typename std::remove_const<T>::type> loadPack(
+    T const* CHAI_RESTRICT data, SimdIndex i)
+{
+  Pack<typename std::remove_const<T>::type> result;
+  data += i.first;
+
+  if (i.full()) {
+    for (int l = 0; l < SimdIndex::width; ++l) {
+      result.lane[l] = data[l];
+    }
+  } else {
+    for (int l = 0; l < SimdIndex::width; ++l) {
+      result.lane[l] = l < i.lanes ? data[l] : T(0);
+    }
+  }
+
+  return result;
+}
+
+/*!
+ * \brief Store the lanes of batch i to data.
+ */
+template <typename T>
+CHAI_HOST_DEVICE void storePack(T* CHAI_RESTRICT data,
+                                SimdIndex i,
+                                Pack<T> const& values)
+{
+  data += i.first;
+
+  if (i.full()) {
+    for (int l = 0; l < SimdIndex::width; ++l) {
+      data[l] = values.lane[l];
+    }
+  } else {
+    for (int l = 0; l < i.lanes; ++l) {
+      data[l] = values.lane[l];
+    }
+  }
+}
+
+}  // end of namespace chai
+
+#endif  // CHAI_Simd_HPP
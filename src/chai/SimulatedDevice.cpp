@@ -0,0 +1,119 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#include "chai/SimulatedDevice.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+namespace chai
+{
+
+SimulatedDevice* SimulatedDevice::getInstance()
+{
+  static SimulatedDevice s_simulated_device_instance;
+  return &s_simulated_device_instance;
+}
+
+SimulatedDevice::SimulatedDevice() :
+  m_copy_model{},
+  m_copy_modeled{false},
+  m_link_free{},
+  m_copy_totals{}
+{
+}
+
+double SimulatedDevice::copy(void* dst,
+                             const void* src,
+                             std::size_t size,
+                             CopyDirection direction)
+{
+  const Clock::time_point start = Clock::now();
+
+  std::memcpy(dst, src, size);
+
+  Clock::time_point end;
+
+  {
+    std::lock_guard<std::mutex> lock(m_copy_mutex);
+
+    const CopyModel& model = m_copy_model;
+
+    const Clock::duration latency =
+        std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(model.latency));
+    const Clock::duration transfer =
+        model.bandwidth > 0.0
+            ? std::chrono::duration_cast<Clock::duration>(
+                  std::chrono::duration<double>(size / model.bandwidth))
+            : Clock::duration::zero();
+
+    Clock::time_point begin = start + latency;
+
+    if (model.contention) {
+      Clock::time_point& link_free =
+          m_link_free[model.duplex ? direction : COPY_TO_DEVICE];
+
+      begin = std::max(begin, link_free);
+      link_free = begin + transfer;
+    }
+
+    end = begin + transfer;
+
+    ++m_copy_totals.copies;
+    m_copy_totals.bytes += size;
+    m_copy_totals.seconds += std::chrono::duration<double>(end - start).count();
+  }
+
+  std::this_thread::sleep_until(end);
+
+  return std::chrono::duration<double>(end - start).count();
+}
+
+void SimulatedDevice::setCopyModel(CopyModel const& model)
+{
+  std::lock_guard<std::mutex> lock(m_copy_mutex);
+
+  m_copy_model = model;
+  m_copy_model.latency = std::max(model.latency, 0.0);
+  m_copy_model.bandwidth = std::max(model.bandwidth, 0.0);
+
+  m_copy_modeled =
+      m_copy_model.latency > 0.0 || m_copy_model.bandwidth > 0.0;
+}
+
+CopyModel SimulatedDevice::getCopyModel() const
+{
+  std::lock_guard<std::mutex> lock(m_copy_mutex);
+  return m_copy_model;
+}
+
+void SimulatedDevice::setCopyBandwidth(double bytes_per_second)
+{
+  CopyModel model = getCopyModel();
+  model.bandwidth = bytes_per_second;
+  setCopyModel(model);
+}
+
+double SimulatedDevice::getCopyBandwidth() const
+{
+  return getCopyModel().bandwidth;
+}
+
+SimulatedDevice::CopyTotals SimulatedDevice::getCopyTotals() const
+{
+  std::lock_guard<std::mutex> lock(m_copy_mutex);
+  return m_copy_totals;
+}
+
+void SimulatedDevice::clearCopyTotals()
+{
+  std::lock_guard<std::mutex> lock(m_copy_mutex);
+  m_copy_totals = CopyTotals{};
+}
+
+}  // end of namespace chai
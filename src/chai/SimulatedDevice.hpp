@@ -0,0 +1,181 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#ifndef CHAI_SimulatedDevice_HPP
+#define CHAI_SimulatedDevice_HPP
+
+#include "chai/config.hpp"
+#include "chai/KernelQueue.hpp"
+#include "chai/Types.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+
+namespace chai
+{
+
+/*!
+ * \brief Cost of copies to and from the simulated device.
+ *
+ * A copy of size bytes takes latency seconds, then size / bandwidth seconds
+ * on the link of its direction. The default model costs nothing, and copies
+ * run at the speed of the host.
+ */
+struct CopyModel {
+  /*!
+   * Fixed cost of every copy in seconds, such as the setup of a DMA. Copies
+   * pay it concurrently.
+   */
+  double latency = 0.0;
+
+  /*!
+   * Bandwidth of a link in bytes per second, or 0 for an unlimited link.
+   */
+  double bandwidth = 0.0;
+
+  /*!
+   * Whether concurrent copies on a link take turns, so that together they
+   * get its bandwidth, rather than each getting all of it.
+   */
+  bool contention = true;
+
+  /*!
+   * Whether copies to and from the device have a link each, as on PCIe and
+   * NVLink, rather than sharing one.
+   */
+  bool duplex = false;
+};
+
+/*!
+ * \brief Singleton standing in for the GPU in GPU simulation mode.
+ *
+ * Kernels launched on the SimulatedDevice are executed in launch order by the
+ * thread of its KernelQueue, like kernels on the default stream of a real
+ * device. launch returns immediately; synchronize blocks until every kernel
+ * launched so far has completed.
+ *
+ * Copies to and from the simulated device can be made to cost what they
+ * would on a real interconnect, following a CopyModel, so that the cost of
+ * moving data is visible next to the cost of the kernels. The device also
+ * adds up the time the copies took in the model.
+ */
+class SimulatedDevice : public KernelQueue
+{
+public:
+  /*!
+   * \brief Direction of a copy.
+   */
+  enum CopyDirection {
+    COPY_TO_DEVICE = 0,
+    COPY_FROM_DEVICE = 1
+  };
+
+  /*!
+   * \brief Copies made through the model, and the time they took in it.
+   */
+  struct CopyTotals {
+    size_t copies = 0;
+    size_t bytes = 0;
+
+    /*!
+     * Seconds from the start of each copy to its end in the model, including
+     * the time spent waiting for the link, summed over the copies.
+     */
+    double seconds = 0.0;
+  };
+
+  /*!
+   * \brief Get the singleton instance.
+   *
+   * \return Pointer to the SimulatedDevice instance.
+   */
+  CHAISHAREDDLL_API static SimulatedDevice* getInstance();
+
+  /*!
+   * \brief Copy memory to or from the device, following the copy model.
+   *
+   * The copy does not return before it would have completed in the model:
+   * after the latency, and after its bytes went through the link once the
+   * copies ahead of it on the link did, if there is contention.
+   *
+   * \param dst Destination of the copy.
+   * \param src Source of the copy.
+   * \param size Number of bytes to copy.
+   * \param direction Direction of the copy, which selects the link.
+   *
+   * \return Seconds the copy took in the model.
+   */
+  CHAISHAREDDLL_API double copy(void* dst,
+                                const void* src,
+                                std::size_t size,
+                                CopyDirection direction = COPY_TO_DEVICE);
+
+  /*!
+   * \brief Set the cost of the copies from now on.
+   */
+  CHAISHAREDDLL_API void setCopyModel(CopyModel const& model);
+
+  CHAISHAREDDLL_API CopyModel getCopyModel() const;
+
+  /*!
+   * \brief Whether copies have a cost, and so must go through copy.
+   */
+  bool isCopyModeled() const
+  {
+    return m_copy_modeled.load(std::memory_order_relaxed);
+  }
+
+  /*!
+   * \brief Set the bandwidth of the copy model.
+   *
+   * \param bytes_per_second Bandwidth to throttle copies to, or 0 to copy at
+   *        the speed of the host.
+   */
+  CHAISHAREDDLL_API void setCopyBandwidth(double bytes_per_second);
+
+  /*!
+   * \brief Get the bandwidth of the copy model, 0 if it is unlimited.
+   */
+  CHAISHAREDDLL_API double getCopyBandwidth() const;
+
+  /*!
+   * \brief Get the copies made through the model since the last clear.
+   */
+  CHAISHAREDDLL_API CopyTotals getCopyTotals() const;
+
+  CHAISHAREDDLL_API void clearCopyTotals();
+
+protected:
+  /*!
+   * \brief Construct a new SimulatedDevice.
+   *
+   * The constructor is a protected member, ensuring that it can
+   * only be called by the singleton getInstance method.
+   */
+  SimulatedDevice();
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  mutable std::mutex m_copy_mutex;
+
+  CopyModel m_copy_model;
+
+  std::atomic<bool> m_copy_modeled;
+
+  /*!
+   * Time at which each link finishes the copies given to it so far.
+   */
+  Clock::time_point m_link_free[2];
+
+  CopyTotals m_copy_totals;
+};
+
+}  // end of namespace chai
+
+#endif  // CHAI_SimulatedDevice_HPP
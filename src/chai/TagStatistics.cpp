@@ -0,0 +1,276 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#include "chai/TagStatistics.hpp"
+
+#include "chai/Instrumentation.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace chai
+{
+
+namespace {
+
+const char* const s_unnamed = "(unnamed)";
+
+const char* spaceName(int space)
+{
+  switch (space) {
+    case CPU:
+      return "CPU";
+    case GPU:
+      return "GPU";
+    case UM:
+      return "UM";
+    case PINNED:
+      return "PINNED";
+    default:
+      return "NONE";
+  }
+}
+
+std::string regionName(Region const* region)
+{
+  return region->getParent() ? region->getPath() : "(program)";
+}
+
+}  // end of anonymous namespace
+
+TagStatistics* TagStatistics::getInstance()
+{
+  static TagStatistics s_tag_statistics_instance;
+  return &s_tag_statistics_instance;
+}
+
+TagStatistics::TagStatistics() :
+  m_enabled{false},
+  m_output{},
+  m_entries{},
+  m_names{}
+{
+  // Entries point to regions, so the regions must outlive the TagStatistics.
+  RegionStatistics::getInstance();
+
+  const char* env = std::getenv("CHAI_TAG_STATISTICS");
+  if (env && *env) {
+    m_output = env;
+    setEnabled(true);
+  }
+}
+
+TagStatistics::~TagStatistics()
+{
+  if (m_output.empty()) {
+    return;
+  }
+
+  if (m_output == "1") {
+    report(std::cerr);
+  } else {
+    std::ofstream file(m_output);
+    report(file);
+  }
+}
+
+void TagStatistics::setEnabled(bool enabled)
+{
+  m_enabled = enabled;
+  Instrumentation::setEnabled(INSTRUMENT_TAG_STATISTICS, enabled);
+}
+
+void TagStatistics::recordAllocation(const char* name,
+                                     ExecutionSpace space,
+                                     size_t bytes)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  for (Entry* entry : entries(name)) {
+    ++entry->allocations;
+  }
+
+  add(name, space, bytes);
+}
+
+void TagStatistics::recordFree(const char* name,
+                               ExecutionSpace space,
+                               size_t bytes)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  for (Entry* entry : entries(name)) {
+    assert(entry->bytes[space] >= bytes && "Free of memory not accounted");
+    entry->bytes[space] -= bytes;
+  }
+}
+
+void TagStatistics::recordRename(const char* old_name,
+                                 const char* name,
+                                 ExecutionSpace space,
+                                 size_t bytes)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  for (Entry* entry : entries(old_name)) {
+    assert(entry->bytes[space] >= bytes && "Rename of memory not accounted");
+    entry->bytes[space] -= bytes;
+  }
+
+  add(name, space, bytes);
+}
+
+void TagStatistics::recordMove(const char* name, size_t bytes)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  for (Entry* entry : entries(name)) {
+    ++entry->moves;
+    entry->bytes_moved += bytes;
+  }
+}
+
+TagStatistics::Entry TagStatistics::getUsage(std::string const& tag) const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  auto found = m_entries.find(tag);
+  if (found != m_entries.end()) {
+    return found->second;
+  }
+
+  Entry empty;
+  empty.tag = tag;
+  return empty;
+}
+
+std::vector<TagStatistics::Entry> TagStatistics::getEntries() const
+{
+  std::vector<Entry> entries;
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (auto const& entry : m_entries) {
+    entries.push_back(entry.second);
+  }
+
+  return entries;
+}
+
+void TagStatistics::report(std::ostream& stream) const
+{
+  const std::vector<Entry> entries = getEntries();
+
+  size_t tag_width = 3;
+  for (auto const& entry : entries) {
+    tag_width = std::max(tag_width, entry.tag.size());
+  }
+
+  stream << std::left << std::setw(tag_width) << "tag" << std::right;
+
+  for (int space = CPU; space < NUM_EXECUTION_SPACES; ++space) {
+    stream << std::setw(16) << (std::string(spaceName(space)) + " bytes")
+           << std::setw(16) << (std::string(spaceName(space)) + " peak");
+  }
+
+  stream << std::setw(8) << "allocs"
+         << std::setw(10) << "moves"
+         << std::setw(16) << "bytes moved"
+         << "  peak regions\n";
+
+  for (auto const& entry : entries) {
+    stream << std::left << std::setw(tag_width) << entry.tag << std::right;
+
+    for (int space = CPU; space < NUM_EXECUTION_SPACES; ++space) {
+      stream << std::setw(16) << entry.bytes[space]
+             << std::setw(16) << entry.peak_bytes[space];
+    }
+
+    stream << std::setw(8) << entry.allocations
+           << std::setw(10) << entry.moves
+           << std::setw(16) << entry.bytes_moved << " ";
+
+    for (int space = CPU; space < NUM_EXECUTION_SPACES; ++space) {
+      if (entry.peak_region[space]) {
+        stream << " " << spaceName(space) << ":"
+               << regionName(entry.peak_region[space]);
+      }
+    }
+
+    stream << "\n";
+  }
+}
+
+void TagStatistics::resetPeaks()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  for (auto& entry : m_entries) {
+    for (int space = CPU; space < NUM_EXECUTION_SPACES; ++space) {
+      entry.second.peak_bytes[space] = entry.second.bytes[space];
+      entry.second.peak_region[space] = nullptr;
+    }
+  }
+}
+
+std::vector<TagStatistics::Entry*> const& TagStatistics::entries(const char* name)
+{
+  if (!name) {
+    name = s_unnamed;
+  }
+
+  auto found = m_names.find(name);
+  if (found != m_names.end()) {
+    return found->second;
+  }
+
+  // The name itself, then each enclosing group, then everything
+  std::vector<std::string> tags{name};
+  const std::string tag{name};
+
+  for (size_t slash = tag.rfind('/'); slash != std::string::npos && slash > 0;
+       slash = tag.rfind('/', slash - 1)) {
+    tags.push_back(tag.substr(0, slash) + "/*");
+  }
+
+  tags.push_back("*");
+
+  std::vector<Entry*>& chain = m_names[name];
+  for (std::string const& group : tags) {
+    // Entries of std::map are never moved, so pointers to them stay valid
+    Entry& entry = m_entries[group];
+    entry.tag = group;
+
+    if (std::find(chain.begin(), chain.end(), &entry) == chain.end()) {
+      chain.push_back(&entry);
+    }
+  }
+
+  return chain;
+}
+
+void TagStatistics::add(const char* name, ExecutionSpace space, size_t bytes)
+{
+  Region const* region = nullptr;
+
+  for (Entry* entry : entries(name)) {
+    entry->bytes[space] += bytes;
+
+    if (entry->bytes[space] > entry->peak_bytes[space]) {
+      if (!region) {
+        region = RegionStatistics::current();
+      }
+
+      entry->peak_bytes[space] = entry->bytes[space];
+      entry->peak_region[space] = region;
+    }
+  }
+}
+
+}  // end of namespace chai
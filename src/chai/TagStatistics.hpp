@@ -0,0 +1,187 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#ifndef CHAI_TagStatistics_HPP
+#define CHAI_TagStatistics_HPP
+
+#include "chai/config.hpp"
+#include "chai/ExecutionSpaces.hpp"
+#include "chai/RegionStatistics.hpp"
+#include "chai/Types.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <iosfwd>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace chai
+{
+
+/*!
+ * \brief Singleton accounting the memory and traffic of arrays by name.
+ *
+ * Arrays are named with ManagedArray::setName or when they are allocated.
+ * Names are tags separated by slashes, such as "hydro/eos/table". Every
+ * allocation, free and move of an array is added to its name and to each
+ * group the name belongs to. A group is named by a prefix of the tags
+ * followed by a slash and a star, and the group of all arrays is named by a
+ * star alone. Groups have their own peaks, so the peak of the group of
+ * "hydro" is the most memory the arrays of the package held at once, and
+ * the region of the allocation that reached it is kept. Arrays without a
+ * name are accounted under "(unnamed)".
+ *
+ * Accounting is off by default. Setting the CHAI_TAG_STATISTICS environment
+ * variable turns it on from the start of the run, and prints the table at
+ * shutdown: to standard error if the variable is 1, and to the file it names
+ * otherwise. Memory allocated while accounting is off is never accounted,
+ * and memory allocated while it is on is accounted until it is freed.
+ */
+class TagStatistics
+{
+public:
+  /*!
+   * \brief Totals of one name or group.
+   */
+  struct Entry {
+    std::string tag;
+    size_t bytes[NUM_EXECUTION_SPACES] = {};
+    size_t peak_bytes[NUM_EXECUTION_SPACES] = {};
+
+    /*!
+     * Region of the thread that reached the peak in each space, or null if
+     * the peak was not reached since the peaks were last reset.
+     */
+    Region const* peak_region[NUM_EXECUTION_SPACES] = {};
+
+    size_t allocations = 0;
+    size_t moves = 0;
+    size_t bytes_moved = 0;
+  };
+
+  /*!
+   * \brief Get the singleton instance.
+   *
+   * \return Pointer to the TagStatistics instance.
+   */
+  CHAISHAREDDLL_API static TagStatistics* getInstance();
+
+  /*!
+   * \brief Print the table if CHAI_TAG_STATISTICS is set.
+   */
+  ~TagStatistics();
+
+  /*!
+   * \brief Turn accounting of new allocations and moves on or off.
+   */
+  CHAISHAREDDLL_API void setEnabled(bool enabled);
+
+  /*!
+   * \brief Whether accounting is on.
+   */
+  bool isEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+  /*!
+   * \brief Add an allocation of bytes in space to name.
+   */
+  CHAISHAREDDLL_API void recordAllocation(const char* name,
+                                          ExecutionSpace space,
+                                          size_t bytes);
+
+  /*!
+   * \brief Add a free of bytes in space to name.
+   *
+   * The bytes must have been accounted to name by recordAllocation or
+   * recordRename.
+   */
+  CHAISHAREDDLL_API void recordFree(const char* name,
+                                    ExecutionSpace space,
+                                    size_t bytes);
+
+  /*!
+   * \brief Account bytes held in space under name rather than old_name.
+   *
+   * The bytes are moved between the names and the groups they do not share,
+   * and no allocation is counted.
+   */
+  CHAISHAREDDLL_API void recordRename(const char* old_name,
+                                      const char* name,
+                                      ExecutionSpace space,
+                                      size_t bytes);
+
+  /*!
+   * \brief Add a move of bytes to name.
+   */
+  CHAISHAREDDLL_API void recordMove(const char* name, size_t bytes);
+
+  /*!
+   * \brief Get the totals of a name or a group.
+   *
+   * \param tag A name, or a group: tags followed by a slash and a star, or a
+   *        star alone for all arrays.
+   */
+  CHAISHAREDDLL_API Entry getUsage(std::string const& tag) const;
+
+  /*!
+   * \brief Get the entries of every name and group, ordered by tag.
+   */
+  CHAISHAREDDLL_API std::vector<Entry> getEntries() const;
+
+  /*!
+   * \brief Print the entries as a table.
+   */
+  CHAISHAREDDLL_API void report(std::ostream& stream) const;
+
+  /*!
+   * \brief Set the peaks of every entry to the memory in use now, and forget
+   *        their regions.
+   */
+  CHAISHAREDDLL_API void resetPeaks();
+
+protected:
+  /*!
+   * \brief Construct a new TagStatistics.
+   *
+   * The constructor is a protected member, ensuring that it can
+   * only be called by the singleton getInstance method.
+   */
+  TagStatistics();
+
+private:
+  /*!
+   * \brief Get the entries a name is accounted in: its own and its groups'.
+   */
+  std::vector<Entry*> const& entries(const char* name);
+
+  /*!
+   * \brief Add bytes in space to the entries of name, raising their peaks.
+   */
+  void add(const char* name, ExecutionSpace space, size_t bytes);
+
+  std::atomic<bool> m_enabled;
+
+  /*!
+   * Value of CHAI_TAG_STATISTICS, if set.
+   */
+  std::string m_output;
+
+  mutable std::mutex m_mutex;
+
+  std::map<std::string, Entry> m_entries;
+
+  /*!
+   * Entries of every name seen, by address. Names have static storage, so
+   * the address identifies the name without comparing strings.
+   */
+  std::unordered_map<const char*, std::vector<Entry*>> m_names;
+};
+
+}  // end of namespace chai
+
+#endif  // CHAI_TagStatistics_HPP
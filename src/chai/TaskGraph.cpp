@@ -0,0 +1,174 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#include "chai/TaskGraph.hpp"
+
+#include "chai/ThreadPool.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+
+namespace chai
+{
+
+TaskGraph::TaskGraph() :
+  m_nodes{},
+  m_history{},
+  m_num_dependencies{0}
+{
+}
+
+TaskGraph::~TaskGraph()
+{
+  // A destructor cannot report the failure of a task
+  try {
+    run();
+  } catch (...) {
+  }
+}
+
+void TaskGraph::submit(Task task,
+                       std::vector<ArrayManager::Access> const& accesses)
+{
+  const size_t id = m_nodes.size();
+  std::vector<size_t> dependencies;
+
+#if defined(CHAI_DISABLE_RM)
+  // Nothing is captured, so the tasks can only be run in order
+  if (id > 0) {
+    dependencies.push_back(id - 1);
+  }
+#endif
+
+  // An array may be captured more than once; it is written if any capture is
+  std::unordered_map<const PointerRecord*, bool> writes;
+  for (auto const& access : accesses) {
+    writes[access.record] = writes[access.record] || access.write;
+  }
+
+  for (auto const& entry : writes) {
+    History& history = m_history[entry.first];
+
+    if (history.written) {
+      dependencies.push_back(history.last_writer);
+    }
+
+    if (entry.second) {
+      dependencies.insert(dependencies.end(),
+                          history.readers.begin(),
+                          history.readers.end());
+      history.readers.clear();
+      history.last_writer = id;
+      history.written = true;
+    } else {
+      history.readers.push_back(id);
+    }
+  }
+
+  std::sort(dependencies.begin(), dependencies.end());
+  dependencies.erase(std::unique(dependencies.begin(), dependencies.end()),
+                     dependencies.end());
+
+  Node node;
+  node.task = std::move(task);
+  node.num_dependencies = static_cast<int>(dependencies.size());
+  m_nodes.push_back(std::move(node));
+
+  for (size_t dependency : dependencies) {
+    m_nodes[dependency].successors.push_back(id);
+  }
+
+  m_num_dependencies += dependencies.size();
+}
+
+void TaskGraph::run()
+{
+  if (m_nodes.empty()) {
+    return;
+  }
+
+  const size_t num_tasks = m_nodes.size();
+
+  std::mutex mutex;
+  std::condition_variable ready_or_done;
+  std::deque<size_t> ready;
+  std::vector<int> remaining(num_tasks);
+  size_t completed = 0;
+  std::exception_ptr failure;
+
+  for (size_t id = 0; id < num_tasks; ++id) {
+    remaining[id] = m_nodes[id].num_dependencies;
+    if (remaining[id] == 0) {
+      ready.push_back(id);
+    }
+  }
+
+  // Every thread of the pool takes ready tasks until the graph has completed
+  ThreadPool* pool = ThreadPool::getInstance();
+  pool->parallelFor(0, pool->getNumThreads(), SCHEDULE_STATIC,
+    [&] (int, int) {
+      std::unique_lock<std::mutex> lock(mutex);
+
+      while (true) {
+        ready_or_done.wait(lock, [&] {
+          return !ready.empty() || completed == num_tasks || failure;
+        });
+
+        // Once a task has failed, no further tasks are started
+        if (ready.empty() || failure) {
+          return;
+        }
+
+        const size_t id = ready.front();
+        ready.pop_front();
+
+        lock.unlock();
+        std::exception_ptr error;
+        try {
+          m_nodes[id].task();
+        } catch (...) {
+          error = std::current_exception();
+        }
+        lock.lock();
+
+        if (error && !failure) {
+          failure = error;
+        }
+
+        ++completed;
+        for (size_t successor : m_nodes[id].successors) {
+          if (--remaining[successor] == 0) {
+            ready.push_back(successor);
+          }
+        }
+
+        ready_or_done.notify_all();
+      }
+    }, 1);
+
+  m_nodes.clear();
+  m_history.clear();
+  m_num_dependencies = 0;
+
+  if (failure) {
+    std::rethrow_exception(failure);
+  }
+}
+
+size_t TaskGraph::getNumTasks() const
+{
+  return m_nodes.size();
+}
+
+size_t TaskGraph::getNumDependencies() const
+{
+  return m_num_dependencies;
+}
+
+}  // end of namespace chai
@@ -0,0 +1,108 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#ifndef CHAI_TaskGraph_HPP
+#define CHAI_TaskGraph_HPP
+
+#include "chai/config.hpp"
+#include "chai/ArrayManager.hpp"
+#include "chai/Types.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace chai
+{
+
+/*!
+ * \brief Graph of host tasks ordered by the ManagedArrays they capture.
+ *
+ * Each task is submitted with the accesses recorded while its body was
+ * captured. A task depends on the last task that wrote any array it accesses
+ * (read after write, write after write), and a task that writes an array also
+ * depends on every task that read it since it was last written (write after
+ * read). Tasks are not run when they are submitted: run executes the whole
+ * graph on the ThreadPool, starting each task as soon as the tasks it depends
+ * on have completed, so independent tasks run concurrently.
+ *
+ * Tasks run on host threads only. A task that launches device work must wait
+ * for it before returning; the graph does not place independent kernels on
+ * separate streams.
+ *
+ * All data is moved when a task is captured, on the submitting thread. The
+ * arrays used by pending tasks must not be captured or freed outside the graph
+ * until run has returned.
+ */
+class TaskGraph
+{
+public:
+  using Task = std::function<void()>;
+
+  TaskGraph();
+
+  /*!
+   * \brief Run any tasks still pending.
+   *
+   * An exception thrown by a task is discarded.
+   */
+  ~TaskGraph();
+
+  /*!
+   * \brief Add a task to the graph.
+   *
+   * \param task The task to run.
+   * \param accesses The arrays captured by the task, from
+   *        ArrayManager::beginAccessRecording.
+   */
+  CHAISHAREDDLL_API void submit(Task task,
+                                std::vector<ArrayManager::Access> const& accesses);
+
+  /*!
+   * \brief Run every pending task, and return once they have all completed.
+   *
+   * If a task throws, no further tasks are started. Once the running tasks
+   * have returned, the graph is emptied and the first exception is rethrown.
+   */
+  CHAISHAREDDLL_API void run();
+
+  /*!
+   * \brief Get the number of tasks submitted since the graph was last run.
+   */
+  CHAISHAREDDLL_API size_t getNumTasks() const;
+
+  /*!
+   * \brief Get the number of dependencies between the pending tasks.
+   */
+  CHAISHAREDDLL_API size_t getNumDependencies() const;
+
+private:
+  struct Node {
+    Task task;
+    std::vector<size_t> successors;
+    int num_dependencies;
+  };
+
+  /*!
+   * \brief Tasks that last accessed an array.
+   */
+  struct History {
+    size_t last_writer;
+    bool written;
+    std::vector<size_t> readers;
+  };
+
+  std::vector<Node> m_nodes;
+
+  std::unordered_map<const PointerRecord*, History> m_history;
+
+  size_t m_num_dependencies;
+};
+
+}  // end of namespace chai
+
+#endif  // CHAI_TaskGraph_HPP
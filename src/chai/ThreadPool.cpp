@@ -0,0 +1,316 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#include "chai/ThreadPool.hpp"
+
+#include "chai/ArrayManager.hpp"
+#include "chai/RegionStatistics.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace chai
+{
+
+namespace {
+
+thread_local int s_thread_id = 0;
+
+/*!
+ * True while the calling thread is executing part of a parallel loop.
+ */
+thread_local bool s_in_parallel = false;
+
+int defaultNumThreads()
+{
+  const char* env = std::getenv("CHAI_NUM_THREADS");
+  if (env) {
+    int num_threads = std::atoi(env);
+    if (num_threads > 0) {
+      return num_threads;
+    }
+  }
+
+  unsigned int hardware_threads = std::thread::hardware_concurrency();
+  return hardware_threads > 0 ? static_cast<int>(hardware_threads) : 1;
+}
+
+}
+
+ThreadPool* ThreadPool::getInstance()
+{
+  static ThreadPool s_thread_pool_instance;
+  return &s_thread_pool_instance;
+}
+
+int ThreadPool::getThreadId()
+{
+  return s_thread_id;
+}
+
+ThreadPool::ThreadPool() :
+  m_workers{},
+  m_num_threads{1},
+  m_ranges{},
+  m_generation{0},
+  m_stop{false},
+  m_remaining{0},
+  m_begin{0},
+  m_end{0},
+  m_schedule{SCHEDULE_STATIC},
+  m_grain_size{1},
+  m_function{nullptr},
+  m_context{nullptr},
+  m_region{nullptr},
+  m_next{0}
+{
+  startWorkers(defaultNumThreads());
+}
+
+ThreadPool::~ThreadPool()
+{
+  stopWorkers();
+}
+
+int ThreadPool::getNumThreads() const
+{
+  return m_num_threads;
+}
+
+void ThreadPool::setNumThreads(int num_threads)
+{
+  std::lock_guard<std::mutex> launch_lock(m_launch_mutex);
+
+  if (num_threads < 1) {
+    num_threads = 1;
+  }
+
+  if (num_threads != m_num_threads) {
+    stopWorkers();
+    startWorkers(num_threads);
+  }
+}
+
+void ThreadPool::startWorkers(int num_threads)
+{
+  m_num_threads = num_threads;
+  m_stop = false;
+  m_ranges.reset(new StealableRange[num_threads]);
+
+  for (int thread_id = 1; thread_id < num_threads; ++thread_id) {
+    m_workers.emplace_back(
+        &ThreadPool::workerLoop, this, thread_id, m_generation);
+  }
+}
+
+void ThreadPool::stopWorkers()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_start.notify_all();
+
+  for (auto& worker : m_workers) {
+    worker.join();
+  }
+
+  m_workers.clear();
+  m_num_threads = 1;
+}
+
+void ThreadPool::run(int begin,
+                     int end,
+                     Schedule schedule,
+                     int grain_size,
+                     ChunkFunction function,
+                     const void* context)
+{
+  // Nested loops and single-threaded pools run inline on the calling thread.
+  if (s_in_parallel || m_num_threads == 1 || end - begin == 1) {
+    function(context, begin, end);
+    return;
+  }
+
+  std::lock_guard<std::mutex> launch_lock(m_launch_mutex);
+
+  const int length = end - begin;
+  if (grain_size <= 0) {
+    grain_size = std::max(length / (m_num_threads * 32), 1);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_begin = begin;
+    m_end = end;
+    m_schedule = schedule;
+    m_grain_size = grain_size;
+
+    if (schedule == SCHEDULE_WORK_STEALING) {
+      // Start from a static partition; stealing only rebalances what is left.
+      for (int thread_id = 0; thread_id < m_num_threads; ++thread_id) {
+        m_ranges[thread_id].begin = begin + static_cast<int>(
+            (static_cast<long long>(length) * thread_id) / m_num_threads);
+        m_ranges[thread_id].end = begin + static_cast<int>(
+            (static_cast<long long>(length) * (thread_id + 1)) / m_num_threads);
+      }
+    }
+
+    m_function = function;
+    m_context = context;
+    m_region = RegionStatistics::current();
+    m_next.store(begin, std::memory_order_relaxed);
+    m_remaining = m_num_threads - 1;
+    ++m_generation;
+  }
+  m_start.notify_all();
+
+  participate(0);
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_done.wait(lock, [this] { return m_remaining == 0; });
+}
+
+void ThreadPool::workerLoop(int thread_id, unsigned long seen_generation)
+{
+  s_thread_id = thread_id;
+  ArrayManager::setKernelThread(true);
+
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_start.wait(lock, [&] {
+        return m_stop || m_generation != seen_generation;
+      });
+
+      if (m_stop) {
+        return;
+      }
+
+      seen_generation = m_generation;
+    }
+
+    Region* const previous = RegionStatistics::setCurrent(m_region);
+    participate(thread_id);
+    RegionStatistics::setCurrent(previous);
+
+    bool last = false;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      last = (--m_remaining == 0);
+    }
+
+    if (last) {
+      m_done.notify_one();
+    }
+  }
+}
+
+void ThreadPool::participate(int thread_id)
+{
+  s_in_parallel = true;
+
+  const int length = m_end - m_begin;
+
+  if (m_schedule == SCHEDULE_STATIC) {
+    const int chunk_begin = m_begin + static_cast<int>(
+        (static_cast<long long>(length) * thread_id) / m_num_threads);
+    const int chunk_end = m_begin + static_cast<int>(
+        (static_cast<long long>(length) * (thread_id + 1)) / m_num_threads);
+
+    if (chunk_begin < chunk_end) {
+      m_function(m_context, chunk_begin, chunk_end);
+    }
+  } else if (m_schedule == SCHEDULE_WORK_STEALING) {
+    int chunk_begin = 0;
+    int chunk_end = 0;
+
+    while (true) {
+      if (popRange(thread_id, chunk_begin, chunk_end)) {
+        m_function(m_context, chunk_begin, chunk_end);
+      } else if (!stealRange(thread_id)) {
+        break;
+      }
+    }
+  } else {
+    while (true) {
+      int chunk_begin = m_next.load(std::memory_order_relaxed);
+      int chunk_size = 0;
+
+      do {
+        const int remaining = m_end - chunk_begin;
+        if (remaining <= 0) {
+          break;
+        }
+        chunk_size = std::min(
+            std::max(remaining / (2 * m_num_threads), m_grain_size),
+            remaining);
+      } while (!m_next.compare_exchange_weak(chunk_begin,
+                                             chunk_begin + chunk_size,
+                                             std::memory_order_relaxed));
+
+      if (chunk_begin >= m_end) {
+        break;
+      }
+
+      m_function(m_context, chunk_begin, chunk_begin + chunk_size);
+    }
+  }
+
+  s_in_parallel = false;
+}
+
+bool ThreadPool::popRange(int thread_id, int& chunk_begin, int& chunk_end)
+{
+  StealableRange& range = m_ranges[thread_id];
+  std::lock_guard<std::mutex> lock(range.mutex);
+
+  if (range.begin >= range.end) {
+    return false;
+  }
+
+  chunk_begin = range.begin;
+  chunk_end = std::min(range.begin + m_grain_size, range.end);
+  range.begin = chunk_end;
+
+  return true;
+}
+
+bool ThreadPool::stealRange(int thread_id)
+{
+  for (int offset = 1; offset < m_num_threads; ++offset) {
+    StealableRange& victim = m_ranges[(thread_id + offset) % m_num_threads];
+
+    int stolen_begin = 0;
+    int stolen_end = 0;
+    {
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      const int remaining = victim.end - victim.begin;
+
+      if (remaining <= 0) {
+        continue;
+      }
+
+      // Leave the victim the front half, which is what it will pop next.
+      stolen_end = victim.end;
+      stolen_begin = remaining > m_grain_size
+                         ? victim.begin + remaining / 2
+                         : victim.begin;
+      victim.end = stolen_begin;
+    }
+
+    StealableRange& range = m_ranges[thread_id];
+    std::lock_guard<std::mutex> lock(range.mutex);
+    range.begin = stolen_begin;
+    range.end = stolen_end;
+
+    return true;
+  }
+
+  return false;
+}
+
+}  // end of namespace chai
@@ -0,0 +1,216 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#ifndef CHAI_ThreadPool_HPP
+#define CHAI_ThreadPool_HPP
+
+#include "chai/config.hpp"
+#include "chai/Types.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace chai
+{
+
+class Region;
+
+/*!
+ * \brief Enum listing the ways a range can be split across threads.
+ */
+enum Schedule {
+  /*! One contiguous block of the range per thread. */
+  SCHEDULE_STATIC = 0,
+  /*! Chunks proportional to the remaining work, handed out on demand. */
+  SCHEDULE_GUIDED,
+  /*! Per-thread ranges; idle threads steal half of a busy thread's range. */
+  SCHEDULE_WORK_STEALING
+};
+
+/*!
+ * \brief Singleton pool of host threads used by the parallel host policies.
+ *
+ * The thread that calls parallelFor participates in the loop as thread 0, so
+ * a pool of N threads owns N - 1 worker threads. Calls to parallelFor made
+ * from inside a running loop execute serially on the calling thread. The
+ * workers run their chunks in the region of the thread that called
+ * parallelFor, so that their traffic is attributed to it.
+ *
+ * The number of threads defaults to the value of the CHAI_NUM_THREADS
+ * environment variable, or to std::thread::hardware_concurrency if it is not
+ * set.
+ */
+class ThreadPool
+{
+public:
+  /*!
+   * \brief Get the singleton instance.
+   *
+   * \return Pointer to the ThreadPool instance.
+   */
+  CHAISHAREDDLL_API static ThreadPool* getInstance();
+
+  /*!
+   * \brief Get the index of the calling thread within the pool.
+   *
+   * \return 0 for threads that are not pool workers, otherwise the index of
+   *         the worker in [1, getNumThreads()).
+   */
+  CHAISHAREDDLL_API static int getThreadId();
+
+  /*!
+   * \brief Get the number of threads, including the calling thread.
+   */
+  CHAISHAREDDLL_API int getNumThreads() const;
+
+  /*!
+   * \brief Resize the pool.
+   *
+   * Must not be called while a loop is running.
+   *
+   * \param num_threads New number of threads, including the calling thread.
+   */
+  CHAISHAREDDLL_API void setNumThreads(int num_threads);
+
+  /*!
+   * \brief Split [begin, end) into chunks and run them on the pool.
+   *
+   * \param begin First index of the range.
+   * \param end One past the last index of the range.
+   * \param schedule How to split the range across threads.
+   * \param chunk Callable invoked as chunk(chunk_begin, chunk_end).
+   * \param grain_size Smallest chunk handed out by the guided and work
+   *        stealing schedules. 0 picks a default based on the range length.
+   */
+  template <typename CHUNK_BODY>
+  void parallelFor(int begin,
+                   int end,
+                   Schedule schedule,
+                   CHUNK_BODY const& chunk,
+                   int grain_size = 0);
+
+  ~ThreadPool();
+
+protected:
+  /*!
+   * \brief Construct a new ThreadPool.
+   *
+   * The constructor is a protected member, ensuring that it can
+   * only be called by the singleton getInstance method.
+   */
+  ThreadPool();
+
+private:
+  using ChunkFunction = void (*)(const void* context, int begin, int end);
+
+  template <typename CHUNK_BODY>
+  static void invokeChunk(const void* context, int begin, int end)
+  {
+    (*static_cast<const CHUNK_BODY*>(context))(begin, end);
+  }
+
+  CHAISHAREDDLL_API void run(int begin,
+                             int end,
+                             Schedule schedule,
+                             int grain_size,
+                             ChunkFunction function,
+                             const void* context);
+
+  void startWorkers(int num_threads);
+
+  void stopWorkers();
+
+  /*!
+   * \brief Wait for loops newer than seen_generation and execute them.
+   */
+  void workerLoop(int thread_id, unsigned long seen_generation);
+
+  /*!
+   * \brief Execute this thread's share of the current loop.
+   */
+  void participate(int thread_id);
+
+  /*!
+   * \brief Take the next chunk from the front of this thread's own range.
+   */
+  bool popRange(int thread_id, int& chunk_begin, int& chunk_end);
+
+  /*!
+   * \brief Move the back half of another thread's range into this thread's.
+   */
+  bool stealRange(int thread_id);
+
+  /*!
+   * \brief Range owned by one thread under the work stealing schedule.
+   *
+   * Padded so that neighbouring ranges do not share a cache line.
+   */
+  struct StealableRange {
+    std::mutex mutex;
+    int begin;
+    int end;
+    char padding[64];
+  };
+
+  std::vector<std::thread> m_workers;
+
+  int m_num_threads;
+
+  std::unique_ptr<StealableRange[]> m_ranges;
+
+  /*!
+   * \brief Serializes loops launched from different host threads.
+   */
+  std::mutex m_launch_mutex;
+
+  std::mutex m_mutex;
+  std::condition_variable m_start;
+  std::condition_variable m_done;
+
+  /*!
+   * Incremented every time a new loop is published to the workers.
+   */
+  unsigned long m_generation;
+  bool m_stop;
+  int m_remaining;
+
+  // Description of the loop currently being executed.
+  int m_begin;
+  int m_end;
+  Schedule m_schedule;
+  int m_grain_size;
+  ChunkFunction m_function;
+  const void* m_context;
+
+  /*!
+   * Region of the thread that launched the loop, which the workers enter
+   * while running its chunks.
+   */
+  Region* m_region;
+  std::atomic<int> m_next;
+};
+
+template <typename CHUNK_BODY>
+void ThreadPool::parallelFor(int begin,
+                             int end,
+                             Schedule schedule,
+                             CHUNK_BODY const& chunk,
+                             int grain_size)
+{
+  if (begin >= end) {
+    return;
+  }
+
+  run(begin, end, schedule, grain_size, &invokeChunk<CHUNK_BODY>, &chunk);
+}
+
+}  // end of namespace chai
+
+#endif  // CHAI_ThreadPool_HPP
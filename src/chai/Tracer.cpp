@@ -0,0 +1,254 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#include "chai/Tracer.hpp"
+
+#include "chai/Instrumentation.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+
+namespace chai
+{
+
+namespace {
+
+/*!
+ * The Tracer while it exists. Threads may exit after it is destroyed.
+ */
+std::atomic<Tracer*> s_live_tracer{nullptr};
+
+const char* kindName(Tracer::Kind kind)
+{
+  switch (kind) {
+    case Tracer::TRACE_ALLOCATE:
+      return "allocate";
+    case Tracer::TRACE_FREE:
+      return "free";
+    case Tracer::TRACE_MOVE:
+      return "move";
+    case Tracer::TRACE_CAPTURE:
+      return "capture";
+    case Tracer::TRACE_EVICT:
+      return "evict";
+    case Tracer::TRACE_SYNCHRONIZE:
+      return "synchronize";
+    case Tracer::TRACE_LAUNCH:
+      return "launch";
+  }
+
+  return "event";
+}
+
+const char* spaceName(ExecutionSpace space)
+{
+  switch (space) {
+    case CPU:
+      return "CPU";
+    case GPU:
+      return "GPU";
+    case UM:
+      return "UM";
+    case PINNED:
+      return "PINNED";
+    default:
+      return "NONE";
+  }
+}
+
+}  // end of anonymous namespace
+
+constexpr size_t Tracer::s_buffer_events;
+
+thread_local Tracer::ThreadBuffer Tracer::s_thread_buffer;
+
+Tracer::ThreadBuffer::~ThreadBuffer()
+{
+  Tracer* tracer = s_live_tracer.load(std::memory_order_acquire);
+
+  if (buffer && tracer) {
+    tracer->release(buffer);
+  }
+}
+
+Tracer* Tracer::getInstance()
+{
+  static Tracer s_tracer_instance;
+  return &s_tracer_instance;
+}
+
+Tracer::Tracer() :
+  m_enabled{false},
+  m_output{},
+  m_epoch{Clock::now()},
+  m_buffers{},
+  m_idle{}
+{
+  // Events point to regions, so the regions must outlive the Tracer.
+  RegionStatistics::getInstance();
+
+  s_live_tracer.store(this, std::memory_order_release);
+
+  const char* env = std::getenv("CHAI_TRACE");
+  if (env && *env) {
+    m_output = env;
+    setEnabled(true);
+  }
+}
+
+Tracer::~Tracer()
+{
+  s_live_tracer.store(nullptr, std::memory_order_release);
+
+  if (!m_output.empty()) {
+    std::ofstream file(m_output);
+    write(file);
+  }
+}
+
+void Tracer::setEnabled(bool enabled)
+{
+  m_enabled = enabled;
+  Instrumentation::setEnabled(INSTRUMENT_TRACER, enabled);
+}
+
+Tracer::Buffer* Tracer::buffer()
+{
+  if (!s_thread_buffer.buffer) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_idle.empty()) {
+      std::unique_ptr<Buffer> created{new Buffer};
+      created->count = 0;
+      created->thread = static_cast<int>(m_buffers.size());
+      s_thread_buffer.buffer = created.get();
+      m_buffers.push_back(std::move(created));
+    } else {
+      s_thread_buffer.buffer = m_idle.back();
+      m_idle.pop_back();
+    }
+  }
+
+  return s_thread_buffer.buffer;
+}
+
+void Tracer::release(Buffer* buffer)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_idle.push_back(buffer);
+}
+
+void Tracer::append(Kind kind,
+                    ExecutionSpace space,
+                    ExecutionSpace source,
+                    size_t bytes,
+                    std::uint64_t start,
+                    std::uint64_t end)
+{
+  Buffer* events = buffer();
+
+  // Only this thread writes to its buffer
+  const std::uint64_t count = events->count.load(std::memory_order_relaxed);
+
+  if (events->events.size() < s_buffer_events &&
+      count == events->events.size()) {
+    events->events.emplace_back();
+  }
+
+  Event& event = events->events[count % s_buffer_events];
+  event.kind = kind;
+  event.space = space;
+  event.source = source;
+  event.bytes = bytes;
+  event.start = start;
+  event.end = end;
+  event.thread = events->thread;
+  event.region = RegionStatistics::current();
+
+  events->count.store(count + 1, std::memory_order_release);
+}
+
+std::vector<Tracer::Event> Tracer::getEvents() const
+{
+  std::vector<Event> events;
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (auto const& buffer : m_buffers) {
+      const std::uint64_t count = buffer->count.load(std::memory_order_acquire);
+      const std::uint64_t first =
+          count > s_buffer_events ? count - s_buffer_events : 0;
+
+      for (std::uint64_t i = first; i < count; ++i) {
+        events.push_back(buffer->events[i % s_buffer_events]);
+      }
+    }
+  }
+
+  std::stable_sort(events.begin(), events.end(), [] (Event const& a, Event const& b) {
+    return a.start < b.start;
+  });
+
+  return events;
+}
+
+void Tracer::write(std::ostream& stream) const
+{
+  const std::vector<Event> events = getEvents();
+
+  stream << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+  stream << std::fixed << std::setprecision(3);
+
+  bool first = true;
+  for (Event const& event : events) {
+    stream << (first ? "\n" : ",\n");
+    first = false;
+
+    stream << "{\"name\":\"" << kindName(event.kind) << "\",\"cat\":\"chai\""
+           << ",\"pid\":0,\"tid\":" << event.thread
+           << ",\"ts\":" << event.start * 1.0e-3;
+
+    if (event.kind == TRACE_MOVE || event.kind == TRACE_EVICT ||
+        event.kind == TRACE_SYNCHRONIZE || event.kind == TRACE_LAUNCH) {
+      stream << ",\"ph\":\"X\",\"dur\":" << (event.end - event.start) * 1.0e-3;
+    } else {
+      stream << ",\"ph\":\"i\",\"s\":\"t\"";
+    }
+
+    stream << ",\"args\":{\"bytes\":" << event.bytes;
+
+    if (event.kind == TRACE_MOVE || event.kind == TRACE_EVICT) {
+      stream << ",\"from\":\"" << spaceName(event.source) << "\""
+             << ",\"to\":\"" << spaceName(event.space) << "\"";
+    } else {
+      stream << ",\"space\":\"" << spaceName(event.space) << "\"";
+    }
+
+    if (event.region && event.region->getParent()) {
+      stream << ",\"region\":\"" << event.region->getPath() << "\"";
+    }
+
+    stream << "}}";
+  }
+
+  stream << "\n]}\n";
+}
+
+void Tracer::clear()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  for (auto const& buffer : m_buffers) {
+    buffer->count.store(0, std::memory_order_release);
+  }
+}
+
+}  // end of namespace chai
@@ -0,0 +1,264 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#ifndef CHAI_Tracer_HPP
+#define CHAI_Tracer_HPP
+
+#include "chai/config.hpp"
+#include "chai/ExecutionSpaces.hpp"
+#include "chai/RegionStatistics.hpp"
+#include "chai/Types.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace chai
+{
+
+/*!
+ * \brief Singleton recording a timeline of the work of the ArrayManager.
+ *
+ * Allocations, frees, moves, captures, evictions, synchronizations and
+ * kernel launches are recorded with their time and thread. Every thread
+ * records into a ring buffer of its own, so recording takes no lock, and
+ * only the newest s_buffer_events events of each thread are kept. Buffers
+ * grow as events are recorded, and the buffer of a thread that exits is
+ * handed to the next thread that records, so threads that come and go do
+ * not add buffers. The
+ * timeline is written in the Chrome trace event format, which chrome://tracing
+ * and Perfetto display.
+ *
+ * Tracing is off by default, and costs a single check per event while it is
+ * off. Setting the CHAI_TRACE environment variable to a file name turns it on,
+ * and writes the timeline to that file at shutdown.
+ */
+class Tracer
+{
+public:
+  /*!
+   * \brief Kinds of recorded events.
+   */
+  enum Kind {
+    TRACE_ALLOCATE,
+    TRACE_FREE,
+    TRACE_MOVE,
+    TRACE_CAPTURE,
+    TRACE_EVICT,
+    TRACE_SYNCHRONIZE,
+    TRACE_LAUNCH
+  };
+
+  /*!
+   * \brief A recorded event.
+   *
+   * Times are in nanoseconds since the Tracer was created. Events without a
+   * duration have the same start and end.
+   */
+  struct Event {
+    Kind kind;
+    ExecutionSpace space;
+    ExecutionSpace source;
+    size_t bytes;
+    std::uint64_t start;
+    std::uint64_t end;
+    int thread;
+
+    /*!
+     * Region of the thread that recorded the event.
+     */
+    Region const* region;
+  };
+
+  /*!
+   * Number of events kept for every thread.
+   */
+  static constexpr size_t s_buffer_events = 1 << 16;
+
+  /*!
+   * \brief Get the singleton instance.
+   *
+   * \return Pointer to the Tracer instance.
+   */
+  CHAISHAREDDLL_API static Tracer* getInstance();
+
+  /*!
+   * \brief Write the timeline if CHAI_TRACE is set.
+   */
+  ~Tracer();
+
+  /*!
+   * \brief Turn tracing on or off.
+   */
+  CHAISHAREDDLL_API void setEnabled(bool enabled);
+
+  /*!
+   * \brief Whether tracing is on.
+   */
+  bool isEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+  /*!
+   * \brief Get the current time of the timeline.
+   */
+  std::uint64_t now() const
+  {
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            Clock::now() - m_epoch).count());
+  }
+
+  /*!
+   * \brief Record an event without a duration.
+   *
+   * \param kind The kind of the event.
+   * \param space The execution space of the event.
+   * \param bytes Number of bytes allocated, freed, moved or captured.
+   */
+  void recordInstant(Kind kind, ExecutionSpace space, size_t bytes = 0)
+  {
+    if (isEnabled()) {
+      const std::uint64_t time = now();
+      append(kind, space, NONE, bytes, time, time);
+    }
+  }
+
+  /*!
+   * \brief Record an event that started at start and ends now.
+   *
+   * \param kind The kind of the event.
+   * \param space The execution space of the event, or the destination of a
+   *        move or eviction.
+   * \param source The source of a move or eviction.
+   * \param bytes Number of bytes allocated, freed, moved or captured.
+   * \param start Time the event started, from now.
+   */
+  void recordSpan(Kind kind,
+                  ExecutionSpace space,
+                  ExecutionSpace source,
+                  size_t bytes,
+                  std::uint64_t start)
+  {
+    if (isEnabled()) {
+      append(kind, space, source, bytes, start, now());
+    }
+  }
+
+  /*!
+   * \brief Get the recorded events of every thread, in order of start time.
+   *
+   * Must not be called while other threads are recording.
+   */
+  CHAISHAREDDLL_API std::vector<Event> getEvents() const;
+
+  /*!
+   * \brief Write the recorded events as a Chrome trace.
+   *
+   * Must not be called while other threads are recording.
+   */
+  CHAISHAREDDLL_API void write(std::ostream& stream) const;
+
+  /*!
+   * \brief Forget the recorded events.
+   *
+   * Must not be called while other threads are recording.
+   */
+  CHAISHAREDDLL_API void clear();
+
+protected:
+  /*!
+   * \brief Construct a new Tracer.
+   *
+   * The constructor is a protected member, ensuring that it can
+   * only be called by the singleton getInstance method.
+   */
+  Tracer();
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  /*!
+   * \brief Ring buffer of the events of one thread.
+   */
+  struct Buffer {
+    int thread;
+
+    /*!
+     * Events, grown up to s_buffer_events as they are recorded.
+     */
+    std::vector<Event> events;
+
+    /*!
+     * Number of events ever recorded, published after each event is written.
+     */
+    std::atomic<std::uint64_t> count;
+  };
+
+  /*!
+   * \brief Add an event to the buffer of the calling thread.
+   */
+  CHAISHAREDDLL_API void append(Kind kind,
+                                ExecutionSpace space,
+                                ExecutionSpace source,
+                                size_t bytes,
+                                std::uint64_t start,
+                                std::uint64_t end);
+
+  /*!
+   * \brief Owner of the buffer of a thread, which gives it back to the
+   *        Tracer when the thread exits.
+   */
+  struct ThreadBuffer {
+    Buffer* buffer = nullptr;
+
+    ~ThreadBuffer();
+  };
+
+  /*!
+   * \brief Get the buffer of the calling thread, taking an idle buffer or
+   *        creating one if needed.
+   */
+  Buffer* buffer();
+
+  /*!
+   * \brief Make the buffer of a thread that exited available to others.
+   *
+   * Its events are kept until the next thread that takes it overwrites them.
+   */
+  void release(Buffer* buffer);
+
+  static thread_local ThreadBuffer s_thread_buffer;
+
+  std::atomic<bool> m_enabled;
+
+  /*!
+   * Value of CHAI_TRACE, if set.
+   */
+  std::string m_output;
+
+  Clock::time_point m_epoch;
+
+  /*!
+   * Protects the list of buffers, not their contents.
+   */
+  mutable std::mutex m_mutex;
+
+  std::vector<std::unique_ptr<Buffer>> m_buffers;
+
+  /*!
+   * Buffers of the threads that exited.
+   */
+  std::vector<Buffer*> m_idle;
+};
+
+}  // end of namespace chai
+
+#endif  // CHAI_Tracer_HPP
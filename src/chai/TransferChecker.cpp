@@ -0,0 +1,307 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#include "chai/TransferChecker.hpp"
+
+#include "chai/Instrumentation.hpp"
+#include "chai/KernelStatistics.hpp"
+#include "chai/Simd.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace chai
+{
+
+namespace {
+
+const char* const s_unknown_kernel = "(unknown)";
+
+const std::uint64_t s_multiplier = 0x9e3779b97f4a7c15ull;
+
+std::uint64_t mix(std::uint64_t value)
+{
+  value ^= value >> 30;
+  value *= 0xbf58476d1ce4e5b9ull;
+  value ^= value >> 27;
+  value *= 0x94d049bb133111ebull;
+  value ^= value >> 31;
+  return value;
+}
+
+std::string arrayName(PointerRecord const* record)
+{
+  if (record->m_name) {
+    return record->m_name;
+  }
+
+  std::ostringstream name;
+  name << record;
+  return name.str();
+}
+
+void printEntries(std::ostream& stream,
+                  const char* title,
+                  std::vector<TransferChecker::Entry> const& entries)
+{
+  size_t name_width = std::strlen(title);
+  std::vector<std::string> names;
+  for (auto const& entry : entries) {
+    names.push_back(entry.region.empty()
+                        ? entry.name
+                        : entry.name + " [" + entry.region + "]");
+    name_width = std::max(name_width, names.back().size());
+  }
+
+  stream << std::left << std::setw(name_width) << title << std::right
+         << std::setw(10) << "moves"
+         << std::setw(12) << "redundant"
+         << std::setw(16) << "bytes wasted" << "\n";
+
+  for (size_t i = 0; i < entries.size(); ++i) {
+    TransferChecker::Entry const& entry = entries[i];
+    if (entry.redundant_moves == 0) {
+      continue;
+    }
+
+    stream << std::left << std::setw(name_width) << names[i] << std::right
+           << std::setw(10) << entry.moves
+           << std::setw(12) << entry.redundant_moves
+           << std::setw(16) << entry.bytes_wasted << "\n";
+  }
+}
+
+}  // end of anonymous namespace
+
+TransferChecker* TransferChecker::getInstance()
+{
+  static TransferChecker s_transfer_checker_instance;
+  return &s_transfer_checker_instance;
+}
+
+TransferChecker::TransferChecker() :
+  m_enabled{false},
+  m_output{},
+  m_states{},
+  m_arrays{},
+  m_kernels{}
+{
+  // Kernel entries point to regions, so the regions must outlive the
+  // TransferChecker.
+  RegionStatistics::getInstance();
+
+  const char* env = std::getenv("CHAI_CHECK_TRANSFERS");
+  if (env && *env) {
+    m_output = env;
+    setEnabled(true);
+  }
+}
+
+TransferChecker::~TransferChecker()
+{
+  if (m_output.empty()) {
+    return;
+  }
+
+  if (m_output == "1") {
+    report(std::cerr);
+  } else {
+    std::ofstream file(m_output);
+    report(file);
+  }
+}
+
+void TransferChecker::setEnabled(bool enabled)
+{
+  m_enabled = enabled;
+  Instrumentation::setEnabled(INSTRUMENT_TRANSFER_CHECKER, enabled);
+
+  if (!enabled) {
+    // Hashes go stale while moves are not checked
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_states.clear();
+  }
+}
+
+std::uint64_t TransferChecker::hash(const void* data, size_t size)
+{
+  using Words = Pack<std::uint64_t>;
+
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  Words lanes = Words::index(SimdIndex{1, Words::width}) * s_multiplier;
+
+  size_t offset = 0;
+  for (; offset + sizeof(Words::lane) <= size; offset += sizeof(Words::lane)) {
+    Words words;
+    std::memcpy(words.lane, bytes + offset, sizeof(Words::lane));
+    lanes = (lanes + words) * s_multiplier;
+  }
+
+  if (offset < size) {
+    Words words(0);
+    std::memcpy(words.lane, bytes + offset, size - offset);
+    lanes = (lanes + words) * s_multiplier;
+  }
+
+  std::uint64_t result = mix(size);
+  for (int l = 0; l < Words::width; ++l) {
+    result = mix(result ^ lanes[l]);
+  }
+
+  return result;
+}
+
+void TransferChecker::touch(PointerRecord const* record,
+                            ExecutionSpace kernel_space)
+{
+  const std::string kernel =
+      KernelStatistics::getInstance()->getKernelName(kernel_space);
+
+  Region const* region = RegionStatistics::current();
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  State& state = m_states[record];
+  state.kernel = kernel;
+  state.region = region;
+}
+
+void TransferChecker::recordTransfer(PointerRecord const* record,
+                                     ExecutionSpace source,
+                                     ExecutionSpace destination,
+                                     const void* data,
+                                     size_t size)
+{
+  const std::uint64_t payload = hash(data, size);
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  State& state = m_states[record];
+  const bool redundant =
+      state.known[destination] && state.hashes[destination] == payload;
+
+  const std::string name = arrayName(record);
+  const std::string kernel =
+      state.kernel.empty() ? std::string(s_unknown_kernel) : state.kernel;
+
+  Entry& array = m_arrays[name];
+  Entry& by_kernel = m_kernels[KernelKey(state.region, kernel)];
+  array.name = name;
+  by_kernel.name = kernel;
+
+  ++array.moves;
+  ++by_kernel.moves;
+
+  if (redundant) {
+    ++array.redundant_moves;
+    array.bytes_wasted += size;
+    ++by_kernel.redundant_moves;
+    by_kernel.bytes_wasted += size;
+  }
+
+  // Both spaces hold the payload once the move is done
+  state.hashes[source] = payload;
+  state.hashes[destination] = payload;
+  state.known[source] = true;
+  state.known[destination] = true;
+}
+
+void TransferChecker::forgetSpace(PointerRecord const* record,
+                                  ExecutionSpace space)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  if (space == NONE) {
+    m_states.erase(record);
+    return;
+  }
+
+  auto found = m_states.find(record);
+  if (found != m_states.end()) {
+    found->second.known[space] = false;
+  }
+}
+
+std::vector<TransferChecker::Entry> TransferChecker::getArrayEntries() const
+{
+  std::vector<Entry> entries;
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto const& entry : m_arrays) {
+      entries.push_back(entry.second);
+    }
+  }
+
+  sort(entries);
+  return entries;
+}
+
+std::vector<TransferChecker::Entry> TransferChecker::getKernelEntries() const
+{
+  std::vector<Entry> entries;
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto const& entry : m_kernels) {
+      entries.push_back(entry.second);
+      if (entry.first.first) {
+        entries.back().region = entry.first.first->getPath();
+      }
+    }
+  }
+
+  sort(entries);
+  return entries;
+}
+
+void TransferChecker::report(std::ostream& stream) const
+{
+  const std::vector<Entry> arrays = getArrayEntries();
+  const std::vector<Entry> kernels = getKernelEntries();
+
+  size_t moves = 0;
+  size_t redundant_moves = 0;
+  size_t bytes_wasted = 0;
+
+  for (auto const& entry : arrays) {
+    moves += entry.moves;
+    redundant_moves += entry.redundant_moves;
+    bytes_wasted += entry.bytes_wasted;
+  }
+
+  stream << redundant_moves << " of " << moves
+         << " moves copied unchanged data, wasting " << bytes_wasted
+         << " bytes\n\n";
+
+  printEntries(stream, "array", arrays);
+  stream << "\n";
+  printEntries(stream, "touched by kernel", kernels);
+}
+
+void TransferChecker::clear()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_states.clear();
+  m_arrays.clear();
+  m_kernels.clear();
+}
+
+void TransferChecker::sort(std::vector<Entry>& entries)
+{
+  std::sort(entries.begin(), entries.end(), [] (Entry const& a, Entry const& b) {
+    if (a.bytes_wasted != b.bytes_wasted) {
+      return a.bytes_wasted > b.bytes_wasted;
+    }
+    return a.name != b.name ? a.name < b.name : a.region < b.region;
+  });
+}
+
+}  // end of namespace chai
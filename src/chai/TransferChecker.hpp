@@ -0,0 +1,234 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#ifndef CHAI_TransferChecker_HPP
+#define CHAI_TransferChecker_HPP
+
+#include "chai/config.hpp"
+#include "chai/ExecutionSpaces.hpp"
+#include "chai/PointerRecord.hpp"
+#include "chai/RegionStatistics.hpp"
+#include "chai/Types.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace chai
+{
+
+/*!
+ * \brief Singleton finding moves that copy data the destination already
+ *        holds.
+ *
+ * Touches are conservative: data() and captures of non-const arrays touch
+ * them whether or not anything is written, and the next move copies them
+ * back. While checking is on, the ArrayManager hashes the source of every
+ * move, and the hash of the data each space holds is kept for every array.
+ * A move whose payload hashes the same as the data already at its
+ * destination is redundant. Its bytes are counted as wasted against the array
+ * and against the kernel that last touched the array, which is where a const
+ * capture would avoid the move. A kernel launched in several regions has an
+ * entry for each region.
+ *
+ * Hashing reads every byte moved, and device data is staged on the host
+ * first, so checking is a diagnostic mode. It is off by default. Setting the
+ * CHAI_CHECK_TRANSFERS environment variable turns it on, and prints the report
+ * at shutdown: to standard error if the variable is 1, and to the file it
+ * names otherwise.
+ */
+class TransferChecker
+{
+public:
+  /*!
+   * \brief Moves checked for one array or kernel.
+   */
+  struct Entry {
+    std::string name;
+
+    /*!
+     * Path of the region a kernel was launched in, or an empty string for
+     * arrays and outside regions.
+     */
+    std::string region;
+
+    size_t moves = 0;
+    size_t redundant_moves = 0;
+    size_t bytes_wasted = 0;
+  };
+
+  /*!
+   * \brief Get the singleton instance.
+   *
+   * \return Pointer to the TransferChecker instance.
+   */
+  CHAISHAREDDLL_API static TransferChecker* getInstance();
+
+  /*!
+   * \brief Print the report if CHAI_CHECK_TRANSFERS is set.
+   */
+  ~TransferChecker();
+
+  /*!
+   * \brief Turn checking on or off.
+   */
+  CHAISHAREDDLL_API void setEnabled(bool enabled);
+
+  /*!
+   * \brief Whether checking is on.
+   */
+  bool isEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+  /*!
+   * \brief Hash size bytes of data.
+   *
+   * The bytes are read as lanes of 64-bit words that are hashed
+   * independently, so the loop vectorizes, and the lanes are mixed at the
+   * end.
+   */
+  CHAISHAREDDLL_API static std::uint64_t hash(const void* data, size_t size);
+
+  /*!
+   * \brief Record that an array was touched by the current kernel.
+   *
+   * \param record The record of the array.
+   * \param kernel_space The execution space of the current kernel, or NONE
+   *        outside kernels.
+   */
+  void recordTouch(PointerRecord const* record, ExecutionSpace kernel_space)
+  {
+    if (isEnabled()) {
+      touch(record, kernel_space);
+    }
+  }
+
+  /*!
+   * \brief Check a move of an array.
+   *
+   * \param record The record of the array.
+   * \param source The space the array is moved from.
+   * \param destination The space the array is moved to.
+   * \param data The data moved, readable on the host.
+   * \param size The number of bytes moved.
+   */
+  CHAISHAREDDLL_API void recordTransfer(PointerRecord const* record,
+                                        ExecutionSpace source,
+                                        ExecutionSpace destination,
+                                        const void* data,
+                                        size_t size);
+
+  /*!
+   * \brief Forget the data of an array in space, which was just allocated.
+   */
+  void forget(PointerRecord const* record, ExecutionSpace space)
+  {
+    if (isEnabled()) {
+      forgetSpace(record, space);
+    }
+  }
+
+  /*!
+   * \brief Forget a record that is about to be deleted.
+   */
+  void forget(PointerRecord const* record)
+  {
+    if (isEnabled()) {
+      forgetSpace(record, NONE);
+    }
+  }
+
+  /*!
+   * \brief Get the entries of every array, by decreasing bytes wasted.
+   *
+   * Arrays are reported under their name, or their record's address.
+   */
+  CHAISHAREDDLL_API std::vector<Entry> getArrayEntries() const;
+
+  /*!
+   * \brief Get the entries of every kernel, by decreasing bytes wasted.
+   *
+   * Kernels are named as by KernelStatistics.
+   */
+  CHAISHAREDDLL_API std::vector<Entry> getKernelEntries() const;
+
+  /*!
+   * \brief Print the entries of the arrays and kernels with redundant moves.
+   */
+  CHAISHAREDDLL_API void report(std::ostream& stream) const;
+
+  /*!
+   * \brief Forget all entries and hashes.
+   */
+  CHAISHAREDDLL_API void clear();
+
+protected:
+  /*!
+   * \brief Construct a new TransferChecker.
+   *
+   * The constructor is a protected member, ensuring that it can
+   * only be called by the singleton getInstance method.
+   */
+  TransferChecker();
+
+private:
+  /*!
+   * \brief What is known of the data of one array.
+   */
+  struct State {
+    std::uint64_t hashes[NUM_EXECUTION_SPACES] = {};
+    bool known[NUM_EXECUTION_SPACES] = {};
+
+    /*!
+     * Kernel that last touched the array, and the region it was launched
+     * in.
+     */
+    std::string kernel;
+    Region const* region = nullptr;
+  };
+
+  using KernelKey = std::pair<Region const*, std::string>;
+
+  CHAISHAREDDLL_API void touch(PointerRecord const* record,
+                               ExecutionSpace kernel_space);
+
+  /*!
+   * \brief Forget the data of record in space, or the record if space is
+   *        NONE.
+   */
+  CHAISHAREDDLL_API void forgetSpace(PointerRecord const* record,
+                                     ExecutionSpace space);
+
+  /*!
+   * \brief Order entries by decreasing bytes wasted.
+   */
+  static void sort(std::vector<Entry>& entries);
+
+  std::atomic<bool> m_enabled;
+
+  /*!
+   * Value of CHAI_CHECK_TRANSFERS, if set.
+   */
+  std::string m_output;
+
+  mutable std::mutex m_mutex;
+
+  std::unordered_map<PointerRecord const*, State> m_states;
+
+  std::unordered_map<std::string, Entry> m_arrays;
+
+  std::map<KernelKey, Entry> m_kernels;
+};
+
+}  // end of namespace chai
+
+#endif  // CHAI_TransferChecker_HPP
@@ -0,0 +1,67 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#include "chai/ArrayManager.hpp"
+#include "chai/ArrayStatistics.hpp"
+#include "chai/KernelStatistics.hpp"
+#include "chai/OperationLog.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+/*!
+ * Replay an operation log written with CHAI_RECORD.
+ *
+ * Usage: chai-replay <log> [repetitions]
+ *
+ * The log is replayed the given number of times, and the time taken and the
+ * movement statistics of the replay are printed, so that a change to the
+ * ArrayManager can be measured on the operations of a real run.
+ */
+int main(int argc, char** argv)
+{
+  if (argc < 2 || argc > 3) {
+    std::cerr << "usage: " << argv[0] << " <log> [repetitions]" << std::endl;
+    return 1;
+  }
+
+  const int repetitions = argc == 3 ? std::atoi(argv[2]) : 1;
+
+  chai::ArrayManager::getInstance();
+  chai::KernelStatistics::getInstance()->setEnabled(true);
+  chai::ArrayStatistics::getInstance()->setEnabled(true);
+
+  size_t operations = 0;
+  double seconds = 0.0;
+
+  for (int i = 0; i < repetitions; ++i) {
+    chai::OperationReplayer replayer;
+
+    const auto start = std::chrono::steady_clock::now();
+    const bool complete = replayer.replay(argv[1]);
+    const auto end = std::chrono::steady_clock::now();
+
+    if (!complete) {
+      std::cerr << argv[1] << ": cannot replay past operation "
+                << replayer.getNumOperations() << std::endl;
+      return 1;
+    }
+
+    operations += replayer.getNumOperations();
+    seconds += std::chrono::duration<double>(end - start).count();
+  }
+
+  std::cout << "Replayed " << operations << " operations in " << seconds
+            << " s (" << (operations ? seconds * 1.0e9 / operations : 0.0)
+            << " ns per operation)\n\n";
+
+  chai::KernelStatistics::getInstance()->report(std::cout);
+  std::cout << "\n";
+  chai::ArrayStatistics::getInstance()->report(std::cout, 20);
+
+  return 0;
+}
@@ -8,24 +8,129 @@
 #define CHAI_forall_HPP
 
 #include "chai/ArrayManager.hpp"
+#include "chai/Event.hpp"
 #include "chai/ExecutionSpaces.hpp"
+#include "chai/KernelQueue.hpp"
+#include "chai/KernelStatistics.hpp"
+#include "chai/ManagedReduceArray.hpp"
+#include "chai/Reducers.hpp"
+#include "chai/Simd.hpp"
+#include "chai/TaskGraph.hpp"
+#include "chai/ThreadPool.hpp"
 #include "chai/config.hpp"
 
 #if defined(CHAI_ENABLE_UM)
 #include <cuda_runtime_api.h>
 #endif
 
+#if defined(CHAI_ENABLE_GPU_SIMULATION_MODE)
+#include "chai/SimulatedDevice.hpp"
+#endif
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
 struct sequential {
 };
-#if defined(CHAI_ENABLE_CUDA) || defined(CHAI_ENABLE_HIP)
+
+/*
+ * \brief Run on the host, splitting the range across the chai::ThreadPool.
+ */
+struct parallel_host {
+  parallel_host(chai::Schedule schedule = chai::SCHEDULE_STATIC) :
+    schedule(schedule) {}
+
+  chai::Schedule schedule;
+};
+
+/*
+ * \brief Run on all threads of the host in the background, and return a
+ * chai::Event for the loop.
+ */
+struct parallel_host_async {
+  parallel_host_async(chai::Schedule schedule = chai::SCHEDULE_STATIC) :
+    schedule(schedule) {}
+
+  chai::Schedule schedule;
+};
+
+/*
+ * \brief Run on the host, balancing irregular iterations by work stealing.
+ */
+struct work_stealing {
+  work_stealing(int grain_size = 0) : grain_size(grain_size) {}
+
+  int grain_size;
+};
+/*
+ * \brief Run on the host in batches of chai::SimdIndex, for bodies written
+ * with chai::Pack loads and stores.
+ */
+struct simd {
+};
+
+/*
+ * \brief Run on a host thread as a task of a chai::TaskGraph, once the tasks
+ * it depends on have completed.
+ */
+struct task_graph {
+  task_graph(chai::TaskGraph& graph) : graph(&graph) {}
+
+  chai::TaskGraph* graph;
+};
+
+#if defined(CHAI_ENABLE_CUDA) || defined(CHAI_ENABLE_HIP) || defined(CHAI_ENABLE_GPU_SIMULATION_MODE)
 struct gpu {
 };
 
 struct gpu_async {};
+
+/*
+ * \brief Run on the GPU in chunks, moving the data for each chunk while the
+ * previous one runs.
+ *
+ * Iteration i of a loop over [begin, end) may only access the part of each
+ * captured array in the same proportion of the array, e.g. element i - begin
+ * of arrays with end - begin elements.
+ */
+struct gpu_pipelined {
+  gpu_pipelined(int num_chunks = 4) : num_chunks(num_chunks) {}
+
+  int num_chunks;
+};
 #endif
 
+/*
+ * Address unique to the body type BODY_TYPE.
+ */
+template <typename BODY_TYPE>
+void const* body_type_site()
+{
+  static const char site = 0;
+  return &site;
+}
+
+/*
+ * Launch site of the kernels with body type LOOP_BODY, under which the
+ * chai::ArrayManager caches their captures. A body passed by value or by
+ * reference has the same site.
+ */
+template <typename LOOP_BODY>
+void const* capture_site()
+{
+  return body_type_site<typename std::decay<LOOP_BODY>::type>();
+}
+
+/*
+ * The caller captures the body and stops timing captures before the loop
+ * runs, so that the time spent in the body is not counted as capture time.
+ */
 template <typename LOOP_BODY>
-void forall_kernel_cpu(int begin, int end, LOOP_BODY body)
+void forall_kernel_cpu(int begin, int end, LOOP_BODY& body)
 {
   for (int i = begin; i < end; ++i) {
     body(i);
@@ -44,11 +149,222 @@ void forall(sequential, int begin, int end, LOOP_BODY body)
   cudaDeviceSynchronize();
 #endif
 
+  rm->setCaptureSite(capture_site<LOOP_BODY>());
+  rm->setExecutionSpace(chai::CPU);
+
+  LOOP_BODY captured(body);
+  chai::KernelStatistics::getInstance()->endCaptures();
+
+  forall_kernel_cpu(begin, end, captured);
+
+  rm->setExecutionSpace(chai::NONE);
+}
+
+/*
+ * Hand the range to the body in batches of chai::SimdIndex::width lanes. Full
+ * batches start at multiples of the width, so the range is split into a
+ * partial head batch, the full batches, and a partial tail batch.
+ */
+template <typename LOOP_BODY>
+void forall_kernel_simd(int begin, int end, LOOP_BODY& body)
+{
+  const int width = chai::SimdIndex::width;
+  const int offset = ((begin % width) + width) % width;
+
+  int first = begin;
+
+  if (offset != 0) {
+    const int head_end = std::min(end, begin - offset + width);
+    body(chai::SimdIndex{first, head_end - first});
+    first = head_end;
+  }
+
+  for (; first + width <= end; first += width) {
+    body(chai::SimdIndex{first, width});
+  }
+
+  if (first < end) {
+    body(chai::SimdIndex{first, end - first});
+  }
+}
+
+/*
+ * \brief Run forall kernel on CPU, a batch of lanes at a time.
+ *
+ * The body takes a chai::SimdIndex instead of an int, and accesses its
+ * arrays with ManagedArray::load and ManagedArray::store.
+ */
+template <typename LOOP_BODY>
+void forall(simd, int begin, int end, LOOP_BODY body)
+{
+  chai::ArrayManager* rm = chai::ArrayManager::getInstance();
+
+#if defined(CHAI_ENABLE_UM)
+  cudaDeviceSynchronize();
+#endif
+
+  rm->setCaptureSite(capture_site<LOOP_BODY>());
+  rm->setExecutionSpace(chai::CPU);
+
+  LOOP_BODY captured(body);
+  chai::KernelStatistics::getInstance()->endCaptures();
+
+  forall_kernel_simd(begin, end, captured);
+
+  rm->setExecutionSpace(chai::NONE);
+}
+
+/*
+ * The caller captures the body exactly once, on the calling thread, and sets
+ * the execution space back to NONE before the loop runs. Every thread of the
+ * pool then shares that captured copy, and copies of arrays made by the body
+ * on the workers are not captures.
+ */
+template <typename LOOP_BODY>
+void forall_kernel_parallel_host(chai::Schedule schedule,
+                                 int grain_size,
+                                 int begin,
+                                 int end,
+                                 LOOP_BODY& body)
+{
+  chai::ThreadPool::getInstance()->parallelFor(
+      begin, end, schedule, [&body] (int chunk_begin, int chunk_end) {
+        for (int i = chunk_begin; i < chunk_end; ++i) {
+          body(i);
+        }
+      }, grain_size);
+}
+
+/*
+ * \brief Run forall kernel on all threads of the CPU.
+ */
+template <typename LOOP_BODY>
+void forall(parallel_host policy, int begin, int end, LOOP_BODY body)
+{
+  chai::ArrayManager* rm = chai::ArrayManager::getInstance();
+
+#if defined(CHAI_ENABLE_UM)
+  cudaDeviceSynchronize();
+#endif
+
+  rm->setCaptureSite(capture_site<LOOP_BODY>());
+  rm->setExecutionSpace(chai::CPU);
+
+  LOOP_BODY captured(body);
+
+  rm->setExecutionSpace(chai::NONE);
+
+  forall_kernel_parallel_host(policy.schedule, 0, begin, end, captured);
+}
+
+/*
+ * \brief Run forall kernel on all threads of the CPU, without waiting for it.
+ *
+ * The body is captured now, and the loop is queued on the host
+ * chai::KernelQueue. The arrays it captures wait for the returned event when
+ * they are next captured, freed or picked; anything else must wait for it
+ * explicitly.
+ */
+template <typename LOOP_BODY>
+chai::Event forall(parallel_host_async policy,
+                   int begin,
+                   int end,
+                   LOOP_BODY&& body)
+{
+  chai::ArrayManager* rm = chai::ArrayManager::getInstance();
+
+#if defined(CHAI_ENABLE_UM)
+  cudaDeviceSynchronize();
+#endif
+
+  using body_type = typename std::decay<LOOP_BODY>::type;
+  std::vector<chai::ArrayManager::Access> accesses;
+
+  rm->setCaptureSite(capture_site<LOOP_BODY>());
+  rm->setExecutionSpace(chai::CPU);
+  rm->beginAccessRecording(accesses);
+
+  std::shared_ptr<body_type> captured = std::make_shared<body_type>(body);
+
+  rm->endAccessRecording();
+
+  // The loop may start before launch returns
+  rm->setExecutionSpace(chai::NONE);
+
+  const chai::Schedule schedule = policy.schedule;
+  chai::KernelQueue* queue = chai::KernelQueue::getHostInstance();
+  chai::Event event(queue, queue->launch([=] () {
+    chai::ThreadPool::getInstance()->parallelFor(
+        begin, end, schedule, [&] (int chunk_begin, int chunk_end) {
+          for (int i = chunk_begin; i < chunk_end; ++i) {
+            (*captured)(i);
+          }
+        });
+  }), chai::CPU);
+
+  rm->registerEvent(event, accesses);
+
+  return event;
+}
+
+/*
+ * \brief Run forall kernel on all threads of the CPU with work stealing.
+ */
+template <typename LOOP_BODY>
+void forall(work_stealing policy, int begin, int end, LOOP_BODY body)
+{
+  chai::ArrayManager* rm = chai::ArrayManager::getInstance();
+
+#if defined(CHAI_ENABLE_UM)
+  cudaDeviceSynchronize();
+#endif
+
+  rm->setCaptureSite(capture_site<LOOP_BODY>());
+  rm->setExecutionSpace(chai::CPU);
+
+  LOOP_BODY captured(body);
+
+  rm->setExecutionSpace(chai::NONE);
+
+  forall_kernel_parallel_host(chai::SCHEDULE_WORK_STEALING,
+                              policy.grain_size,
+                              begin,
+                              end,
+                              captured);
+}
+
+/*
+ * \brief Submit forall kernel to a task graph, to run on the CPU.
+ *
+ * The body is captured now, recording which arrays it reads and writes, and
+ * the loop runs when the graph is run.
+ */
+template <typename LOOP_BODY>
+void forall(task_graph policy, int begin, int end, LOOP_BODY&& body)
+{
+  chai::ArrayManager* rm = chai::ArrayManager::getInstance();
+
+#if defined(CHAI_ENABLE_UM)
+  cudaDeviceSynchronize();
+#endif
+
+  using body_type = typename std::decay<LOOP_BODY>::type;
+  std::vector<chai::ArrayManager::Access> accesses;
+
+  rm->setCaptureSite(capture_site<LOOP_BODY>());
   rm->setExecutionSpace(chai::CPU);
+  rm->beginAccessRecording(accesses);
 
-  forall_kernel_cpu(begin, end, body);
+  std::shared_ptr<body_type> captured = std::make_shared<body_type>(body);
 
+  rm->endAccessRecording();
   rm->setExecutionSpace(chai::NONE);
+
+  policy.graph->submit([=] () {
+    for (int i = begin; i < end; ++i) {
+      (*captured)(i);
+    }
+  }, accesses);
 }
 
 #if defined(CHAI_ENABLE_CUDA) || defined(CHAI_ENABLE_HIP)
@@ -61,25 +377,88 @@ __global__ void forall_kernel_gpu(int start, int length, LOOP_BODY body)
     body(idx+start);
   }
 }
+#endif
 
+#if defined(CHAI_ENABLE_GPU_SIMULATION_MODE)
+/*
+ * Launch a kernel on the chai::SimulatedDevice. The caller captures the body
+ * once, into storage shared with the kernel, before the launch. The blocks of
+ * the grid are handed out to the chai::ThreadPool one block at a time, like
+ * blocks to the multiprocessors of a real device.
+ */
 template <typename LOOP_BODY>
-void forall(gpu_async, int begin, int end, LOOP_BODY&& body)
+chai::Event forall_kernel_simulated(size_t gridSize,
+                                    size_t blockSize,
+                                    int begin,
+                                    int end,
+                                    std::shared_ptr<LOOP_BODY> captured)
+{
+  const int num_blocks = static_cast<int>(gridSize);
+  const int block_size = static_cast<int>(blockSize);
+
+  chai::SimulatedDevice* device = chai::SimulatedDevice::getInstance();
+  return chai::Event(device, device->launch([=] () {
+    chai::ThreadPool::getInstance()->parallelFor(
+        0, num_blocks, chai::SCHEDULE_GUIDED,
+        [&] (int first_block, int last_block) {
+          const int chunk_begin = begin + first_block * block_size;
+          const int chunk_end = std::min(begin + last_block * block_size, end);
+
+          for (int i = chunk_begin; i < chunk_end; ++i) {
+            (*captured)(i);
+          }
+        }, 1);
+  }), chai::GPU);
+}
+#endif
+
+#if defined(CHAI_ENABLE_CUDA) || defined(CHAI_ENABLE_HIP) || defined(CHAI_ENABLE_GPU_SIMULATION_MODE)
+
+/*
+ * \brief Run forall kernel on GPU, without waiting for it.
+ *
+ * The arrays the kernel captures wait for the returned event, rather than
+ * for the whole device, when they are next used outside the GPU.
+ */
+template <typename LOOP_BODY>
+chai::Event forall(gpu_async, int begin, int end, LOOP_BODY&& body)
 {
   chai::ArrayManager* rm = chai::ArrayManager::getInstance();
+  std::vector<chai::ArrayManager::Access> accesses;
 
+  rm->setCaptureSite(capture_site<LOOP_BODY>());
   rm->setExecutionSpace(chai::GPU);
+  rm->beginAccessRecording(accesses);
 
   size_t blockSize = 32;
   size_t gridSize = (end - begin + blockSize - 1) / blockSize;
 #if defined(CHAI_ENABLE_GPU_SIMULATION_MODE)
-  forall_kernel_cpu(begin, end, body);
-#elif defined(CHAI_ENABLE_CUDA)
+  // The simulated kernel may start before launch returns, so the body is
+  // captured first
+  using body_type = typename std::decay<LOOP_BODY>::type;
+  std::shared_ptr<body_type> captured = std::make_shared<body_type>(body);
+
+  rm->endAccessRecording();
+  rm->setExecutionSpace(chai::NONE);
+
+  chai::Event event =
+      forall_kernel_simulated(gridSize, blockSize, begin, end, captured);
+  rm->registerEvent(event, accesses);
+#else
+#if defined(CHAI_ENABLE_CUDA)
   forall_kernel_gpu<<<gridSize, blockSize>>>(begin, end - begin, body);
 #elif defined(CHAI_ENABLE_HIP)
   hipLaunchKernelGGL(forall_kernel_gpu, dim3(gridSize), dim3(blockSize), 0,0,
                      begin, end - begin, body);
 #endif
+  chai::Event event = chai::Event::recordDevice();
+
+  rm->endAccessRecording();
+  rm->registerEvent(event, accesses);
   rm->setExecutionSpace(chai::NONE);
+#endif
+
+  return event;
 }
 
 /*
@@ -87,27 +466,144 @@ void forall(gpu_async, int begin, int end, LOOP_BODY&& body)
  */
 template <typename LOOP_BODY>
 void forall(gpu, int begin, int end, LOOP_BODY&& body)
+{
+  forall(gpu_async(), begin, end, std::forward<LOOP_BODY>(body)).wait();
+}
+
+/*
+ * \brief Run forall kernel on GPU, overlapping the moves with the kernel.
+ *
+ * The body is captured with the copies deferred. Each chunk of the range is
+ * launched as soon as its slice of the data has arrived, and the slice for
+ * the next chunk is copied while it runs.
+ */
+template <typename LOOP_BODY>
+void forall(gpu_pipelined policy, int begin, int end, LOOP_BODY&& body)
 {
   chai::ArrayManager* rm = chai::ArrayManager::getInstance();
 
+  rm->setCaptureSite(capture_site<LOOP_BODY>());
   rm->setExecutionSpace(chai::GPU);
+  rm->beginDeferredTransfers();
 
+  using body_type = typename std::decay<LOOP_BODY>::type;
+#if defined(CHAI_ENABLE_GPU_SIMULATION_MODE)
+  std::shared_ptr<body_type> captured = std::make_shared<body_type>(body);
+#else
+  body_type captured(body);
+#endif
+
+  const int length = end - begin;
+  const int num_chunks = std::max(std::min(policy.num_chunks, length), 1);
   size_t blockSize = 32;
-  size_t gridSize = (end - begin + blockSize - 1) / blockSize;
 
+  for (int chunk = 0; chunk < num_chunks; ++chunk) {
+    const int chunk_begin = begin + static_cast<int>(
+        (static_cast<long long>(length) * chunk) / num_chunks);
+    const int chunk_end = begin + static_cast<int>(
+        (static_cast<long long>(length) * (chunk + 1)) / num_chunks);
+
+    rm->copyDeferredTransfers(chunk, num_chunks);
+
+    size_t gridSize = (chunk_end - chunk_begin + blockSize - 1) / blockSize;
 #if defined(CHAI_ENABLE_GPU_SIMULATION_MODE)
-  forall_kernel_cpu(begin, end, body);
+    forall_kernel_simulated(gridSize, blockSize, chunk_begin, chunk_end,
+                            captured);
 #elif defined(CHAI_ENABLE_CUDA)
-  forall_kernel_gpu<<<gridSize, blockSize>>>(begin, end - begin, body);
-  cudaDeviceSynchronize();
+    forall_kernel_gpu<<<gridSize, blockSize>>>(chunk_begin,
+                                               chunk_end - chunk_begin,
+                                               captured);
 #elif defined(CHAI_ENABLE_HIP)
-  hipLaunchKernelGGL(forall_kernel_gpu, dim3(gridSize), dim3(blockSize), 0,0,
-                     begin, end - begin, body);
-  hipDeviceSynchronize();
+    hipLaunchKernelGGL(forall_kernel_gpu, dim3(gridSize), dim3(blockSize), 0,0,
+                       chunk_begin, chunk_end - chunk_begin, captured);
 #endif
-  
+  }
+
+  rm->endDeferredTransfers();
   rm->setExecutionSpace(chai::NONE);
+
+  chai::synchronize();
+}
+#endif
+
+/*
+ * Policy used to reset and combine the slots of a reducer used by a loop
+ * under the given policy, so that both happen where, and in the order, the
+ * loop itself runs.
+ */
+inline sequential reducer_policy(sequential) { return sequential(); }
+inline sequential reducer_policy(parallel_host) { return sequential(); }
+inline parallel_host_async reducer_policy(parallel_host_async policy)
+{
+  return policy;
 }
+inline sequential reducer_policy(work_stealing) { return sequential(); }
+inline sequential reducer_policy(simd) { return sequential(); }
+inline task_graph reducer_policy(task_graph policy) { return policy; }
+#if defined(CHAI_ENABLE_CUDA) || defined(CHAI_ENABLE_HIP) || defined(CHAI_ENABLE_GPU_SIMULATION_MODE)
+inline gpu_async reducer_policy(gpu) { return gpu_async(); }
+inline gpu_async reducer_policy(gpu_async) { return gpu_async(); }
+inline gpu_async reducer_policy(gpu_pipelined) { return gpu_async(); }
 #endif
 
+/*
+ * Whether loops under POLICY run on a real device. The reducers keep a slot
+ * per thread of the chai::ThreadPool, so only the simulated device can
+ * update them.
+ */
+template <typename POLICY>
+struct runs_on_device : std::false_type {
+};
+#if (defined(CHAI_ENABLE_CUDA) || defined(CHAI_ENABLE_HIP)) && !defined(CHAI_ENABLE_GPU_SIMULATION_MODE)
+template <>
+struct runs_on_device<gpu> : std::true_type {
+};
+template <>
+struct runs_on_device<gpu_async> : std::true_type {
+};
+template <>
+struct runs_on_device<gpu_pipelined> : std::true_type {
+};
+#endif
+
+/*
+ * \brief Run forall kernel with a reduction.
+ *
+ * The reducer is reset before the loop and its slots are combined after it,
+ * under the policy returned by reducer_policy. The combined result stays in
+ * the space the loop ran in until it is read with get. The GPU policies take
+ * a reducer only in GPU simulation mode; builds for a real device reject
+ * them at compile time. Under the asynchronous
+ * policies, the event of the combine is returned, which completes after the
+ * loop. A name set with KernelStatistics::setKernelName applies to all three
+ * kernels.
+ */
+template <typename POLICY, typename REDUCER, typename LOOP_BODY>
+auto forall(POLICY policy, int begin, int end, REDUCER const& reducer, LOOP_BODY&& body)
+    -> typename std::enable_if<
+        std::is_base_of<chai::ReducerBase, REDUCER>::value,
+        decltype(forall(reducer_policy(policy), 0, 1,
+                        std::declval<void (*)(int)>()))>::type
+{
+  static_assert(!runs_on_device<POLICY>::value,
+                "Reducers are updated by host threads; a forall with a reducer "
+                "runs on the GPU only in GPU simulation mode");
+
+  chai::KernelStatistics* statistics = chai::KernelStatistics::getInstance();
+  const std::string name = statistics->getNextKernelName();
+
+  forall(reducer_policy(policy), 0, 1, [=] (int) { reducer.resetSlots(); });
+
+  if (!name.empty()) {
+    statistics->setKernelName(name);
+  }
+  forall(policy, begin, end, std::forward<LOOP_BODY>(body));
+
+  if (!name.empty()) {
+    statistics->setKernelName(name);
+  }
+  return forall(reducer_policy(policy), 0, 1,
+                [=] (int) { reducer.combineSlots(); });
+}
+
 #endif  // CHAI_forall_HPP
@@ -27,8 +27,16 @@
 
 #include "../src/util/forall.hpp"
 
+#include "chai/KernelStatistics.hpp"
 #include "chai/ManagedArray.hpp"
 
+#if defined(CHAI_ENABLE_GPU_SIMULATION_MODE)
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#endif
 
 struct my_point {
   double x;
@@ -48,7 +56,169 @@ TEST(ManagedArray, SetOnHost)
   assert_empty_map(true);
 }
 
+TEST(ManagedArray, SetOnHostParallel)
+{
+  chai::ManagedArray<float> array(1000);
+
+  forall(parallel_host(), 0, 1000, [=](int i) { array[i] = i; });
+
+  forall(parallel_host(chai::SCHEDULE_GUIDED), 0, 1000, [=](int i) {
+    array[i] *= 2.0f;
+  });
+
+  forall(work_stealing(), 0, 1000, [=](int i) {
+    array[i] += 1.0f;
+  });
+
+  forall(sequential(), 0, 1000, [=](int i) {
+    ASSERT_EQ(array[i], 2.0f * i + 1.0f);
+  });
+
+  array.free();
+
+  assert_empty_map(true);
+}
+
 #if (!defined(CHAI_DISABLE_RM))
+TEST(ManagedArray, ParallelHostCapturesOnce)
+{
+  chai::ArrayManager* rm = chai::ArrayManager::getInstance();
+  chai::ManagedArray<float> array(1000);
+
+  int sequential_captures = 0;
+  rm->setGlobalUserCallback([&] (const chai::PointerRecord*, chai::Action action, chai::ExecutionSpace) {
+    if (action == chai::ACTION_CAPTURED) {
+      ++sequential_captures;
+    }
+  });
+  forall(sequential(), 0, 1000, [=](int i) { array[i] = i; });
+
+  int parallel_captures = 0;
+  rm->setGlobalUserCallback([&] (const chai::PointerRecord*, chai::Action action, chai::ExecutionSpace) {
+    if (action == chai::ACTION_CAPTURED) {
+      ++parallel_captures;
+    }
+  });
+  forall(parallel_host(), 0, 1000, [=](int i) { array[i] = i; });
+
+  rm->setGlobalUserCallback(chai::UserCallback());
+
+  ASSERT_EQ(sequential_captures, 1);
+  ASSERT_EQ(parallel_captures, sequential_captures);
+
+  array.free();
+  assert_empty_map(true);
+}
+
+TEST(ManagedArray, SequentialBodyInsideCapture)
+{
+  chai::ArrayManager* rm = chai::ArrayManager::getInstance();
+  chai::ManagedArray<float> array(10);
+
+  int captures = 0;
+  rm->setGlobalUserCallback([&] (const chai::PointerRecord*, chai::Action action, chai::ExecutionSpace) {
+    if (action == chai::ACTION_CAPTURED) {
+      ++captures;
+    }
+  });
+
+  // The sequential body runs in the CPU space, so its copies are captures
+  int inside_capture = 0;
+  forall(sequential(), 0, 10, [=, &inside_capture] (int i) {
+    if (rm->getExecutionSpace() == chai::CPU) {
+      ++inside_capture;
+    }
+    chai::ManagedArray<float> copy = array;
+    copy[i] = i;
+  });
+
+  rm->setGlobalUserCallback(chai::UserCallback());
+
+  ASSERT_EQ(captures, 11);
+  ASSERT_EQ(inside_capture, 10);
+
+  array.free();
+  assert_empty_map(true);
+}
+
+TEST(ManagedArray, ParallelHostBodyOutsideCapture)
+{
+  chai::ArrayManager* rm = chai::ArrayManager::getInstance();
+  chai::ManagedArray<float> array(1000);
+
+  std::atomic<int> captures{0};
+  rm->setGlobalUserCallback([&] (const chai::PointerRecord*, chai::Action action, chai::ExecutionSpace) {
+    if (action == chai::ACTION_CAPTURED) {
+      ++captures;
+    }
+  });
+
+  // Copies made by the body on the workers are not captures
+  std::atomic<int> inside_capture{0};
+  auto body = [=, &inside_capture] (int i) {
+    if (rm->getExecutionSpace() != chai::NONE) {
+      ++inside_capture;
+    }
+    chai::ManagedArray<float> copy = array;
+    copy[i] = i;
+  };
+
+  forall(parallel_host(), 0, 1000, body);
+  forall(work_stealing(), 0, 1000, body);
+
+  rm->setGlobalUserCallback(chai::UserCallback());
+
+  ASSERT_EQ(captures.load(), 2);
+  ASSERT_EQ(inside_capture.load(), 0);
+
+  array.free();
+  assert_empty_map(true);
+}
+
+TEST(ManagedArray, ParallelHostAsyncBodyOutsideCapture)
+{
+  chai::ArrayManager* rm = chai::ArrayManager::getInstance();
+  chai::ManagedArray<float> array(1000);
+
+  std::atomic<int> captures{0};
+  rm->setGlobalUserCallback([&] (const chai::PointerRecord*, chai::Action action, chai::ExecutionSpace) {
+    if (action == chai::ACTION_CAPTURED) {
+      ++captures;
+    }
+  });
+
+  std::atomic<bool> released{false};
+  std::atomic<bool>* release = &released;
+  std::atomic<int> inside_capture{0};
+  std::atomic<int>* inside = &inside_capture;
+
+  chai::Event event = forall(parallel_host_async(), 0, 1000, [=] (int i) {
+    while (!release->load()) {
+      std::this_thread::yield();
+    }
+    if (rm->getExecutionSpace() != chai::NONE) {
+      ++*inside;
+    }
+    chai::ManagedArray<float> copy = array;
+    copy[i] = i;
+  });
+
+  // The body runs while this thread is in the middle of another capture,
+  // and its copies are still not captures
+  rm->setExecutionSpace(chai::CPU);
+  released = true;
+  event.wait();
+  rm->setExecutionSpace(chai::NONE);
+
+  rm->setGlobalUserCallback(chai::UserCallback());
+
+  ASSERT_EQ(captures.load(), 1);
+  ASSERT_EQ(inside_capture.load(), 0);
+
+  array.free();
+  assert_empty_map(true);
+}
+
 TEST(ManagedArray, Const)
 {
   chai::ManagedArray<float> array(10);
@@ -1978,4 +2148,698 @@ GPU_TEST(ManagedArray, NoAllocationNullGPU)
 
   forall(sequential(), 0, 10, [=](int i) { ASSERT_EQ(array[i], i); });
 }
+
+GPU_TEST(ManagedArray, PipelinedGPU)
+{
+  chai::ManagedArray<double> input(1000);
+  chai::ManagedArray<double> output(1000);
+
+  forall(sequential(), 0, 1000, [=](int i) { input[i] = i; });
+
+  forall(gpu_pipelined(7), 0, 1000, [=] __device__ (int i) {
+    output[i] = 2.0 * input[i];
+  });
+
+  forall(sequential(), 0, 1000, [=](int i) { ASSERT_EQ(output[i], 2.0 * i); });
+
+  input.free();
+  output.free();
+}
+#endif
+
+#if (!defined(CHAI_DISABLE_RM))
+TEST(ManagedArray, MovePlanReplay)
+{
+  chai::ArrayManager* rm = chai::ArrayManager::getInstance();
+  chai::ManagedArray<int> input(10);
+  chai::ManagedArray<int> output(10);
+
+  forall(sequential(), 0, 10, [=] (int i) { input[i] = i; });
+
+  auto timestep = [&] (int cycle) {
+    forall(sequential(), 0, 10, [=] (int i) { output[i] = input[i] + cycle; });
+    forall(sequential(), 0, 10, [=] (int i) { input[i] = output[i]; });
+  };
+
+  chai::MovePlan plan;
+  rm->beginCapture(plan);
+  timestep(1);
+  rm->endCapture();
+
+  ASSERT_EQ(plan.getNumKernels(), 2u);
+  ASSERT_EQ(plan.getNumCaptures(), 4u);
+
+  for (int cycle = 2; cycle <= 4; ++cycle) {
+    rm->beginReplay(plan);
+    timestep(cycle);
+    ASSERT_TRUE(rm->endReplay());
+  }
+
+  // 1 + 2 + 3 + 4 added to every element
+  forall(sequential(), 0, 10, [=] (int i) { ASSERT_EQ(input[i], i + 10); });
+
+  // A different sequence falls back to the normal path
+  rm->beginReplay(plan);
+  forall(sequential(), 0, 10, [=] (int i) { input[i] += 1; });
+  forall(sequential(), 0, 10, [=] (int i) { output[i] = input[i]; });
+  forall(sequential(), 0, 10, [=] (int i) { input[i] = output[i]; });
+  ASSERT_FALSE(rm->endReplay());
+
+  forall(sequential(), 0, 10, [=] (int i) { ASSERT_EQ(input[i], i + 11); });
+
+  input.free();
+  output.free();
+}
+#endif
+
+TEST(ManagedArray, TaskGraph)
+{
+  chai::ManagedArray<int> a(100);
+  chai::ManagedArray<int> b(100);
+  chai::ManagedArray<int> sum(100);
+
+  // Only captures of const arrays are known to be read-only
+  chai::ManagedArray<const int> a_in = a;
+  chai::ManagedArray<const int> b_in = b;
+
+  chai::TaskGraph graph;
+
+  forall(task_graph(graph), 0, 100, [=] (int i) { a[i] = i; });
+  forall(task_graph(graph), 0, 100, [=] (int i) { b[i] = 2 * i; });
+  forall(task_graph(graph), 0, 100, [=] (int i) { sum[i] = a_in[i] + b_in[i]; });
+  forall(task_graph(graph), 0, 100, [=] (int i) { a[i] = 0; });
+
+  ASSERT_EQ(graph.getNumTasks(), 4u);
+#if !defined(CHAI_DISABLE_RM)
+  // sum waits for a and b, and the second write to a waits for sum
+  ASSERT_EQ(graph.getNumDependencies(), 4u);
+#endif
+
+  graph.run();
+
+  forall(sequential(), 0, 100, [=] (int i) {
+    ASSERT_EQ(sum[i], 3 * i);
+    ASSERT_EQ(a[i], 0);
+  });
+
+  a.free();
+  b.free();
+  sum.free();
+}
+
+template <typename POLICY>
+void testReductions(POLICY policy)
+{
+  chai::ManagedArray<double> array(1000);
+  forall(sequential(), 0, 1000, [=] (int i) { array[i] = (i * 37) % 1000; });
+
+  chai::ReduceSum<double> sum;
+  chai::ReduceMax<double> max(-1.0);
+  chai::ReduceMinLoc<double> min(1.0e10);
+
+  for (int repeat = 0; repeat < 2; ++repeat) {
+    forall(policy, 0, 1000, sum, [=] (int i) { sum += array[i]; });
+    forall(policy, 0, 1000, max, [=] (int i) { max.max(array[i]); });
+    forall(policy, 0, 1000, min, [=] (int i) { min.minloc(array[i], i); });
+  }
+
+  ASSERT_EQ(sum.get(), 999.0 * 1000.0 / 2.0);
+  ASSERT_EQ(max.get(), 999.0);
+  ASSERT_EQ(min.get(), 0.0);
+  ASSERT_EQ(min.getLoc(), 0);
+
+  sum.free();
+  max.free();
+  min.free();
+  array.free();
+}
+
+TEST(ManagedArray, ReduceSequential)
+{
+  testReductions(sequential());
+}
+
+TEST(ManagedArray, ReduceParallelHost)
+{
+  testReductions(parallel_host(chai::SCHEDULE_GUIDED));
+  testReductions(work_stealing());
+}
+
+TEST(ManagedArray, ReduceParallelHostAsync)
+{
+  chai::ManagedArray<int> array(1000);
+  forall(sequential(), 0, 1000, [=] (int i) { array[i] = i; });
+
+  chai::ReduceSum<long> sum;
+  chai::Event event = forall(parallel_host_async(), 0, 1000, sum, [=] (int i) {
+    sum += array[i];
+  });
+
+  // The event is the combine's, which runs after the loop
+  event.wait();
+  ASSERT_TRUE(event.isComplete());
+  ASSERT_EQ(sum.get(), 999L * 1000L / 2L);
+
+  sum.free();
+  array.free();
+}
+
+template <typename POLICY>
+void testScatterAdd(POLICY policy, chai::ReduceStrategy strategy)
+{
+  chai::ManagedArray<int> zone_to_node(1000);
+  chai::ManagedArray<double> node_value(10);
+
+  forall(sequential(), 0, 1000, [=] (int i) { zone_to_node[i] = (7 * i) % 10; });
+  forall(sequential(), 0, 10, [=] (int i) { node_value[i] = 1.0; });
+
+  chai::ManagedReduceArray<double> node_sum(node_value, strategy);
+
+  forall(policy, 0, 1000, node_sum, [=] (int i) {
+    node_sum.add(zone_to_node[i], 1.0);
+  });
+
+  forall(sequential(), 0, 10, [=] (int i) { ASSERT_EQ(node_value[i], 101.0); });
+
+  node_sum.free();
+  zone_to_node.free();
+  node_value.free();
+}
+
+TEST(ManagedArray, ScatterAdd)
+{
+  testScatterAdd(sequential(), chai::REDUCE_AUTO);
+  testScatterAdd(parallel_host(), chai::REDUCE_PRIVATIZE);
+  testScatterAdd(work_stealing(), chai::REDUCE_PRIVATIZE);
+#if defined(CHAI_HAS_HOST_ATOMICS)
+  testScatterAdd(parallel_host(), chai::REDUCE_ATOMIC);
+#endif
+}
+
+TEST(ManagedArray, Simd)
+{
+  chai::ManagedArray<float> x(100);
+  chai::ManagedArray<float> y(100);
+
+  forall(sequential(), 0, 100, [=] (int i) {
+    x[i] = i;
+    y[i] = -1.0f;
+  });
+
+  // Every batch other than the first and last is full and aligned
+  forall(simd(), 3, 97, [=] (chai::SimdIndex i) {
+    if (i.first != 3 && i.first + i.lanes != 97) {
+      ASSERT_TRUE(i.full());
+      ASSERT_EQ(i.first % chai::SimdIndex::width, 0);
+    }
+
+    y.store(i, 2.0f * x.load(i) + 1.0f);
+  });
+
+  forall(sequential(), 0, 100, [=] (int i) {
+    if (i < 3 || i >= 97) {
+      ASSERT_EQ(y[i], -1.0f);
+    } else {
+      ASSERT_EQ(y[i], 2.0f * i + 1.0f);
+    }
+  });
+
+  chai::ReduceSum<float> sum;
+  forall(simd(), 0, 100, sum, [=] (chai::SimdIndex i) {
+    sum += x.load(i).sum(i.lanes);
+  });
+  ASSERT_EQ(sum.get(), 4950.0f);
+
+  sum.free();
+  x.free();
+  y.free();
+}
+
+TEST(ManagedArray, AsyncHostEvent)
+{
+  chai::ManagedArray<int> written(1000);
+  chai::ManagedArray<int> other(10);
+
+  std::atomic<bool> released{false};
+  std::atomic<bool>* release = &released;
+
+  forall(sequential(), 0, 10, [=] (int i) { other[i] = i; });
+
+  chai::Event event = forall(parallel_host_async(), 0, 1000, [=] (int i) {
+    while (!release->load()) {
+      std::this_thread::yield();
+    }
+    written[i] = i;
+  });
+
+  // Arrays the kernel did not capture are not held up by it
+  forall(sequential(), 0, 10, [=] (int i) { other[i] += 1; });
+  ASSERT_FALSE(event.isComplete());
+
+  released = true;
+
+  // Capturing the array waits for the kernel that wrote it
+  forall(sequential(), 0, 1000, [=] (int i) { ASSERT_EQ(written[i], i); });
+  ASSERT_TRUE(event.isComplete());
+
+  event.wait();
+
+  written.free();
+  other.free();
+}
+
+#if defined(CHAI_ENABLE_GPU_SIMULATION_MODE)
+TEST(ManagedArray, SimulatedKernel)
+{
+  const size_t num_pointers =
+      chai::ArrayManager::getInstance()->getPointerMap().size();
+  chai::ManagedArray<int> array(1000);
+
+  forall(gpu(), 0, 1000, [=] (int i) {
+    array[i] = i;
+  });
+
+  forall(sequential(), 0, 1000, [=] (int i) { ASSERT_EQ(array[i], i); });
+
+  array.free();
+  ASSERT_EQ(chai::ArrayManager::getInstance()->getPointerMap().size(),
+            num_pointers);
+}
+
+TEST(ManagedArray, SimulatedAsyncKernel)
+{
+  const size_t num_pointers =
+      chai::ArrayManager::getInstance()->getPointerMap().size();
+  chai::ManagedArray<int> array(1000);
+
+  std::atomic<bool> released{false};
+  std::atomic<bool>* release = &released;
+
+  forall(gpu_async(), 0, 1000, [=] (int i) {
+    while (!release->load()) {
+      std::this_thread::yield();
+    }
+    array[i] = i;
+  });
+
+  // The kernel cannot complete until it is released, so getting here means
+  // the launch returned without waiting for it.
+  ASSERT_TRUE(chai::SimulatedDevice::getInstance()->busy());
+  released = true;
+
+  // Capturing the array on the host waits for the kernel that wrote it
+  forall(sequential(), 0, 1000, [=] (int i) { ASSERT_EQ(array[i], i); });
+  ASSERT_FALSE(chai::SimulatedDevice::getInstance()->busy());
+
+  array.free();
+  ASSERT_EQ(chai::ArrayManager::getInstance()->getPointerMap().size(),
+            num_pointers);
+}
+
+TEST(ManagedArray, SimulatedAsyncKernelsInOrder)
+{
+  chai::ArrayManager* rm = chai::ArrayManager::getInstance();
+  const size_t num_pointers =
+      chai::ArrayManager::getInstance()->getPointerMap().size();
+  chai::ManagedArray<int> array(1000);
+
+  forall(sequential(), 0, 1000, [=] (int i) { array[i] = 0; });
+
+  chai::Event last;
+  for (int k = 0; k < 10; ++k) {
+    last = forall(gpu_async(), 0, 1000, [=] (int i) {
+      array[i] += i;
+    });
+  }
+
+  // Waiting for the last kernel covers the ones launched before it, and the
+  // kernels have events, so there is nothing left for a global synchronize.
+  last.wait();
+  ASSERT_FALSE(chai::SimulatedDevice::getInstance()->busy());
+  ASSERT_FALSE(rm->syncIfNeeded());
+
+  forall(sequential(), 0, 1000, [=] (int i) { ASSERT_EQ(array[i], 10 * i); });
+
+  array.free();
+  ASSERT_EQ(chai::ArrayManager::getInstance()->getPointerMap().size(),
+            num_pointers);
+}
+
+TEST(ManagedArray, SimulatedAsyncEvent)
+{
+  chai::ArrayManager* rm = chai::ArrayManager::getInstance();
+  chai::ManagedArray<int> written(1000);
+  chai::ManagedArray<int> other(1000);
+
+  forall(gpu(), 0, 1000, [=] (int i) { other[i] = i; });
+  rm->syncIfNeeded();
+
+  std::atomic<bool> released{false};
+  std::atomic<bool>* release = &released;
+
+  chai::Event event = forall(gpu_async(), 0, 1000, [=] (int i) {
+    while (!release->load()) {
+      std::this_thread::yield();
+    }
+    written[i] = i;
+  });
+
+  // Moving an array the pending kernel did not capture back to the host only
+  // waits for the kernel that wrote it
+  forall(sequential(), 0, 1000, [=] (int i) { ASSERT_EQ(other[i], i); });
+  ASSERT_FALSE(event.isComplete());
+
+  released = true;
+
+#if defined(CHAI_ENABLE_PICK)
+  ASSERT_EQ(written.pick(999), 999);
+  ASSERT_TRUE(event.isComplete());
+#endif
+
+  forall(sequential(), 0, 1000, [=] (int i) { ASSERT_EQ(written[i], i); });
+
+  written.free();
+  other.free();
+}
+
+TEST(ManagedArray, SimulatedPipelinedKernel)
+{
+  chai::ArrayManager::getInstance()->setGlobalUserCallback(chai::UserCallback());
+  const size_t num_pointers =
+      chai::ArrayManager::getInstance()->getPointerMap().size();
+
+  chai::SimulatedDevice* device = chai::SimulatedDevice::getInstance();
+  device->setCopyBandwidth(1.0e9);
+
+  chai::ManagedArray<double> input(100000);
+  chai::ManagedArray<double> output(100000);
+
+  forall(sequential(), 0, 100000, [=] (int i) {
+    input[i] = i;
+    output[i] = 0.0;
+  });
+
+  int moves = 0;
+  chai::ArrayManager::getInstance()->setGlobalUserCallback(
+      [&] (const chai::PointerRecord*, chai::Action action, chai::ExecutionSpace space) {
+        if (action == chai::ACTION_MOVE && space == chai::GPU) {
+          ++moves;
+        }
+      });
+
+  forall(gpu_pipelined(7), 0, 100000, [=] (int i) {
+    output[i] = 2.0 * input[i];
+  });
+
+  chai::ArrayManager::getInstance()->setGlobalUserCallback(chai::UserCallback());
+  device->setCopyBandwidth(0.0);
+
+  // Each array is moved once, however many chunks it is copied in
+  ASSERT_EQ(moves, 2);
+
+  forall(sequential(), 0, 100000, [=] (int i) {
+    ASSERT_EQ(output[i], 2.0 * i);
+  });
+
+  input.free();
+  output.free();
+  ASSERT_EQ(chai::ArrayManager::getInstance()->getPointerMap().size(),
+            num_pointers);
+}
+
+TEST(ManagedArray, SimulatedCopyModel)
+{
+  chai::SimulatedDevice* device = chai::SimulatedDevice::getInstance();
+
+  chai::CopyModel model;
+  model.latency = 2.0e-3;
+  model.bandwidth = 1.0e9;
+  device->setCopyModel(model);
+  device->clearCopyTotals();
+
+  chai::ManagedArray<double> array(500000);
+  forall(sequential(), 0, 500000, [=] (int i) { array[i] = i; });
+
+  const auto start = std::chrono::steady_clock::now();
+  forall(gpu(), 0, 500000, [=] (int i) { array[i] *= 2.0; });
+  forall(sequential(), 0, 500000, [=] (int i) { ASSERT_EQ(array[i], 2.0 * i); });
+  const double elapsed = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+
+  // Both moves pay the latency, and 4 ms for 4 MB at 1 GB/s
+  const chai::SimulatedDevice::CopyTotals totals = device->getCopyTotals();
+  ASSERT_EQ(totals.copies, 2u);
+  ASSERT_EQ(totals.bytes, 2 * 500000 * sizeof(double));
+  ASSERT_GE(totals.seconds, 2 * (2.0e-3 + 4.0e-3) - 1.0e-6);
+  ASSERT_GE(elapsed, totals.seconds - 1.0e-6);
+
+  device->setCopyModel(chai::CopyModel());
+  ASSERT_FALSE(device->isCopyModeled());
+
+  array.free();
+}
+
+TEST(ManagedArray, SimulatedCopyContention)
+{
+  chai::SimulatedDevice* device = chai::SimulatedDevice::getInstance();
+
+  const size_t size = 1 << 20;
+  std::vector<char> host(size, 'a');
+  std::vector<char> other(size, 'b');
+  std::vector<char> remote(size);
+  std::vector<char> back(size);
+
+  // 20 ms for each copy on a link to itself
+  chai::CopyModel model;
+  model.bandwidth = size / 20.0e-3;
+  model.duplex = true;
+  device->setCopyModel(model);
+
+  double seconds[2] = {0.0, 0.0};
+
+  // Copies in opposite directions have a link each
+  std::thread to_device([&] {
+    seconds[0] = device->copy(remote.data(), host.data(), size,
+                              chai::SimulatedDevice::COPY_TO_DEVICE);
+  });
+  seconds[1] = device->copy(back.data(), other.data(), size,
+                            chai::SimulatedDevice::COPY_FROM_DEVICE);
+  to_device.join();
+
+  ASSERT_NEAR(seconds[0], 20.0e-3, 1.0e-6);
+  ASSERT_NEAR(seconds[1], 20.0e-3, 1.0e-6);
+  ASSERT_EQ(remote[0], 'a');
+  ASSERT_EQ(back[size - 1], 'b');
+
+  // Copies in the same direction take turns on the link, so a copy made
+  // while another one holds the link ends after it
+  const size_t copies = device->getCopyTotals().copies;
+  const auto start = std::chrono::steady_clock::now();
+
+  std::thread first([&] {
+    seconds[0] = device->copy(remote.data(), host.data(), size);
+  });
+
+  while (device->getCopyTotals().copies == copies) {
+  }
+
+  seconds[1] = device->copy(back.data(), other.data(), size);
+  const double elapsed = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  first.join();
+
+  ASSERT_GE(seconds[1], 20.0e-3 - 1.0e-6);
+  ASSERT_GE(elapsed, 40.0e-3 - 1.0e-6);
+
+  // Unless each copy gets the whole bandwidth
+  model.contention = false;
+  device->setCopyModel(model);
+
+  std::thread concurrent([&] {
+    seconds[0] = device->copy(remote.data(), host.data(), size);
+  });
+  seconds[1] = device->copy(back.data(), other.data(), size);
+  concurrent.join();
+
+  ASSERT_NEAR(seconds[0], 20.0e-3, 1.0e-6);
+  ASSERT_NEAR(seconds[1], 20.0e-3, 1.0e-6);
+
+  device->setCopyModel(chai::CopyModel());
+}
+
+TEST(ManagedArray, SimulatedMovePlanReplay)
+{
+  chai::ArrayManager* rm = chai::ArrayManager::getInstance();
+  rm->setGlobalUserCallback(chai::UserCallback());
+
+  chai::ManagedArray<int> input(100);
+  chai::ManagedArray<int> device(100);
+  chai::ManagedArray<int> host(100);
+  chai::ManagedArray<int> output(100);
+
+  forall(sequential(), 0, 100, [=] (int i) { input[i] = i; });
+
+  chai::KernelStatistics* statistics = chai::KernelStatistics::getInstance();
+
+  auto timestep = [&] (int cycle) {
+    statistics->setKernelName("scale");
+    forall(gpu(), 0, 100, [=] (int i) { device[i] = input[i] * cycle; });
+    statistics->setKernelName("fill");
+    forall(sequential(), 0, 100, [=] (int i) { host[i] = cycle; });
+    statistics->setKernelName("add");
+    forall(sequential(), 0, 100, [=] (int i) { output[i] = device[i] + host[i]; });
+  };
+
+  // The plan is recorded once device has been written on the host, as it
+  // is in every later cycle
+  timestep(1);
+
+  chai::MovePlan plan;
+  rm->beginCapture(plan);
+  timestep(1);
+  rm->endCapture();
+
+  // device to the GPU, then back to the host ahead of the last kernel
+  ASSERT_EQ(plan.getNumKernels(), 3u);
+  ASSERT_EQ(plan.getNumMoves(), 2u);
+  ASSERT_EQ(plan.getNumHoistedMoves(), 1u);
+
+  int moves = 0;
+  rm->setGlobalUserCallback(
+      [&] (const chai::PointerRecord*, chai::Action action, chai::ExecutionSpace) {
+        if (action == chai::ACTION_MOVE) {
+          ++moves;
+        }
+      });
+
+  statistics->setEnabled(true);
+
+  for (int cycle = 2; cycle <= 3; ++cycle) {
+    moves = 0;
+    statistics->clear();
+    const size_t replayed = rm->getNumReplayedCaptures();
+
+    rm->beginReplay(plan);
+    timestep(cycle);
+    ASSERT_TRUE(rm->endReplay());
+
+    // input stays on the GPU, while device goes there and back
+    ASSERT_EQ(moves, 2);
+
+    // Every capture found its array in place, and the move of device back
+    // to the host was issued by the kernel before the one reading it
+    ASSERT_EQ(rm->getNumReplayedCaptures() - replayed, plan.getNumCaptures());
+    for (auto const& entry : statistics->getEntries()) {
+      if (entry.name == "scale" || entry.name == "fill") {
+        ASSERT_EQ(entry.moves, 1u);
+      } else if (entry.name == "add") {
+        ASSERT_EQ(entry.moves, 0u);
+      }
+    }
+
+    forall(sequential(), 0, 100, [=] (int i) {
+      ASSERT_EQ(output[i], i * cycle + cycle);
+    });
+  }
+
+  // Without the plan, device moves back to the host in the kernel reading it
+  moves = 0;
+  statistics->clear();
+  const size_t replayed = rm->getNumReplayedCaptures();
+  timestep(4);
+  ASSERT_EQ(moves, 2);
+  ASSERT_EQ(rm->getNumReplayedCaptures(), replayed);
+  for (auto const& entry : statistics->getEntries()) {
+    if (entry.name == "fill") {
+      ASSERT_EQ(entry.moves, 0u);
+    } else if (entry.name == "add") {
+      ASSERT_EQ(entry.moves, 1u);
+    }
+  }
+
+  statistics->setEnabled(false);
+  statistics->clear();
+  rm->setGlobalUserCallback(chai::UserCallback());
+
+  input.free();
+  device.free();
+  host.free();
+  output.free();
+}
+
+TEST(ManagedArray, SimulatedMovePlanReplayAfterAsync)
+{
+  chai::ArrayManager* rm = chai::ArrayManager::getInstance();
+  chai::ManagedArray<int> array(1000);
+  chai::ManagedArray<int> copy(1000);
+
+  forall(sequential(), 0, 1000, [=] (int i) { array[i] = 0; });
+
+  std::atomic<bool> released{true};
+  std::atomic<bool>* release = &released;
+
+  auto timestep = [&] (int cycle) {
+    forall(gpu_async(), 0, 1000, [=] (int i) {
+      while (!release->load()) {
+        std::this_thread::yield();
+      }
+      array[i] = i * cycle;
+    });
+    forall(sequential(), 0, 1000, [=] (int i) { copy[i] = array[i]; });
+  };
+
+  chai::MovePlan plan;
+  rm->beginCapture(plan);
+  timestep(1);
+  rm->endCapture();
+
+  // The planned move back to the host must wait for the writer, which is
+  // only released once the replay has reached it
+  released = false;
+  std::thread releaser([=] () {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    release->store(true);
+  });
+
+  rm->beginReplay(plan);
+  timestep(2);
+  ASSERT_TRUE(rm->endReplay());
+
+  releaser.join();
+
+  forall(sequential(), 0, 1000, [=] (int i) { ASSERT_EQ(copy[i], 2 * i); });
+
+  array.free();
+  copy.free();
+}
+
+TEST(ManagedArray, SimulatedReduce)
+{
+  testReductions(gpu());
+  testReductions(gpu_async());
+  testReductions(gpu_pipelined());
+
+  // The combined result stays on the device for the next kernel
+  chai::ManagedArray<int> array(100);
+  chai::ReduceSum<int> sum;
+
+  forall(sequential(), 0, 100, [=] (int i) { array[i] = 1; });
+  forall(gpu(), 0, 100, sum, [=] (int i) { sum += array[i]; });
+
+  chai::ManagedArray<int> total = sum.getManaged();
+  forall(gpu(), 0, 100, [=] (int i) { array[i] = total[0]; });
+
+  forall(sequential(), 0, 100, [=] (int i) { ASSERT_EQ(array[i], 100); });
+
+  sum.free();
+  array.free();
+}
+
+TEST(ManagedArray, SimulatedScatterAdd)
+{
+  testScatterAdd(gpu(), chai::REDUCE_PRIVATIZE);
+#if defined(CHAI_HAS_HOST_ATOMICS)
+  testScatterAdd(gpu_async(), chai::REDUCE_ATOMIC);
+#endif
+}
 #endif
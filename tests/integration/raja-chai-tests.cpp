@@ -24,6 +24,9 @@
 #if defined(RAJA_ENABLE_CUDA)
 #define PARALLEL_RAJA_DEVICE __device__
   using parallel_raja_policy = RAJA::cuda_exec<16>;
+#elif defined(RAJA_ENABLE_HIP)
+#define PARALLEL_RAJA_DEVICE __device__
+  using parallel_raja_policy = RAJA::hip_exec<16>;
 #elif defined(RAJA_ENABLE_OPENMP)
 #define PARALLEL_RAJA_DEVICE
   using parallel_raja_policy = RAJA::omp_parallel_for_exec;
@@ -64,6 +67,103 @@ CUDA_TEST(ChaiTest, Simple)
   }
 }
 
+CUDA_TEST(ChaiTest, RelaunchHitsCaptureCache)
+{
+  chai::ArrayManager* rm = chai::ArrayManager::getInstance();
+  rm->enableCaptureCache();
+
+  chai::ManagedArray<float> v1(10);
+  chai::ManagedArray<float> v2(10);
+
+  RAJA::forall<RAJA::seq_exec>(RAJA::RangeSegment(0, 10), [=](int i) {
+    v1[i] = static_cast<float>(i);
+  });
+
+  auto scale = [=] PARALLEL_RAJA_DEVICE(int i) {
+    v2[i] = v1[i] * 2.0f;
+  };
+
+  RAJA::forall<parallel_raja_policy>(RAJA::RangeSegment(0, 10), scale);
+
+  const size_t hits = rm->getNumCachedCaptures();
+
+  for (int launch = 0; launch < 3; ++launch) {
+    RAJA::forall<parallel_raja_policy>(RAJA::RangeSegment(0, 10), scale);
+  }
+
+  // Both arrays are left where the first launch put them
+  ASSERT_GE(rm->getNumCachedCaptures(), hits + 6);
+
+  RAJA::forall<RAJA::seq_exec>(RAJA::RangeSegment(0, 10), [=](int i) {
+    ASSERT_FLOAT_EQ(v2[i], i * 2.0f);
+  });
+
+  rm->disableCaptureCache();
+  v1.free();
+  v2.free();
+}
+
+CUDA_TEST(ChaiTest, ResourceLaunchRecordsEvent)
+{
+  chai::ArrayManager* rm = chai::ArrayManager::getInstance();
+
+  chai::ManagedArray<int> array(10);
+  chai::PointerRecord* record =
+      rm->getPointerRecord(array.data(chai::CPU, false));
+
+  RAJA::resources::Host host;
+  rm->setResource(camp::resources::Resource{host});
+
+  RAJA::forall<RAJA::seq_exec>(host, RAJA::RangeSegment(0, 10), [=](int i) {
+    array[i] = i;
+  });
+
+  rm->clearResource();
+
+  // The plugin attaches the event of the resource once the kernel is queued
+  ASSERT_EQ(record->m_event.getSpace(), chai::CPU);
+  ASSERT_NE(record->m_event.getResourceEvent(), nullptr);
+
+  RAJA::forall<RAJA::seq_exec>(RAJA::RangeSegment(0, 10), [=](int i) {
+    ASSERT_EQ(array[i], i);
+  });
+
+  // A kernel launched after clearResource waits for the event and records none
+  ASSERT_EQ(record->m_event.getResourceEvent(), nullptr);
+
+  array.free();
+}
+
+#if defined(RAJA_ENABLE_OPENMP)
+CUDA_TEST(ChaiTest, OpenMPCapturesOnce)
+{
+  chai::ManagedArray<int> array(1000);
+
+  int captures = 0;
+  array.setUserCallback([&] (const chai::PointerRecord*,
+                             chai::Action action,
+                             chai::ExecutionSpace space) {
+    if (action == chai::ACTION_CAPTURED) {
+      ASSERT_EQ(space, chai::CPU);
+      ++captures;
+    }
+  });
+
+  RAJA::forall<RAJA::omp_parallel_for_exec>(RAJA::RangeSegment(0, 1000), [=](int i) {
+    array[i] = i;
+  });
+
+  // The body is captured once by the launch, not once by every thread
+  ASSERT_EQ(captures, 1);
+
+  RAJA::forall<RAJA::seq_exec>(RAJA::RangeSegment(0, 1000), [=](int i) {
+    ASSERT_EQ(array[i], i);
+  });
+
+  array.free();
+}
+#endif
+
 CUDA_TEST(ChaiTest, Views)
 {
   chai::ManagedArray<float> v1_array(10);
@@ -138,3 +238,49 @@ CUDA_TEST(ChaiTest, MultiView)
     ;
   }
 }
+
+CUDA_TEST(ChaiTest, BatchMultiView)
+{
+  chai::ManagedArray<float> v1_array(10);
+  chai::ManagedArray<float> v2_array(10);
+
+  chai::ManagedArray<float> all_arrays[2];
+  all_arrays[0] = v1_array;
+  all_arrays[1] = v2_array;
+
+  using view = chai::ManagedArrayBatchMultiView<float, RAJA::Layout<1>>;
+  view mview(all_arrays, RAJA::Layout<1>(10));
+
+  using view1p = chai::ManagedArrayBatchMultiView<float, RAJA::Layout<1>, 1>;
+  view1p mview1p(all_arrays, RAJA::Layout<1>(10));
+
+  RAJA::forall<RAJA::seq_exec>(RAJA::RangeSegment(0, 10), [=](int i) {
+    mview(0,i) = static_cast<float>(i * 1.0f);
+  });
+
+  RAJA::forall<parallel_raja_policy>(RAJA::RangeSegment(0, 10), [=] PARALLEL_RAJA_DEVICE(int i) {
+    mview(1,i) = mview1p(i,0) * 2.0f;
+  });
+
+  {
+    // Copies share the table, and dropping them leaves it to mview
+    view copy(mview);
+    view assigned(mview);
+    assigned = copy;
+  }
+
+  RAJA::forall<parallel_raja_policy>(RAJA::RangeSegment(0, 10), [=] PARALLEL_RAJA_DEVICE(int i) {
+    mview(1,i) *= 2.0f;
+  });
+
+  // accessing pointer to v2_array
+  mview.move(chai::CPU);
+  float* raw_v2 = mview.data[1];
+  for (int i = 0; i < 10; i++) {
+    ASSERT_FLOAT_EQ(raw_v2[i], i * 1.0f * 2.0f * 2.0f);
+    ;
+  }
+
+  v1_array.free();
+  v2_array.free();
+}
@@ -0,0 +1,164 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#include "gtest/gtest.h"
+
+#include "chai/AllocationProfiler.hpp"
+#include "chai/ManagedArray.hpp"
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+chai::AllocationProfiler* startProfiling(size_t rate, size_t always_sampled_size)
+{
+  chai::AllocationProfiler* profiler = chai::AllocationProfiler::getInstance();
+  profiler->clear();
+  profiler->setSampling(rate, always_sampled_size);
+  profiler->setEnabled(true);
+  return profiler;
+}
+
+}  // end of anonymous namespace
+
+TEST(AllocationProfiler, LiveAndPeak)
+{
+  chai::AllocationProfiler* profiler = startProfiling(1, size_t(1) << 20);
+
+  chai::ManagedArray<int> first(100, chai::CPU);
+  chai::ManagedArray<int> second(50, chai::CPU);
+
+  ASSERT_EQ(profiler->getLiveBytes(chai::CPU), 150 * sizeof(int));
+  ASSERT_EQ(profiler->getPeakBytes(chai::CPU), 150 * sizeof(int));
+
+  first.free();
+
+  // The peak is kept after the memory is released
+  ASSERT_EQ(profiler->getLiveBytes(chai::CPU), 50 * sizeof(int));
+  ASSERT_EQ(profiler->getPeakBytes(chai::CPU), 150 * sizeof(int));
+
+  size_t live = 0;
+  size_t at_peak = 0;
+  size_t allocations = 0;
+  for (auto const& site : profiler->getSites(chai::CPU)) {
+    live += site.live_bytes[chai::CPU];
+    at_peak += site.bytes_at_peak[chai::CPU];
+    allocations += site.allocations;
+  }
+
+  ASSERT_EQ(live, 50 * sizeof(int));
+  ASSERT_EQ(at_peak, 150 * sizeof(int));
+  ASSERT_EQ(allocations, 2u);
+
+  second.free();
+  ASSERT_EQ(profiler->getLiveBytes(chai::CPU), 0u);
+
+  profiler->setEnabled(false);
+}
+
+TEST(AllocationProfiler, Regions)
+{
+  chai::AllocationProfiler* profiler = startProfiling(1, size_t(1) << 20);
+
+  // The same line allocates in two regions
+  const char* regions[] = {"mesh", "fields"};
+  std::vector<chai::ManagedArray<int>> arrays;
+  for (const char* name : regions) {
+    chai::ScopedRegion region(name);
+    arrays.push_back(chai::ManagedArray<int>(10, chai::CPU));
+  }
+
+  std::vector<std::string> paths;
+  for (auto const& site : profiler->getSites(chai::CPU)) {
+    ASSERT_NE(site.region, nullptr);
+    ASSERT_EQ(site.live_bytes[chai::CPU], 10 * sizeof(int));
+    paths.push_back(site.region->getPath());
+  }
+
+  ASSERT_EQ(paths.size(), 2u);
+  ASSERT_NE(std::find(paths.begin(), paths.end(), "mesh"), paths.end());
+  ASSERT_NE(std::find(paths.begin(), paths.end(), "fields"), paths.end());
+
+  std::ostringstream report;
+  profiler->report(report);
+  ASSERT_NE(report.str().find("in region fields"), std::string::npos);
+
+  for (auto& array : arrays) {
+    array.free();
+  }
+
+  profiler->setEnabled(false);
+}
+
+TEST(AllocationProfiler, Reallocate)
+{
+  chai::AllocationProfiler* profiler = startProfiling(1, size_t(1) << 20);
+
+  chai::ManagedArray<int> array(10, chai::CPU);
+  array.reallocate(40);
+
+  ASSERT_EQ(profiler->getLiveBytes(chai::CPU), 40 * sizeof(int));
+
+  array.free();
+  ASSERT_EQ(profiler->getLiveBytes(chai::CPU), 0u);
+
+  profiler->setEnabled(false);
+}
+
+TEST(AllocationProfiler, Sampled)
+{
+  chai::AllocationProfiler* profiler = startProfiling(4, size_t(1) << 20);
+
+  std::vector<chai::ManagedArray<double>> arrays;
+  for (int i = 0; i < 8; ++i) {
+    arrays.push_back(chai::ManagedArray<double>(16, chai::CPU));
+  }
+
+  // Two of the eight allocations are sampled, each standing for four
+  ASSERT_EQ(profiler->getLiveBytes(chai::CPU), 8 * 16 * sizeof(double));
+
+  size_t allocations = 0;
+  for (auto const& site : profiler->getSites(chai::CPU)) {
+    allocations += site.allocations;
+  }
+  ASSERT_EQ(allocations, 2u);
+
+  for (auto& array : arrays) {
+    array.free();
+  }
+
+  ASSERT_EQ(profiler->getLiveBytes(chai::CPU), 0u);
+
+  profiler->setEnabled(false);
+}
+
+TEST(AllocationProfiler, AlwaysSampled)
+{
+  chai::AllocationProfiler* profiler = startProfiling(1000, 1024);
+
+  chai::ManagedArray<char> small(16, chai::CPU);
+  chai::ManagedArray<char> skipped(16, chai::CPU);
+  chai::ManagedArray<char> large(4096, chai::CPU);
+
+  // The first small allocation stands for a thousand, the large one for
+  // itself
+  ASSERT_EQ(profiler->getLiveBytes(chai::CPU), 16 * 1000 + 4096u);
+
+  std::ostringstream report;
+  profiler->report(report);
+  ASSERT_NE(report.str().find("CPU: "), std::string::npos);
+
+  small.free();
+  skipped.free();
+  large.free();
+
+  ASSERT_EQ(profiler->getLiveBytes(chai::CPU), 0u);
+
+  profiler->setEnabled(false);
+}
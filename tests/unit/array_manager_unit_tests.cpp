@@ -180,4 +180,304 @@ TEST(ArrayManager, controlGlobalCallback)
   ASSERT_TRUE(callbacksAreOn);
 }
 
+/*!
+ * \brief Tests that captures are not cached until the cache is turned on
+ */
+TEST(ArrayManager, captureCacheOffByDefault)
+{
+  chai::ArrayManager* arrayManager = chai::ArrayManager::getInstance();
+  static const char site = 0;
+
+  chai::ManagedArray<int> array(10, chai::CPU);
+
+  const size_t hits = arrayManager->getNumCachedCaptures();
+
+  for (int launch = 0; launch < 3; ++launch) {
+    arrayManager->setCaptureSite(&site);
+    arrayManager->setExecutionSpace(chai::CPU);
+    chai::ManagedArray<int> captured = array;
+    (void) captured;
+    arrayManager->setExecutionSpace(chai::NONE);
+  }
+
+  ASSERT_EQ(arrayManager->getNumCachedCaptures(), hits);
+
+  array.free();
+}
+
+/*!
+ * \brief Tests that relaunching a kernel on unchanged arrays hits the cache
+ */
+TEST(ArrayManager, captureCache)
+{
+  chai::ArrayManager* arrayManager = chai::ArrayManager::getInstance();
+  static const char site = 0;
+
+  arrayManager->enableCaptureCache();
+
+  chai::ManagedArray<int> array(10, chai::CPU);
+  chai::ManagedArray<int> other(10, chai::CPU);
+  chai::ManagedArray<const int> constArray(other);
+
+  const size_t hits = arrayManager->getNumCachedCaptures();
+
+  for (int launch = 0; launch < 3; ++launch) {
+    arrayManager->setCaptureSite(&site);
+    arrayManager->setExecutionSpace(chai::CPU);
+    chai::ManagedArray<int> captured = array;
+    chai::ManagedArray<const int> constCaptured = constArray;
+    (void) constCaptured;
+    ASSERT_EQ(captured.data(chai::CPU, false), array.data(chai::CPU, false));
+    arrayManager->setExecutionSpace(chai::NONE);
+  }
+
+  ASSERT_EQ(arrayManager->getNumCachedCaptures(), hits + 4);
+
+  // Captures in a different order are not the same kernel
+  arrayManager->setCaptureSite(&site);
+  arrayManager->setExecutionSpace(chai::CPU);
+  {
+    chai::ManagedArray<const int> constCaptured = constArray;
+    chai::ManagedArray<int> captured = array;
+    (void) constCaptured;
+    (void) captured;
+  }
+  arrayManager->setExecutionSpace(chai::NONE);
+
+  ASSERT_EQ(arrayManager->getNumCachedCaptures(), hits + 4);
+
+  arrayManager->disableCaptureCache();
+
+  for (int launch = 0; launch < 2; ++launch) {
+    arrayManager->setCaptureSite(&site);
+    arrayManager->setExecutionSpace(chai::CPU);
+    chai::ManagedArray<int> captured = array;
+    (void) captured;
+    arrayManager->setExecutionSpace(chai::NONE);
+  }
+
+  ASSERT_EQ(arrayManager->getNumCachedCaptures(), hits + 4);
+
+  array.free();
+  other.free();
+}
+
+#if defined(CHAI_ENABLE_CUDA) || defined(CHAI_ENABLE_HIP) || defined(CHAI_ENABLE_GPU_SIMULATION_MODE)
+/*!
+ * \brief Tests that changes to an array between launches miss the cache
+ */
+TEST(ArrayManager, captureCacheInvalidation)
+{
+  chai::ArrayManager* arrayManager = chai::ArrayManager::getInstance();
+  static const char site = 0;
+
+  arrayManager->enableCaptureCache();
+
+  int moves = 0;
+  chai::ManagedArray<int> array(10, chai::CPU);
+  array.setUserCallback([&] (const chai::PointerRecord*, chai::Action action,
+                             chai::ExecutionSpace) {
+    if (action == chai::ACTION_MOVE) {
+      ++moves;
+    }
+  });
+
+  auto launch = [&] (chai::ExecutionSpace space) {
+    arrayManager->setCaptureSite(&site);
+    arrayManager->setExecutionSpace(space);
+    chai::ManagedArray<const int> captured = array;
+    arrayManager->setExecutionSpace(chai::NONE);
+    return captured.data(space, false);
+  };
+
+  array.data()[3] = 1;
+
+  const size_t hits = arrayManager->getNumCachedCaptures();
+
+  const int* device = launch(chai::GPU);
+  ASSERT_EQ(launch(chai::GPU), device);
+  ASSERT_EQ(moves, 1);
+  ASSERT_EQ(arrayManager->getNumCachedCaptures(), hits + 1);
+
+  // Writing on the host must be moved to the device again
+  array.data()[3] = 2;
+  launch(chai::GPU);
+  ASSERT_EQ(moves, 2);
+  ASSERT_EQ(arrayManager->getNumCachedCaptures(), hits + 1);
+
+#if defined(CHAI_ENABLE_PICK)
+  array.set(3, 3);
+  launch(chai::GPU);
+  ASSERT_EQ(moves, 3);
+  ASSERT_EQ(arrayManager->getNumCachedCaptures(), hits + 1);
+#endif
+
+  array.reallocate(20);
+  launch(chai::GPU);
+  ASSERT_EQ(arrayManager->getNumCachedCaptures(), hits + 1);
+  ASSERT_EQ(launch(chai::GPU), array.data(chai::GPU, false));
+  ASSERT_EQ(arrayManager->getNumCachedCaptures(), hits + 2);
+
+  arrayManager->disableCaptureCache();
+  array.free();
+}
+
+#if defined(CHAI_ENABLE_GPU_SIMULATION_MODE)
+/*!
+ * \brief Tests that kernels launched on a resource move their arrays on it
+ *        and wait for its events
+ *
+ * The GPU space of the simulation is host memory, so a host resource can run
+ * GPU kernels.
+ */
+TEST(ArrayManager, resourceLaunch)
+{
+  chai::ArrayManager* arrayManager = chai::ArrayManager::getInstance();
+  arrayManager->syncIfNeeded();
+
+  chai::ManagedArray<int> array(10, chai::CPU);
+  for (int i = 0; i < 10; ++i) {
+    array.data()[i] = i;
+  }
+
+  chai::PointerRecord* record =
+      arrayManager->getPointerRecord(array.data(chai::CPU, false));
+
+  camp::resources::Resource resource{camp::resources::Host{}};
+  arrayManager->setResource(resource);
+
+  arrayManager->setExecutionSpace(chai::GPU);
+  chai::ManagedArray<int> captured = array;
+  arrayManager->setExecutionSpace(chai::NONE);
+
+  // The event follows the kernel, which is launched after the capture
+  ASSERT_EQ(record->m_event.getSpace(), chai::NONE);
+
+  arrayManager->recordLaunchEvent();
+  arrayManager->clearResource();
+
+  ASSERT_EQ(record->m_event.getSpace(), chai::GPU);
+  ASSERT_NE(record->m_event.getResourceEvent(), nullptr);
+  ASSERT_TRUE(record->m_event.isComplete());
+
+  // Nothing waits for the whole device
+  ASSERT_FALSE(arrayManager->syncIfNeeded());
+
+  int* device = captured.data(chai::GPU, false);
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_EQ(device[i], i);
+    device[i] = 2 * i;
+  }
+
+  // Using the array on the host waits for the event
+  int* host = array.data();
+  ASSERT_EQ(record->m_event.getSpace(), chai::NONE);
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_EQ(host[i], 2 * i);
+  }
+
+  array.free();
+}
+
+/*!
+ * \brief Tests that the moves of kernels on a host resource go through the
+ *        copy model, and that kernels on the default stream wait for kernels
+ *        on the resource
+ */
+TEST(ArrayManager, resourceLaunchOrdering)
+{
+  chai::ArrayManager* arrayManager = chai::ArrayManager::getInstance();
+  chai::SimulatedDevice* device = chai::SimulatedDevice::getInstance();
+
+  chai::CopyModel model;
+  model.bandwidth = 1.0e9;
+  device->setCopyModel(model);
+  device->clearCopyTotals();
+
+  chai::ManagedArray<int> array(10, chai::CPU);
+  array.data()[0] = 1;
+
+  chai::PointerRecord* record =
+      arrayManager->getPointerRecord(array.data(chai::CPU, false));
+
+  arrayManager->setResource(camp::resources::Resource{camp::resources::Host{}});
+  arrayManager->setExecutionSpace(chai::GPU);
+  chai::ManagedArray<int> captured = array;
+  arrayManager->setExecutionSpace(chai::NONE);
+  arrayManager->recordLaunchEvent();
+  arrayManager->clearResource();
+
+  ASSERT_EQ(device->getCopyTotals().copies, 1u);
+  ASSERT_NE(record->m_event.getResourceEvent(), nullptr);
+
+  // A kernel on the default stream is not in order with the resource
+  arrayManager->setExecutionSpace(chai::GPU);
+  chai::ManagedArray<int> recaptured = array;
+  arrayManager->setExecutionSpace(chai::NONE);
+
+  ASSERT_EQ(record->m_event.getSpace(), chai::NONE);
+
+  device->setCopyModel(chai::CopyModel());
+  (void) captured;
+  (void) recaptured;
+  array.free();
+}
+#endif
+
+/*!
+ * \brief Tests that evict moves every array out of the evicted space
+ */
+TEST(ArrayManager, evict)
+{
+  chai::ArrayManager* arrayManager = chai::ArrayManager::getInstance();
+  arrayManager->setGlobalUserCallback(chai::UserCallback());
+  arrayManager->enableParallelCopies();
+  const size_t numArrays = arrayManager->getTotalNumArrays();
+
+  // Large enough to be copied in parallel blocks between host spaces
+  const size_t sizeOfLarge = (1 << 23) / sizeof(int);
+  const size_t sizeOfSmall = 10;
+
+  chai::ManagedArray<int> large(sizeOfLarge, chai::CPU);
+  chai::ManagedArray<int> small(sizeOfSmall, chai::CPU);
+
+  int* largeData = large.data();
+  for (size_t i = 0; i < sizeOfLarge; ++i) {
+    largeData[i] = static_cast<int>(i);
+  }
+
+  int* smallData = small.data();
+  for (size_t i = 0; i < sizeOfSmall; ++i) {
+    smallData[i] = static_cast<int>(2 * i);
+  }
+
+  large.move(chai::GPU);
+  small.move(chai::GPU);
+
+  arrayManager->evict(chai::CPU, chai::GPU);
+  ASSERT_EQ(large.data(chai::CPU, false), nullptr);
+  ASSERT_EQ(small.data(chai::CPU, false), nullptr);
+
+  arrayManager->evict(chai::GPU, chai::CPU);
+  ASSERT_EQ(large.data(chai::GPU, false), nullptr);
+  ASSERT_EQ(small.data(chai::GPU, false), nullptr);
+
+  largeData = large.data();
+  for (size_t i = 0; i < sizeOfLarge; ++i) {
+    ASSERT_EQ(largeData[i], static_cast<int>(i));
+  }
+
+  smallData = small.data();
+  for (size_t i = 0; i < sizeOfSmall; ++i) {
+    ASSERT_EQ(smallData[i], static_cast<int>(2 * i));
+  }
+
+  large.free();
+  small.free();
+  ASSERT_EQ(arrayManager->getTotalNumArrays(), numArrays);
+
+  arrayManager->disableParallelCopies();
+}
+#endif
+
 #endif // !CHAI_DISABLE_RM
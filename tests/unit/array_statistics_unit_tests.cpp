@@ -0,0 +1,225 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#include "gtest/gtest.h"
+
+#include "chai/ArrayManager.hpp"
+#include "chai/ArrayStatistics.hpp"
+#include "chai/ManagedArray.hpp"
+
+#include <sstream>
+
+TEST(ArrayStatistics, Disabled)
+{
+  chai::ArrayStatistics* statistics = chai::ArrayStatistics::getInstance();
+  statistics->setEnabled(false);
+  statistics->clear();
+
+  chai::ArrayManager* rm = chai::ArrayManager::getInstance();
+  chai::ManagedArray<int> array(10, chai::CPU);
+
+  rm->setExecutionSpace(chai::CPU);
+  chai::ManagedArray<int> captured = array;
+  (void) captured;
+  rm->setExecutionSpace(chai::NONE);
+
+  array.free();
+
+  ASSERT_TRUE(statistics->getEntries().empty());
+}
+
+TEST(ArrayStatistics, FreedWhileDisabled)
+{
+  chai::ArrayStatistics* statistics = chai::ArrayStatistics::getInstance();
+  statistics->setEnabled(true);
+  statistics->clear();
+
+  chai::ArrayManager* rm = chai::ArrayManager::getInstance();
+  chai::ManagedArray<int> array(10, chai::CPU);
+
+  rm->setExecutionSpace(chai::CPU);
+  chai::ManagedArray<int> captured = array;
+  (void) captured;
+  rm->setExecutionSpace(chai::NONE);
+
+  statistics->setEnabled(false);
+  array.free();
+  statistics->setEnabled(true);
+
+  // The record of a new array may reuse the address of the old one
+  chai::ManagedArray<int> other(20, chai::CPU);
+
+  rm->setExecutionSpace(chai::CPU);
+  chai::ManagedArray<int> captured_other = other;
+  (void) captured_other;
+  rm->setExecutionSpace(chai::NONE);
+
+  std::vector<chai::ArrayStatistics::Entry> entries = statistics->getEntries();
+  ASSERT_EQ(entries.size(), 2u);
+
+  for (auto const& entry : entries) {
+    ASSERT_EQ(entry.captures[chai::CPU], 1u);
+  }
+
+  other.free();
+  statistics->setEnabled(false);
+  statistics->clear();
+}
+
+TEST(ArrayStatistics, FreedTotals)
+{
+  chai::ArrayStatistics* statistics = chai::ArrayStatistics::getInstance();
+  statistics->setEnabled(true);
+  statistics->clear();
+
+  chai::ArrayManager* rm = chai::ArrayManager::getInstance();
+
+  for (int i = 0; i < 100; ++i) {
+    chai::ManagedArray<int> array(10 + i, chai::CPU);
+    chai::ManagedArray<int> named(10, chai::CPU);
+    named.setName("named");
+
+    rm->setExecutionSpace(chai::CPU);
+    chai::ManagedArray<int> captured = array;
+    chai::ManagedArray<int> captured_named = named;
+    (void) captured;
+    (void) captured_named;
+    rm->setExecutionSpace(chai::NONE);
+
+    array.free();
+    named.free();
+  }
+
+  // Freed arrays are added to the total of their name
+  std::vector<chai::ArrayStatistics::Entry> entries = statistics->getEntries();
+  ASSERT_EQ(entries.size(), 2u);
+
+  for (auto const& entry : entries) {
+    ASSERT_TRUE(entry.freed);
+    ASSERT_EQ(entry.arrays, 100u);
+    ASSERT_EQ(entry.captures[chai::CPU], 100u);
+
+    if (entry.name) {
+      ASSERT_STREQ(entry.name, "named");
+      ASSERT_EQ(entry.size, 10 * sizeof(int));
+    } else {
+      ASSERT_EQ(entry.size, 109 * sizeof(int));
+    }
+  }
+
+  std::ostringstream report;
+  statistics->report(report);
+  ASSERT_NE(report.str().find("named (100 freed)"), std::string::npos);
+  ASSERT_NE(report.str().find("unnamed (100 freed)"), std::string::npos);
+
+  statistics->setEnabled(false);
+  statistics->clear();
+}
+
+TEST(ArrayStatistics, Captures)
+{
+  chai::ArrayStatistics* statistics = chai::ArrayStatistics::getInstance();
+  statistics->setEnabled(true);
+  statistics->clear();
+
+  chai::ArrayManager* rm = chai::ArrayManager::getInstance();
+  chai::ManagedArray<int> array(10, chai::CPU);
+  chai::ManagedArray<int> other(20, chai::CPU);
+
+  for (int launch = 0; launch < 3; ++launch) {
+    rm->setExecutionSpace(chai::CPU);
+    chai::ManagedArray<int> captured = array;
+    (void) captured;
+    rm->setExecutionSpace(chai::NONE);
+  }
+
+  rm->setExecutionSpace(chai::CPU);
+  chai::ManagedArray<int> captured = other;
+  (void) captured;
+  rm->setExecutionSpace(chai::NONE);
+
+  array.free();
+
+  std::vector<chai::ArrayStatistics::Entry> entries = statistics->getEntries();
+  ASSERT_EQ(entries.size(), 2u);
+
+  for (auto const& entry : entries) {
+    if (entry.size == 10 * sizeof(int)) {
+      ASSERT_EQ(entry.captures[chai::CPU], 3u);
+      ASSERT_TRUE(entry.freed);
+    } else {
+      ASSERT_EQ(entry.captures[chai::CPU], 1u);
+      ASSERT_FALSE(entry.freed);
+    }
+
+    ASSERT_EQ(entry.moves, 0u);
+    ASSERT_FALSE(entry.ping_pong);
+  }
+
+  std::ostringstream report;
+  statistics->report(report, 1);
+  ASSERT_NE(report.str().find("CPU caps"), std::string::npos);
+
+  other.free();
+  statistics->setEnabled(false);
+  statistics->clear();
+}
+
+#if defined(CHAI_ENABLE_CUDA) || defined(CHAI_ENABLE_HIP) || defined(CHAI_ENABLE_GPU_SIMULATION_MODE)
+TEST(ArrayStatistics, PingPong)
+{
+  chai::ArrayStatistics* statistics = chai::ArrayStatistics::getInstance();
+  statistics->setEnabled(true);
+  statistics->setPingPongThreshold(2, 10);
+  statistics->clear();
+
+  chai::ArrayManager* rm = chai::ArrayManager::getInstance();
+  chai::ManagedArray<double> bouncing(100, chai::CPU);
+  chai::ManagedArray<double> resident(10, chai::CPU);
+  bouncing.data()[0] = 0.0;
+  resident.data()[0] = 0.0;
+
+  for (int cycle = 0; cycle < 3; ++cycle) {
+    rm->setExecutionSpace(chai::GPU);
+    chai::ManagedArray<double> device = bouncing;
+    chai::ManagedArray<double> stays = resident;
+    (void) device;
+    (void) stays;
+    rm->setExecutionSpace(chai::NONE);
+
+    bouncing.data()[0] += 1.0;
+  }
+
+  std::vector<chai::ArrayStatistics::Entry> entries = statistics->getEntries();
+  ASSERT_EQ(entries.size(), 2u);
+
+  // Ranked by traffic
+  ASSERT_EQ(entries[0].size, 100 * sizeof(double));
+  ASSERT_EQ(entries[0].moves, 6u);
+  ASSERT_EQ(entries[0].bytes_moved, 6 * 100 * sizeof(double));
+  ASSERT_EQ(entries[0].captures[chai::GPU], 3u);
+  ASSERT_EQ(entries[0].round_trips, 5u);
+  ASSERT_TRUE(entries[0].ping_pong);
+  ASSERT_EQ(entries[0].history.front().source, chai::CPU);
+  ASSERT_EQ(entries[0].history.front().destination, chai::GPU);
+
+  ASSERT_EQ(entries[1].moves, 1u);
+  ASSERT_FALSE(entries[1].ping_pong);
+
+  std::ostringstream report;
+  statistics->report(report);
+  ASSERT_NE(report.str().find("PING-PONG"), std::string::npos);
+
+  // Round trips spread over more kernels than the threshold are not flagged
+  statistics->setPingPongThreshold(2, 1);
+  ASSERT_FALSE(statistics->getEntries()[0].ping_pong);
+
+  bouncing.free();
+  resident.free();
+  statistics->setEnabled(false);
+  statistics->clear();
+}
+#endif
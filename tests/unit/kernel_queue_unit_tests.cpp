@@ -0,0 +1,67 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#include "gtest/gtest.h"
+
+#include "chai/Event.hpp"
+#include "chai/KernelQueue.hpp"
+
+#include <atomic>
+#include <thread>
+
+TEST(KernelQueue, Tickets)
+{
+  chai::KernelQueue queue;
+
+  std::atomic<bool> released{false};
+  std::atomic<int> completed{0};
+
+  const std::uint64_t first = queue.launch([&] {
+    while (!released.load()) {
+      std::this_thread::yield();
+    }
+    ++completed;
+  });
+  const std::uint64_t second = queue.launch([&] { ++completed; });
+
+  ASSERT_LT(first, second);
+  ASSERT_FALSE(queue.isComplete(first));
+  ASSERT_TRUE(queue.busy());
+
+  released = true;
+
+  // Kernels complete in launch order
+  queue.wait(first);
+  ASSERT_TRUE(queue.isComplete(first));
+
+  queue.wait(second);
+  ASSERT_EQ(completed.load(), 2);
+  ASSERT_FALSE(queue.busy());
+}
+
+TEST(KernelQueue, Events)
+{
+  chai::Event complete;
+  ASSERT_TRUE(complete.isComplete());
+  complete.wait();
+
+  chai::KernelQueue* queue = chai::KernelQueue::getHostInstance();
+
+  std::atomic<bool> released{false};
+  chai::Event event(queue, queue->launch([&] {
+    while (!released.load()) {
+      std::this_thread::yield();
+    }
+  }), chai::CPU);
+
+  ASSERT_FALSE(event.isComplete());
+  ASSERT_EQ(event.getSpace(), chai::CPU);
+
+  released = true;
+  event.wait();
+
+  ASSERT_TRUE(event.isComplete());
+}
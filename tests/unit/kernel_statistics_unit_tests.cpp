@@ -0,0 +1,155 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#include "gtest/gtest.h"
+
+#include "chai/ArrayManager.hpp"
+#include "chai/KernelStatistics.hpp"
+#include "chai/ManagedArray.hpp"
+#include "../src/util/forall.hpp"
+
+#include <chrono>
+#include <sstream>
+#include <thread>
+
+TEST(KernelStatistics, Disabled)
+{
+  chai::KernelStatistics* statistics = chai::KernelStatistics::getInstance();
+  statistics->setEnabled(false);
+  statistics->clear();
+
+  chai::ManagedArray<int> array(10);
+  array.free();
+
+  ASSERT_TRUE(statistics->getEntries().empty());
+}
+
+TEST(KernelStatistics, NamedKernels)
+{
+  chai::ArrayManager* rm = chai::ArrayManager::getInstance();
+  chai::KernelStatistics* statistics = chai::KernelStatistics::getInstance();
+  statistics->setEnabled(true);
+  statistics->clear();
+
+  chai::ManagedArray<int> array(10, chai::CPU);
+
+  for (int launch = 0; launch < 3; ++launch) {
+    statistics->setKernelName("fill");
+    rm->setExecutionSpace(chai::CPU);
+    chai::ManagedArray<int> captured = array;
+    rm->setExecutionSpace(chai::NONE);
+  }
+
+  // The name only applies to the kernel launched after it is set
+  rm->setExecutionSpace(chai::CPU);
+  rm->setExecutionSpace(chai::NONE);
+
+  std::vector<chai::KernelStatistics::Entry> entries = statistics->getEntries();
+  ASSERT_EQ(entries.size(), 3u);
+
+  for (auto const& entry : entries) {
+    if (entry.name == "fill") {
+      ASSERT_EQ(entry.launches, 3u);
+      ASSERT_EQ(entry.moves, 0u);
+    } else if (entry.name == "CPU kernel") {
+      ASSERT_EQ(entry.launches, 1u);
+    } else {
+      ASSERT_EQ(entry.name, "(outside kernels)");
+      ASSERT_EQ(entry.allocations, 1u);
+      ASSERT_EQ(entry.bytes_allocated, 10 * sizeof(int));
+    }
+  }
+
+  std::ostringstream table;
+  statistics->report(table);
+  ASSERT_NE(table.str().find("fill"), std::string::npos);
+
+  array.free();
+  statistics->setEnabled(false);
+  statistics->clear();
+}
+
+TEST(KernelStatistics, NameForgottenAfterLaunch)
+{
+  chai::ArrayManager* rm = chai::ArrayManager::getInstance();
+  chai::KernelStatistics* statistics = chai::KernelStatistics::getInstance();
+  statistics->setEnabled(false);
+
+  // Names are forgotten even while collection is off
+  statistics->setKernelName("named");
+  ASSERT_EQ(statistics->getNextKernelName(), "named");
+
+  // Leaving a space that was never entered does not end a kernel
+  rm->setExecutionSpace(chai::NONE);
+  ASSERT_EQ(statistics->getNextKernelName(), "named");
+
+  rm->setExecutionSpace(chai::CPU);
+  ASSERT_EQ(statistics->getKernelName(chai::CPU), "named");
+  rm->setExecutionSpace(chai::NONE);
+
+  ASSERT_EQ(statistics->getNextKernelName(), "");
+  ASSERT_EQ(statistics->getKernelName(chai::CPU), "CPU kernel");
+}
+
+TEST(KernelStatistics, CaptureExcludesBody)
+{
+  chai::KernelStatistics* statistics = chai::KernelStatistics::getInstance();
+  statistics->setEnabled(true);
+  statistics->clear();
+
+  chai::ManagedArray<int> array(1, chai::CPU);
+
+  statistics->setKernelName("slow");
+  forall(sequential(), 0, 1, [=] (int i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    array[i] = i;
+  });
+
+  std::vector<chai::KernelStatistics::Entry> entries = statistics->getEntries();
+  bool found = false;
+  for (auto const& entry : entries) {
+    if (entry.name == "slow") {
+      found = true;
+      ASSERT_EQ(entry.launches, 1u);
+      ASSERT_LT(entry.capture_seconds, 0.05);
+    }
+  }
+  ASSERT_TRUE(found);
+
+  array.free();
+  statistics->setEnabled(false);
+  statistics->clear();
+}
+
+#if defined(CHAI_ENABLE_CUDA) || defined(CHAI_ENABLE_HIP) || defined(CHAI_ENABLE_GPU_SIMULATION_MODE)
+TEST(KernelStatistics, MovesAttributedToKernel)
+{
+  chai::ArrayManager* rm = chai::ArrayManager::getInstance();
+  chai::KernelStatistics* statistics = chai::KernelStatistics::getInstance();
+
+  chai::ManagedArray<double> array(100, chai::CPU);
+  array.registerTouch(chai::CPU);
+
+  statistics->setEnabled(true);
+  statistics->clear();
+  statistics->setKernelName("upload");
+
+  rm->setExecutionSpace(chai::GPU);
+  chai::ManagedArray<double> captured = array;
+  rm->setExecutionSpace(chai::NONE);
+
+  std::vector<chai::KernelStatistics::Entry> entries = statistics->getEntries();
+  ASSERT_EQ(entries.size(), 1u);
+  ASSERT_EQ(entries[0].name, "upload");
+  ASSERT_EQ(entries[0].moves, 1u);
+  ASSERT_EQ(entries[0].bytes_moved, 100 * sizeof(double));
+  ASSERT_EQ(entries[0].allocations, 1u);
+
+  statistics->setEnabled(false);
+  statistics->clear();
+  array.free();
+}
+#endif
@@ -0,0 +1,77 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#include "gtest/gtest.h"
+
+#include "chai/ChaiMacros.hpp"
+
+namespace {
+
+int s_evaluated = 0;
+
+int evaluate()
+{
+  return ++s_evaluated;
+}
+
+}  // end of anonymous namespace
+
+/*!
+ * \brief Tests that the sites below CHAI_LOG_LEVEL never evaluate their
+ *        messages
+ */
+TEST(ChaiLog, RemovedSites)
+{
+  s_evaluated = 0;
+
+#if CHAI_LOG_LEVEL > CHAI_LOG_LEVEL_DEBUG
+  CHAI_LOG(Debug, "debug " << evaluate());
+#endif
+#if CHAI_LOG_LEVEL > CHAI_LOG_LEVEL_INFO
+  CHAI_LOG(Info, "info " << evaluate());
+#endif
+#if CHAI_LOG_LEVEL > CHAI_LOG_LEVEL_WARNING
+  CHAI_LOG(Warning, "warning " << evaluate());
+#endif
+#if CHAI_LOG_LEVEL > CHAI_LOG_LEVEL_ERROR
+  CHAI_LOG(Error, "error " << evaluate());
+#endif
+
+  ASSERT_EQ(s_evaluated, 0);
+  ASSERT_EQ(evaluate(), 1);
+}
+
+/*!
+ * \brief Tests that every site is a single statement
+ */
+TEST(ChaiLog, Statement)
+{
+  const bool branch = s_evaluated == 0;
+
+  if (branch)
+    CHAI_LOG(Debug, "taken");
+  else
+    CHAI_LOG(Error, "not taken");
+
+  SUCCEED();
+}
+
+#if CHAI_LOG_LEVEL == CHAI_LOG_LEVEL_OFF
+/*!
+ * \brief Tests that no site is left when logging is off
+ */
+TEST(ChaiLog, Off)
+{
+  s_evaluated = 0;
+
+  CHAI_LOG(Debug, evaluate());
+  CHAI_LOG(Info, evaluate());
+  CHAI_LOG(Warning, evaluate());
+  CHAI_LOG(Error, evaluate());
+
+  ASSERT_EQ(s_evaluated, 0);
+}
+#endif
@@ -0,0 +1,80 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#include "gtest/gtest.h"
+
+#include "chai/ManagedReduceArray.hpp"
+#include "chai/ThreadPool.hpp"
+
+TEST(ManagedReduceArray, ChooseStrategy)
+{
+  using reduce_array = chai::ManagedReduceArray<double>;
+
+  ASSERT_EQ(reduce_array::chooseStrategy(1000, 8), chai::REDUCE_PRIVATIZE);
+#if defined(CHAI_HAS_HOST_ATOMICS)
+  ASSERT_EQ(reduce_array::chooseStrategy(1000, 1), chai::REDUCE_ATOMIC);
+  ASSERT_EQ(reduce_array::chooseStrategy(1 << 24, 8), chai::REDUCE_ATOMIC);
+#endif
+}
+
+void scatterAdd(chai::ReduceStrategy strategy)
+{
+  chai::ThreadPool* pool = chai::ThreadPool::getInstance();
+  pool->setNumThreads(4);
+
+  chai::ManagedArray<int> bins(10);
+  for (int i = 0; i < 10; ++i) {
+    bins[i] = 1;
+  }
+
+  chai::ManagedReduceArray<int> reduce(bins, strategy);
+  ASSERT_EQ(reduce.getStrategy(), strategy);
+
+  for (int repeat = 0; repeat < 2; ++repeat) {
+    reduce.resetSlots();
+
+    pool->parallelFor(0, 10000, chai::SCHEDULE_GUIDED, [&] (int begin, int end) {
+      for (int i = begin; i < end; ++i) {
+        reduce.add(i % 10, 1);
+      }
+    });
+
+    reduce.combineSlots();
+  }
+
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_EQ(bins[i], 2001);
+  }
+
+  reduce.free();
+  bins.free();
+}
+
+TEST(ManagedReduceArray, Privatize)
+{
+  scatterAdd(chai::REDUCE_PRIVATIZE);
+}
+
+TEST(ManagedReduceArray, Empty)
+{
+  chai::ThreadPool::getInstance()->setNumThreads(4);
+
+  chai::ManagedArray<int> bins;
+  chai::ManagedReduceArray<int> reduce(bins, chai::REDUCE_PRIVATIZE);
+
+  // Nothing to reset or combine
+  reduce.resetSlots();
+  reduce.combineSlots();
+
+  reduce.free();
+}
+
+#if defined(CHAI_HAS_HOST_ATOMICS)
+TEST(ManagedReduceArray, Atomic)
+{
+  scatterAdd(chai::REDUCE_ATOMIC);
+}
+#endif
@@ -0,0 +1,231 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#include "gtest/gtest.h"
+
+#include "chai/ArrayManager.hpp"
+#include "chai/Instrumentation.hpp"
+#include "chai/ManagedArray.hpp"
+#include "chai/Metrics.hpp"
+#include "chai/RegionStatistics.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+TEST(Metrics, Buckets)
+{
+  ASSERT_EQ(chai::Metrics::Histogram::upperBound(0), 0u);
+  ASSERT_EQ(chai::Metrics::Histogram::upperBound(1), 1u);
+  ASSERT_EQ(chai::Metrics::Histogram::upperBound(2), 3u);
+  ASSERT_EQ(chai::Metrics::Histogram::upperBound(10), 1023u);
+  ASSERT_EQ(chai::Metrics::Histogram::upperBound(64),
+            std::numeric_limits<std::uint64_t>::max());
+}
+
+TEST(Metrics, Allocations)
+{
+  chai::Metrics* metrics = chai::ArrayManager::getInstance()->getMetrics();
+  metrics->setEnabled(true);
+  const chai::Metrics::Snapshot before = metrics->snapshot();
+
+  chai::ManagedArray<double> array(100, chai::CPU);
+
+  chai::Metrics::Snapshot after = metrics->snapshot();
+  ASSERT_EQ(after.allocations[chai::CPU], before.allocations[chai::CPU] + 1);
+  ASSERT_EQ(after.bytes_allocated[chai::CPU],
+            before.bytes_allocated[chai::CPU] + 100 * sizeof(double));
+  ASSERT_EQ(after.bytesInUse(chai::CPU),
+            before.bytesInUse(chai::CPU) + 100 * sizeof(double));
+  ASSERT_EQ(after.allocation_latency[chai::CPU].count,
+            before.allocation_latency[chai::CPU].count + 1);
+
+  array.free();
+
+  after = metrics->snapshot();
+  ASSERT_EQ(after.frees[chai::CPU], before.frees[chai::CPU] + 1);
+  ASSERT_EQ(after.bytesInUse(chai::CPU), before.bytesInUse(chai::CPU));
+}
+
+TEST(Metrics, Kernels)
+{
+  chai::ArrayManager* rm = chai::ArrayManager::getInstance();
+  chai::Metrics* metrics = rm->getMetrics();
+  metrics->setEnabled(true);
+
+  chai::ManagedArray<int> a(10, chai::CPU);
+  chai::ManagedArray<int> b(10, chai::CPU);
+
+  const chai::Metrics::Snapshot before = metrics->snapshot();
+
+  rm->setExecutionSpace(chai::CPU);
+  chai::ManagedArray<int> captured_a = a;
+  chai::ManagedArray<int> captured_b = b;
+  (void) captured_a;
+  (void) captured_b;
+  rm->setExecutionSpace(chai::NONE);
+
+  const chai::Metrics::Snapshot after = metrics->snapshot();
+  ASSERT_EQ(after.kernels[chai::CPU], before.kernels[chai::CPU] + 1);
+  ASSERT_EQ(after.captures, before.captures + 2);
+  ASSERT_EQ(after.kernel_captures.count, before.kernel_captures.count + 1);
+  ASSERT_EQ(after.kernel_captures.buckets[2],
+            before.kernel_captures.buckets[2] + 1);
+
+  a.free();
+  b.free();
+}
+
+TEST(Metrics, Disabled)
+{
+  chai::ArrayManager* rm = chai::ArrayManager::getInstance();
+  chai::Metrics* metrics = rm->getMetrics();
+  metrics->setEnabled(true);
+  ASSERT_TRUE(chai::Instrumentation::isEnabled());
+  metrics->setEnabled(false);
+
+  const chai::Metrics::Snapshot before = metrics->snapshot();
+
+  chai::ManagedArray<int> array(10, chai::CPU);
+  rm->setExecutionSpace(chai::CPU);
+  chai::ManagedArray<int> captured = array;
+  (void) captured;
+  rm->setExecutionSpace(chai::NONE);
+  array.free();
+
+  const chai::Metrics::Snapshot after = metrics->snapshot();
+  ASSERT_EQ(after.allocations[chai::CPU], before.allocations[chai::CPU]);
+  ASSERT_EQ(after.allocation_latency[chai::CPU].count,
+            before.allocation_latency[chai::CPU].count);
+  ASSERT_EQ(after.frees[chai::CPU], before.frees[chai::CPU]);
+  ASSERT_EQ(after.kernels[chai::CPU], before.kernels[chai::CPU]);
+  ASSERT_EQ(after.captures, before.captures);
+
+  // Frees of allocations made while disabled do not wrap the bytes in use
+  chai::ManagedArray<int> unrecorded(10, chai::CPU);
+  metrics->setEnabled(true);
+  metrics->clear();
+  unrecorded.free();
+  ASSERT_EQ(metrics->snapshot().bytesInUse(chai::CPU), 0u);
+}
+
+TEST(Metrics, Export)
+{
+  chai::Metrics metrics;
+  metrics.recordAllocation(chai::CPU, 64, std::chrono::microseconds(3));
+  metrics.recordMove(chai::CPU, 64);
+  metrics.recordMove(chai::CPU, 100);
+
+  const chai::Metrics::Snapshot snapshot = metrics.snapshot();
+  ASSERT_EQ(snapshot.allocation_latency[chai::CPU].sum, 3000u);
+  ASSERT_EQ(snapshot.move_size.buckets[7], 2u);
+
+  std::ostringstream json;
+  snapshot.writeJson(json);
+  ASSERT_NE(json.str().find("\"bytes_allocated\": {\"CPU\": 64"),
+            std::string::npos);
+  ASSERT_NE(json.str().find("{\"le\": 127, \"count\": 2}"), std::string::npos);
+
+  std::ostringstream text;
+  snapshot.writePrometheus(text);
+  ASSERT_NE(text.str().find("# TYPE chai_allocations_total counter"),
+            std::string::npos);
+  ASSERT_NE(text.str().find("chai_allocations_total{space=\"CPU\"} 1"),
+            std::string::npos);
+  ASSERT_NE(text.str().find("chai_move_size_bytes_bucket{le=\"127\"} 2"),
+            std::string::npos);
+  ASSERT_NE(text.str().find("chai_move_size_bytes_bucket{le=\"+Inf\"} 2"),
+            std::string::npos);
+  ASSERT_NE(text.str().find("chai_move_size_bytes_sum 164"),
+            std::string::npos);
+
+  const std::string path = "chai_metrics_unit_test.json";
+  ASSERT_TRUE(metrics.write(path));
+
+  std::ifstream file(path);
+  std::stringstream written;
+  written << file.rdbuf();
+  ASSERT_EQ(written.str(), json.str());
+  std::remove(path.c_str());
+
+  metrics.clear();
+  ASSERT_EQ(metrics.snapshot().move_size.count, 0u);
+}
+
+TEST(Metrics, Regions)
+{
+  chai::RegionStatistics* regions = chai::RegionStatistics::getInstance();
+  chai::Metrics metrics;
+
+  regions->setEnabled(false);
+  ASSERT_TRUE(metrics.snapshot().regions.empty());
+
+  regions->setEnabled(true);
+  {
+    chai::ScopedRegion outer("metrics");
+    chai::ScopedRegion inner("say \"hi\"");
+    chai::ManagedArray<int> array(16, chai::CPU);
+    array.free();
+  }
+
+  const chai::Metrics::Snapshot snapshot = metrics.snapshot();
+  regions->setEnabled(false);
+
+  bool found = false;
+  for (auto const& region : snapshot.regions) {
+    ASSERT_NE(region.depth, 0);
+    if (region.path == "metrics/say \"hi\"") {
+      ASSERT_GE(region.bytes_allocated, 16 * sizeof(int));
+      found = true;
+    }
+  }
+  ASSERT_TRUE(found);
+
+  std::ostringstream json;
+  snapshot.writeJson(json);
+  ASSERT_NE(json.str().find("{\"path\": \"metrics/say \\\"hi\\\"\""),
+            std::string::npos);
+
+  std::ostringstream text;
+  snapshot.writePrometheus(text);
+  ASSERT_NE(text.str().find("chai_region_allocated_bytes_total"
+                            "{region=\"metrics\"} "),
+            std::string::npos);
+  ASSERT_NE(text.str().find("chai_region_moved_bytes_total"
+                            "{region=\"metrics\",destination=\"CPU\"} "),
+            std::string::npos);
+}
+
+#if defined(CHAI_ENABLE_CUDA) || defined(CHAI_ENABLE_HIP) || defined(CHAI_ENABLE_GPU_SIMULATION_MODE)
+TEST(Metrics, Moves)
+{
+  chai::ArrayManager* rm = chai::ArrayManager::getInstance();
+  chai::Metrics* metrics = rm->getMetrics();
+  metrics->setEnabled(true);
+
+  chai::ManagedArray<int> array(100, chai::CPU);
+  array.data()[0] = 1;
+
+  const chai::Metrics::Snapshot before = metrics->snapshot();
+
+  array.move(chai::GPU);
+  rm->evict(chai::GPU, chai::CPU);
+
+  const chai::Metrics::Snapshot after = metrics->snapshot();
+  ASSERT_EQ(after.moves[chai::GPU], before.moves[chai::GPU] + 1);
+  ASSERT_EQ(after.moves[chai::CPU], before.moves[chai::CPU] + 1);
+  ASSERT_EQ(after.bytes_moved[chai::GPU],
+            before.bytes_moved[chai::GPU] + 100 * sizeof(int));
+  ASSERT_EQ(after.move_size.count, before.move_size.count + 2);
+  ASSERT_EQ(after.move_latency.count, before.move_latency.count + 2);
+  ASSERT_EQ(after.evictions, before.evictions + 1);
+  ASSERT_EQ(after.bytes_evicted, before.bytes_evicted + 100 * sizeof(int));
+  ASSERT_EQ(after.bytesInUse(chai::GPU), before.bytesInUse(chai::GPU));
+
+  array.free();
+}
+#endif
@@ -0,0 +1,133 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#include "gtest/gtest.h"
+
+#include "chai/ArrayManager.hpp"
+#include "chai/ManagedArray.hpp"
+#include "chai/OperationLog.hpp"
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+namespace {
+
+std::string logPath(const char* name)
+{
+  return std::string("chai_operation_log_") + name + ".bin";
+}
+
+}  // end of anonymous namespace
+
+TEST(OperationLog, Replay)
+{
+  chai::ArrayManager* rm = chai::ArrayManager::getInstance();
+  chai::OperationRecorder* recorder = chai::OperationRecorder::getInstance();
+
+  const std::string path = logPath("replay");
+  ASSERT_TRUE(recorder->start(path));
+  ASSERT_TRUE(recorder->isRecording());
+
+  chai::ManagedArray<int> kept(100);
+  kept.data()[0] = 1;
+  kept.reallocate(200);
+
+  chai::ManagedArray<double> freed(50);
+  freed.data()[0] = 1.0;
+  freed.free();
+
+  recorder->stop();
+  ASSERT_FALSE(recorder->isRecording());
+
+  const size_t arrays = rm->getTotalNumArrays();
+  const size_t size = rm->getTotalSize();
+
+  {
+    chai::OperationReplayer replayer;
+    ASSERT_TRUE(replayer.replay(path));
+    ASSERT_GE(replayer.getNumOperations(), 6u);
+
+    // Only the array left allocated by the log remains
+    ASSERT_EQ(rm->getTotalNumArrays(), arrays + 1);
+    ASSERT_EQ(rm->getTotalSize(), size + 200 * sizeof(int));
+
+    replayer.clear();
+    ASSERT_EQ(rm->getTotalNumArrays(), arrays);
+  }
+
+  kept.free();
+  std::remove(path.c_str());
+}
+
+TEST(OperationLog, Unmanaged)
+{
+  chai::ManagedArray<float> array(10);
+  array.data()[0] = 1.0f;
+
+  // An array allocated before recording starts is allocated by the replay
+  const std::string path = logPath("unmanaged");
+  chai::OperationRecorder* recorder = chai::OperationRecorder::getInstance();
+  ASSERT_TRUE(recorder->start(path));
+
+  array.data()[1] = 2.0f;
+
+  recorder->stop();
+
+  chai::ArrayManager* rm = chai::ArrayManager::getInstance();
+  const size_t size = rm->getTotalSize();
+
+  chai::OperationReplayer replayer;
+  ASSERT_TRUE(replayer.replay(path));
+  ASSERT_EQ(rm->getTotalSize(), size + 10 * sizeof(float));
+
+  replayer.clear();
+  array.free();
+  std::remove(path.c_str());
+}
+
+TEST(OperationLog, NotALog)
+{
+  std::istringstream stream("not a log");
+
+  chai::OperationReplayer replayer;
+  ASSERT_FALSE(replayer.replay(stream));
+  ASSERT_EQ(replayer.getNumOperations(), 0u);
+
+  ASSERT_FALSE(replayer.replay(logPath("missing")));
+}
+
+#if defined(CHAI_ENABLE_CUDA) || defined(CHAI_ENABLE_HIP) || defined(CHAI_ENABLE_GPU_SIMULATION_MODE)
+TEST(OperationLog, Move)
+{
+  chai::ArrayManager* rm = chai::ArrayManager::getInstance();
+  chai::OperationRecorder* recorder = chai::OperationRecorder::getInstance();
+
+  const std::string path = logPath("move");
+  ASSERT_TRUE(recorder->start(path));
+
+  chai::ManagedArray<int> array(100);
+  array.data()[0] = 1;
+  array.move(chai::GPU);
+  array.move(chai::CPU);
+
+  recorder->stop();
+
+  const size_t arrays = rm->getTotalNumArrays();
+
+  chai::OperationReplayer replayer;
+  ASSERT_TRUE(replayer.replay(path));
+
+  // The replayed array lives in both spaces
+  ASSERT_EQ(rm->getTotalNumArrays(), arrays + 2);
+
+  replayer.clear();
+  ASSERT_EQ(rm->getTotalNumArrays(), arrays);
+
+  array.free();
+  std::remove(path.c_str());
+}
+#endif
@@ -0,0 +1,159 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#include "gtest/gtest.h"
+
+#include "chai/ArrayManager.hpp"
+#include "chai/ManagedArray.hpp"
+#include "chai/PointerTable.hpp"
+
+#include <vector>
+
+TEST(PointerTable, HostTable)
+{
+  chai::ManagedArray<int> first(10, chai::CPU);
+  chai::ManagedArray<int> second(20, chai::CPU);
+
+  chai::ManagedArray<int> arrays[3] = {first, second, second.slice(5, 10)};
+  chai::PointerTable table(arrays, 3);
+
+  ASSERT_EQ(table.size(), 3u);
+
+  void** pointers = table.capture(chai::CPU, true);
+  ASSERT_EQ(pointers[0], first.data(chai::CPU, false));
+  ASSERT_EQ(pointers[1], second.data(chai::CPU, false));
+  ASSERT_EQ(pointers[2], second.data(chai::CPU, false) + 5);
+
+  // The table is only rewritten when the arrays move to other addresses
+  ASSERT_EQ(table.get(chai::CPU), pointers);
+  ASSERT_EQ(pointers[0], first.data(chai::CPU, false));
+
+  first.reallocate(100);
+  pointers = table.get(chai::CPU);
+  ASSERT_EQ(pointers[0], first.data(chai::CPU, false));
+
+  first.free();
+  second.free();
+}
+
+TEST(PointerTable, NullArrays)
+{
+  chai::ManagedArray<double> arrays[2];
+  chai::PointerTable table(arrays, 2);
+
+  void** pointers = table.capture(chai::CPU, false);
+  ASSERT_EQ(pointers[0], nullptr);
+  ASSERT_EQ(pointers[1], nullptr);
+}
+
+TEST(PointerTable, References)
+{
+  chai::ManagedArray<int> arrays[1] = {chai::ManagedArray<int>(10, chai::CPU)};
+
+  chai::PointerTable* table = new chai::PointerTable(arrays, 1);
+  table->retain();
+  table->retain();
+
+  // The table lives until its last reference is dropped
+  table->release();
+  ASSERT_EQ(table->capture(chai::CPU, true)[0], arrays[0].data(chai::CPU, false));
+  table->release();
+
+  arrays[0].free();
+}
+
+#if defined(CHAI_ENABLE_CUDA) || defined(CHAI_ENABLE_HIP) || defined(CHAI_ENABLE_GPU_SIMULATION_MODE)
+/*!
+ * \brief Tests that capturing a table moves all of its arrays, and that the
+ *        table of the device holds their device pointers
+ */
+TEST(PointerTable, DeviceTable)
+{
+  chai::ArrayManager* arrayManager = chai::ArrayManager::getInstance();
+
+  int moves = 0;
+  auto count_moves = [&] (const chai::PointerRecord*, chai::Action action,
+                          chai::ExecutionSpace) {
+    if (action == chai::ACTION_MOVE) {
+      ++moves;
+    }
+  };
+
+  chai::ManagedArray<int> arrays[2] = {chai::ManagedArray<int>(10, chai::CPU),
+                                       chai::ManagedArray<int>(10, chai::CPU)};
+  arrays[0].setUserCallback(count_moves);
+  arrays[1].setUserCallback(count_moves);
+  arrays[0].data()[0] = 1;
+  arrays[1].data()[0] = 2;
+
+  chai::PointerTable table(arrays, 2);
+
+  void** device = table.capture(chai::GPU, true);
+  ASSERT_EQ(moves, 2);
+
+  std::vector<chai::PointerRecord*> records;
+  for (auto& array : arrays) {
+    records.push_back(arrayManager->getPointerRecord(array.data(chai::CPU, false)));
+    ASSERT_EQ(records.back()->m_last_space, chai::GPU);
+  }
+
+  void** host = static_cast<void**>(
+      arrayManager->getAllocator(chai::CPU).allocate(2 * sizeof(void*)));
+  arrayManager->copy(host, device, 2 * sizeof(void*));
+  ASSERT_EQ(host[0], records[0]->m_pointers[chai::GPU]);
+  ASSERT_EQ(host[1], records[1]->m_pointers[chai::GPU]);
+  arrayManager->getAllocator(chai::CPU).deallocate(host);
+
+  // Capturing again moves nothing and keeps the table
+  ASSERT_EQ(table.capture(chai::GPU, true), device);
+  ASSERT_EQ(moves, 2);
+
+  table.capture(chai::CPU, false);
+  ASSERT_EQ(moves, 4);
+  ASSERT_EQ(records[0]->m_last_space, chai::GPU);
+
+  arrays[0].free();
+  arrays[1].free();
+}
+
+/*!
+ * \brief Tests that slices of one array are moved once
+ */
+TEST(PointerTable, SharedRecord)
+{
+  chai::ArrayManager* arrayManager = chai::ArrayManager::getInstance();
+
+  int moves = 0;
+  chai::ManagedArray<int> array(10, chai::CPU);
+  array.setUserCallback([&] (const chai::PointerRecord*, chai::Action action,
+                             chai::ExecutionSpace) {
+    if (action == chai::ACTION_MOVE) {
+      ++moves;
+    }
+  });
+  array.data()[5] = 3;
+
+  chai::ManagedArray<int> arrays[3] = {array, array.slice(5, 5), array};
+  chai::PointerTable table(arrays, 3);
+
+  void** device = table.capture(chai::GPU, true);
+  ASSERT_EQ(moves, 1);
+
+  void** host = static_cast<void**>(
+      arrayManager->getAllocator(chai::CPU).allocate(3 * sizeof(void*)));
+  arrayManager->copy(host, device, 3 * sizeof(void*));
+  int* pointer = static_cast<int*>(host[0]);
+  ASSERT_EQ(host[1], pointer + 5);
+  ASSERT_EQ(host[2], pointer);
+  arrayManager->getAllocator(chai::CPU).deallocate(host);
+
+  table.capture(chai::CPU, false);
+  ASSERT_EQ(moves, 2);
+  ASSERT_EQ(array.data()[5], 3);
+
+  array.free();
+}
+#endif
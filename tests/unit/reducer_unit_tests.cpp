@@ -0,0 +1,130 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#include "gtest/gtest.h"
+
+#include "chai/Reducers.hpp"
+#include "chai/ThreadPool.hpp"
+
+namespace {
+
+struct Triple {
+  double x;
+  double y;
+  double z;
+};
+
+struct TripleSumOp {
+  Triple operator()(Triple a, Triple b) const
+  {
+    return Triple{a.x + b.x, a.y + b.y, a.z + b.z};
+  }
+};
+
+class TripleSum : public chai::Reducer<Triple, TripleSumOp>
+{
+public:
+  TripleSum() : chai::Reducer<Triple, TripleSumOp>(Triple{0.0, 0.0, 0.0}) {}
+
+  size_t getStride() const { return m_stride; }
+};
+
+}  // end of anonymous namespace
+
+TEST(Reducer, Identity)
+{
+  chai::ReduceSum<int> sum;
+  chai::ReduceMin<double> min(1.0e10);
+  chai::ReduceMax<double> max(-1.0e10);
+
+  ASSERT_EQ(sum.get(), 0);
+  ASSERT_EQ(min.get(), 1.0e10);
+  ASSERT_EQ(max.get(), -1.0e10);
+
+  sum.free();
+  min.free();
+  max.free();
+}
+
+TEST(Reducer, ThreadSlots)
+{
+  chai::ThreadPool* pool = chai::ThreadPool::getInstance();
+  pool->setNumThreads(4);
+
+  chai::ReduceSum<long> sum;
+  chai::ReduceMin<int> min(1000000);
+  chai::ReduceMax<int> max(-1);
+
+  pool->parallelFor(0, 10000, chai::SCHEDULE_GUIDED, [&] (int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+      sum += i;
+      min.min((i * 7919) % 10007);
+      max.max(i);
+    }
+  });
+
+  ASSERT_EQ(sum.get(), 10000L * 9999L / 2);
+  ASSERT_EQ(min.get(), 0);
+  ASSERT_EQ(max.get(), 9999);
+
+  sum.free();
+  min.free();
+  max.free();
+}
+
+TEST(Reducer, CombineSlots)
+{
+  chai::ThreadPool* pool = chai::ThreadPool::getInstance();
+  pool->setNumThreads(4);
+
+  chai::ReduceSum<int> sum;
+
+  pool->parallelFor(0, 100, chai::SCHEDULE_STATIC, [&] (int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+      sum += 1;
+    }
+  });
+
+  sum.combineSlots();
+  ASSERT_EQ(sum.get(), 100);
+  ASSERT_EQ(sum.getManaged()[0], 100);
+
+  sum.resetSlots();
+  ASSERT_EQ(sum.get(), 0);
+
+  sum.free();
+}
+
+TEST(Reducer, MinLocTies)
+{
+  chai::ThreadPool* pool = chai::ThreadPool::getInstance();
+  pool->setNumThreads(4);
+
+  chai::ReduceMinLoc<double> min(1.0e10);
+  ASSERT_EQ(min.getLoc(), -1);
+
+  // The smallest value appears at 250 and 750; the first location wins
+  pool->parallelFor(0, 1000, chai::SCHEDULE_STATIC, [&] (int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+      min.minloc((i % 500 == 250) ? -1.0 : static_cast<double>(i), i);
+    }
+  });
+
+  ASSERT_EQ(min.get(), -1.0);
+  ASSERT_EQ(min.getLoc(), 250);
+
+  min.free();
+}
+
+TEST(Reducer, SlotsOnSeparateLines)
+{
+  // A size that does not divide the line still keeps the slots a line apart
+  TripleSum triple;
+  ASSERT_GE(triple.getStride() * sizeof(Triple), 64u);
+  ASSERT_LT((triple.getStride() - 1) * sizeof(Triple), 64u);
+
+  triple.free();
+}
@@ -0,0 +1,218 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#include "gtest/gtest.h"
+
+#include "chai/ArrayManager.hpp"
+#include "chai/KernelStatistics.hpp"
+#include "chai/ManagedArray.hpp"
+#include "chai/RegionStatistics.hpp"
+#include "chai/Tracer.hpp"
+
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace {
+
+chai::RegionStatistics::Entry findEntry(std::string const& path)
+{
+  for (auto const& entry :
+       chai::RegionStatistics::getInstance()->getEntries()) {
+    if (entry.path == path) {
+      return entry;
+    }
+  }
+
+  return chai::RegionStatistics::Entry();
+}
+
+}  // end of anonymous namespace
+
+TEST(RegionStatistics, Nesting)
+{
+  chai::RegionStatistics* statistics = chai::RegionStatistics::getInstance();
+  chai::Region* root = chai::RegionStatistics::current();
+  ASSERT_EQ(root, statistics->getRoot());
+
+  {
+    chai::ScopedRegion outer("nesting");
+    ASSERT_STREQ(chai::RegionStatistics::current()->getName(), "nesting");
+
+    chai::pushRegion("inner");
+    ASSERT_EQ(chai::RegionStatistics::current()->getPath(), "nesting/inner");
+    chai::popRegion();
+
+    // Names are compared by value as well as by pointer
+    std::string name("inner");
+    chai::pushRegion(name.c_str());
+    ASSERT_EQ(chai::RegionStatistics::current()->getPath(), "nesting/inner");
+    chai::popRegion();
+  }
+
+  ASSERT_EQ(chai::RegionStatistics::current(), root);
+
+  // Popping outside of any region is ignored
+  chai::popRegion();
+  ASSERT_EQ(chai::RegionStatistics::current(), root);
+
+  ASSERT_EQ(findEntry("nesting").entries, 1u);
+  ASSERT_EQ(findEntry("nesting/inner").entries, 2u);
+  ASSERT_EQ(findEntry("nesting/inner").depth, 2);
+}
+
+TEST(RegionStatistics, Threads)
+{
+  chai::ScopedRegion region("threads");
+
+  std::thread thread([] {
+    // Each thread has its own stack of regions
+    ASSERT_EQ(chai::RegionStatistics::current(),
+              chai::RegionStatistics::getInstance()->getRoot());
+
+    chai::ScopedRegion worker("worker");
+    ASSERT_EQ(chai::RegionStatistics::current()->getPath(), "worker");
+  });
+  thread.join();
+
+  ASSERT_EQ(chai::RegionStatistics::current()->getPath(), "threads");
+}
+
+TEST(RegionStatistics, Traffic)
+{
+  chai::RegionStatistics* statistics = chai::RegionStatistics::getInstance();
+  statistics->setEnabled(true);
+  statistics->clear();
+
+  chai::ArrayManager* rm = chai::ArrayManager::getInstance();
+  chai::ManagedArray<double> array;
+
+  {
+    chai::ScopedRegion setup("setup");
+    array.allocate(100, chai::CPU);
+  }
+
+  {
+    chai::ScopedRegion remap("remap");
+
+    rm->setExecutionSpace(chai::CPU);
+    chai::ManagedArray<double> captured = array;
+    (void) captured;
+    rm->setExecutionSpace(chai::NONE);
+  }
+
+  ASSERT_EQ(findEntry("setup").allocations, 1u);
+  ASSERT_EQ(findEntry("setup").bytes_allocated, 100 * sizeof(double));
+  ASSERT_EQ(findEntry("remap").captures, 1u);
+  ASSERT_EQ(findEntry("remap").allocations, 0u);
+
+  // The root holds the totals of the program
+  chai::RegionStatistics::Entry total = statistics->getEntries().front();
+  ASSERT_EQ(total.path, "");
+  ASSERT_GE(total.allocations, 1u);
+  ASSERT_GE(total.captures, 1u);
+
+  std::ostringstream report;
+  statistics->report(report);
+  ASSERT_NE(report.str().find("(program)"), std::string::npos);
+  ASSERT_NE(report.str().find("  remap"), std::string::npos);
+
+  array.free();
+}
+
+TEST(RegionStatistics, Disabled)
+{
+  chai::RegionStatistics* statistics = chai::RegionStatistics::getInstance();
+  statistics->setEnabled(false);
+  statistics->clear();
+
+  chai::ManagedArray<double> array;
+
+  {
+    chai::ScopedRegion setup("disabled");
+    array.allocate(100, chai::CPU);
+  }
+
+  ASSERT_EQ(findEntry("disabled").entries, 1u);
+  ASSERT_EQ(findEntry("disabled").allocations, 0u);
+  ASSERT_EQ(findEntry("disabled").bytes_allocated, 0u);
+
+  array.free();
+}
+
+TEST(RegionStatistics, Kernels)
+{
+  chai::KernelStatistics* kernels = chai::KernelStatistics::getInstance();
+  kernels->setEnabled(true);
+  kernels->clear();
+
+  chai::ArrayManager* rm = chai::ArrayManager::getInstance();
+
+  for (const char* name : {"first", "second"}) {
+    chai::ScopedRegion region(name);
+    rm->setExecutionSpace(chai::CPU);
+    rm->setExecutionSpace(chai::NONE);
+  }
+
+  const std::vector<chai::KernelStatistics::Entry> entries =
+      kernels->getEntries();
+  ASSERT_EQ(entries.size(), 2u);
+  ASSERT_EQ(entries[0].name, "CPU kernel");
+  ASSERT_EQ(entries[0].region, "first");
+  ASSERT_EQ(entries[1].region, "second");
+
+  kernels->setEnabled(false);
+  kernels->clear();
+}
+
+TEST(RegionStatistics, Trace)
+{
+  chai::Tracer* tracer = chai::Tracer::getInstance();
+  tracer->clear();
+  tracer->setEnabled(true);
+
+  {
+    chai::ScopedRegion region("traced");
+    chai::ManagedArray<int> array(10, chai::CPU);
+    array.free();
+  }
+
+  tracer->setEnabled(false);
+
+  std::ostringstream trace;
+  tracer->write(trace);
+  ASSERT_NE(trace.str().find("\"region\":\"traced\""), std::string::npos);
+
+  tracer->clear();
+}
+
+#if defined(CHAI_ENABLE_CUDA) || defined(CHAI_ENABLE_HIP) || defined(CHAI_ENABLE_GPU_SIMULATION_MODE)
+TEST(RegionStatistics, Moves)
+{
+  chai::RegionStatistics* statistics = chai::RegionStatistics::getInstance();
+  statistics->setEnabled(true);
+  statistics->clear();
+
+  chai::ManagedArray<int> array(100, chai::CPU);
+  array.data()[0] = 1;
+  array.move(chai::GPU);
+
+  {
+    chai::ScopedRegion remap("moves");
+    array.move(chai::CPU);
+  }
+
+  ASSERT_EQ(findEntry("moves").bytes_moved[chai::CPU], 100 * sizeof(int));
+  ASSERT_EQ(findEntry("moves").bytes_moved[chai::GPU], 0u);
+  ASSERT_EQ(findEntry("").bytes_moved[chai::GPU], 100 * sizeof(int));
+
+  std::ostringstream report;
+  statistics->report(report);
+  ASSERT_NE(report.str().find("moved to CPU"), std::string::npos);
+
+  array.free();
+}
+#endif
@@ -0,0 +1,54 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#include "gtest/gtest.h"
+
+#include "chai/Simd.hpp"
+
+#include <vector>
+
+TEST(Simd, PackOperators)
+{
+  chai::SimdIndex batch{10, chai::SimdIndex::width};
+  chai::Pack<double> index = chai::Pack<double>::index(batch);
+
+  chai::Pack<double> result = 2.0 * index + 1.0;
+  result -= chai::Pack<double>(1.0);
+  result = result / 2.0;
+
+  for (int l = 0; l < chai::SimdIndex::width; ++l) {
+    ASSERT_EQ(result[l], batch[l]);
+  }
+
+  ASSERT_EQ(result.sum(2), 21.0);
+}
+
+TEST(Simd, LoadStore)
+{
+  const int width = chai::SimdIndex::width;
+  std::vector<int> source(3 * width);
+  std::vector<int> destination(3 * width, -1);
+
+  for (size_t i = 0; i < source.size(); ++i) {
+    source[i] = static_cast<int>(i);
+  }
+
+  chai::SimdIndex full{width, width};
+  chai::storePack(destination.data(), full,
+                  chai::loadPack(source.data(), full));
+
+  chai::SimdIndex partial{2 * width, 1};
+  chai::storePack(destination.data(), partial,
+                  chai::loadPack(source.data(), partial));
+
+  for (int i = 0; i < 3 * width; ++i) {
+    if (i >= width && i <= 2 * width) {
+      ASSERT_EQ(destination[i], i);
+    } else {
+      ASSERT_EQ(destination[i], -1);
+    }
+  }
+}
@@ -0,0 +1,217 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#include "gtest/gtest.h"
+
+#include "chai/ArrayManager.hpp"
+#include "chai/ManagedArray.hpp"
+#include "chai/TagStatistics.hpp"
+
+#include <sstream>
+
+TEST(TagStatistics, Groups)
+{
+  chai::TagStatistics* statistics = chai::TagStatistics::getInstance();
+  statistics->setEnabled(true);
+
+  const size_t all = statistics->getUsage("*").bytes[chai::CPU];
+
+  chai::ManagedArray<double> density(100, chai::CPU, "hydro/density");
+  chai::ManagedArray<double> table(50, chai::CPU, "hydro/eos/table");
+  chai::ManagedArray<int> ids(10, chai::CPU, "particles/ids");
+
+  ASSERT_STREQ(density.getName(), "hydro/density");
+
+  ASSERT_EQ(statistics->getUsage("hydro/density").bytes[chai::CPU],
+            100 * sizeof(double));
+  ASSERT_EQ(statistics->getUsage("hydro/eos/*").bytes[chai::CPU],
+            50 * sizeof(double));
+  ASSERT_EQ(statistics->getUsage("hydro/*").bytes[chai::CPU],
+            150 * sizeof(double));
+  ASSERT_EQ(statistics->getUsage("particles/*").bytes[chai::CPU],
+            10 * sizeof(int));
+  ASSERT_EQ(statistics->getUsage("*").bytes[chai::CPU],
+            all + 150 * sizeof(double) + 10 * sizeof(int));
+
+  table.free();
+
+  chai::TagStatistics::Entry hydro = statistics->getUsage("hydro/*");
+  ASSERT_EQ(hydro.bytes[chai::CPU], 100 * sizeof(double));
+  ASSERT_EQ(hydro.peak_bytes[chai::CPU], 150 * sizeof(double));
+  ASSERT_EQ(hydro.allocations, 2u);
+
+  density.reallocate(200);
+  ASSERT_EQ(statistics->getUsage("hydro/*").bytes[chai::CPU],
+            200 * sizeof(double));
+
+  std::ostringstream report;
+  statistics->report(report);
+  ASSERT_NE(report.str().find("hydro/eos/*"), std::string::npos);
+
+  density.free();
+  ids.free();
+
+  ASSERT_EQ(statistics->getUsage("hydro/*").bytes[chai::CPU], 0u);
+  ASSERT_EQ(statistics->getUsage("*").bytes[chai::CPU], all);
+  ASSERT_EQ(statistics->getUsage("unused/*").allocations, 0u);
+}
+
+TEST(TagStatistics, NamedAllocationCounts)
+{
+  chai::TagStatistics* statistics = chai::TagStatistics::getInstance();
+  statistics->setEnabled(true);
+
+  const size_t all = statistics->getUsage("*").allocations;
+  const size_t unnamed = statistics->getUsage("(unnamed)").allocations;
+
+  chai::ManagedArray<int> array(10, chai::CPU, "counted/array");
+
+  ASSERT_EQ(statistics->getUsage("counted/array").allocations, 1u);
+  ASSERT_EQ(statistics->getUsage("*").allocations, all + 1);
+  ASSERT_EQ(statistics->getUsage("(unnamed)").allocations, unnamed);
+
+  array.free();
+}
+
+TEST(TagStatistics, PeakRegion)
+{
+  chai::TagStatistics* statistics = chai::TagStatistics::getInstance();
+  statistics->setEnabled(true);
+
+  chai::ManagedArray<int> small;
+  {
+    chai::ScopedRegion setup("setup");
+    small.allocate(10, chai::CPU,
+                   [] (const chai::PointerRecord*, chai::Action, chai::ExecutionSpace) {},
+                   "peaked/small");
+  }
+
+  chai::TagStatistics::Entry peaked = statistics->getUsage("peaked/*");
+  ASSERT_NE(peaked.peak_region[chai::CPU], nullptr);
+  ASSERT_EQ(peaked.peak_region[chai::CPU]->getPath(), "setup");
+
+  chai::ManagedArray<int> large;
+  {
+    chai::ScopedRegion solve("solve");
+    large.allocate(100, chai::CPU,
+                   [] (const chai::PointerRecord*, chai::Action, chai::ExecutionSpace) {},
+                   "peaked/large");
+  }
+
+  peaked = statistics->getUsage("peaked/*");
+  ASSERT_EQ(peaked.peak_region[chai::CPU]->getPath(), "solve");
+  ASSERT_EQ(statistics->getUsage("peaked/small").peak_region[chai::CPU]->getPath(),
+            "setup");
+
+  std::ostringstream report;
+  statistics->report(report);
+  ASSERT_NE(report.str().find("CPU:solve"), std::string::npos);
+
+  large.free();
+  small.free();
+
+  // Frees do not move the peak, nor its region
+  peaked = statistics->getUsage("peaked/*");
+  ASSERT_EQ(peaked.peak_region[chai::CPU]->getPath(), "solve");
+}
+
+TEST(TagStatistics, Rename)
+{
+  chai::TagStatistics* statistics = chai::TagStatistics::getInstance();
+  statistics->setEnabled(true);
+
+  chai::ManagedArray<int> array(25, chai::CPU);
+  array.data()[0] = 0;
+  ASSERT_EQ(array.getName(), nullptr);
+
+  const size_t unnamed = statistics->getUsage("(unnamed)").bytes[chai::CPU];
+  const size_t all = statistics->getUsage("*").allocations;
+
+  array.setName("mesh/nodes");
+  ASSERT_EQ(statistics->getUsage("mesh/nodes").bytes[chai::CPU],
+            25 * sizeof(int));
+  ASSERT_EQ(statistics->getUsage("(unnamed)").bytes[chai::CPU],
+            unnamed - 25 * sizeof(int));
+
+  // Renaming is not an allocation
+  ASSERT_EQ(statistics->getUsage("*").allocations, all);
+  ASSERT_EQ(statistics->getUsage("mesh/nodes").allocations, 0u);
+
+  chai::ManagedArray<int> copy = chai::deepCopy(array);
+  ASSERT_STREQ(copy.getName(), "mesh/nodes");
+  ASSERT_EQ(statistics->getUsage("mesh/*").bytes[chai::CPU],
+            50 * sizeof(int));
+
+  statistics->resetPeaks();
+  copy.free();
+  ASSERT_EQ(statistics->getUsage("mesh/*").peak_bytes[chai::CPU],
+            50 * sizeof(int));
+
+  array.free();
+}
+
+TEST(TagStatistics, Disabled)
+{
+  chai::TagStatistics* statistics = chai::TagStatistics::getInstance();
+  statistics->setEnabled(false);
+
+  const chai::TagStatistics::Entry before = statistics->getUsage("*");
+
+  // Memory allocated while accounting is off is not accounted once it is on
+  chai::ManagedArray<int> early(10, chai::CPU, "toggled/early");
+  statistics->setEnabled(true);
+  chai::ManagedArray<int> late(20, chai::CPU, "toggled/late");
+  early.setName("toggled/renamed");
+  early.free();
+
+  ASSERT_EQ(statistics->getUsage("toggled/*").bytes[chai::CPU],
+            20 * sizeof(int));
+  ASSERT_EQ(statistics->getUsage("toggled/*").allocations, 1u);
+
+  // and memory allocated while it is on is accounted until it is freed
+  statistics->setEnabled(false);
+  late.free();
+
+  ASSERT_EQ(statistics->getUsage("toggled/*").bytes[chai::CPU], 0u);
+  ASSERT_EQ(statistics->getUsage("*").bytes[chai::CPU],
+            before.bytes[chai::CPU]);
+  ASSERT_EQ(statistics->getUsage("*").allocations, before.allocations + 1);
+
+  statistics->setEnabled(true);
+}
+
+#if defined(CHAI_ENABLE_CUDA) || defined(CHAI_ENABLE_HIP) || defined(CHAI_ENABLE_GPU_SIMULATION_MODE)
+TEST(TagStatistics, Moves)
+{
+  chai::ArrayManager* rm = chai::ArrayManager::getInstance();
+  chai::TagStatistics* statistics = chai::TagStatistics::getInstance();
+  statistics->setEnabled(true);
+
+  chai::ManagedArray<float> array;
+  array.allocate(64, chai::CPU,
+                 [] (const chai::PointerRecord*, chai::Action, chai::ExecutionSpace) {},
+                 "solver/rhs");
+  array.data()[0] = 1.0f;
+
+  rm->setExecutionSpace(chai::GPU);
+  chai::ManagedArray<float> captured = array;
+  (void) captured;
+  rm->setExecutionSpace(chai::NONE);
+
+  chai::TagStatistics::Entry solver = statistics->getUsage("solver/*");
+  ASSERT_EQ(solver.bytes[chai::CPU], 64 * sizeof(float));
+  ASSERT_EQ(solver.bytes[chai::GPU], 64 * sizeof(float));
+  ASSERT_EQ(solver.moves, 1u);
+  ASSERT_EQ(solver.bytes_moved, 64 * sizeof(float));
+
+  array.free();
+
+  solver = statistics->getUsage("solver/*");
+  ASSERT_EQ(solver.bytes[chai::CPU], 0u);
+  ASSERT_EQ(solver.bytes[chai::GPU], 0u);
+  ASSERT_EQ(solver.peak_bytes[chai::GPU], 64 * sizeof(float));
+}
+#endif
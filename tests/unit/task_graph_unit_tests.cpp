@@ -0,0 +1,132 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#include "gtest/gtest.h"
+
+#include "chai/TaskGraph.hpp"
+#include "chai/ThreadPool.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::vector<chai::ArrayManager::Access> accesses(
+    std::vector<std::pair<chai::PointerRecord*, bool>> const& list)
+{
+  std::vector<chai::ArrayManager::Access> result;
+  for (auto const& entry : list) {
+    result.push_back(chai::ArrayManager::Access{entry.first, entry.second});
+  }
+  return result;
+}
+
+}
+
+TEST(TaskGraph, Constructor)
+{
+  chai::TaskGraph graph;
+  ASSERT_EQ(graph.getNumTasks(), 0u);
+  ASSERT_EQ(graph.getNumDependencies(), 0u);
+}
+
+#if !defined(CHAI_DISABLE_RM)
+TEST(TaskGraph, Dependencies)
+{
+  chai::PointerRecord x;
+  chai::PointerRecord y;
+  chai::PointerRecord z;
+
+  std::mutex mutex;
+  std::vector<int> order;
+  auto task = [&] (int id) {
+    return [&, id] () {
+      std::lock_guard<std::mutex> lock(mutex);
+      order.push_back(id);
+    };
+  };
+
+  chai::TaskGraph graph;
+
+  // 0 and 1 are independent
+  graph.submit(task(0), accesses({{&x, true}}));
+  graph.submit(task(1), accesses({{&y, true}}));
+  // 2 reads what 0 and 1 wrote
+  graph.submit(task(2), accesses({{&x, false}, {&y, false}, {&z, true}}));
+  // 3 overwrites what 0 wrote and 2 read
+  graph.submit(task(3), accesses({{&x, true}, {&x, false}}));
+
+  ASSERT_EQ(graph.getNumTasks(), 4u);
+  ASSERT_EQ(graph.getNumDependencies(), 4u);
+
+  graph.run();
+
+  ASSERT_EQ(graph.getNumTasks(), 0u);
+  ASSERT_EQ(order.size(), 4u);
+  ASSERT_EQ(order[2], 2);
+  ASSERT_EQ(order[3], 3);
+}
+
+TEST(TaskGraph, IndependentTasksRunConcurrently)
+{
+  chai::ThreadPool* pool = chai::ThreadPool::getInstance();
+  const int num_threads = pool->getNumThreads();
+  pool->setNumThreads(2);
+
+  chai::PointerRecord x;
+  chai::PointerRecord y;
+
+  // Each task waits for the other to start, so they must run at once
+  std::atomic<int> started{0};
+  auto task = [&] () {
+    ++started;
+    while (started.load() < 2) {
+      std::this_thread::yield();
+    }
+  };
+
+  chai::TaskGraph graph;
+  graph.submit(task, accesses({{&x, true}}));
+  graph.submit(task, accesses({{&y, true}}));
+  ASSERT_EQ(graph.getNumDependencies(), 0u);
+
+  graph.run();
+  ASSERT_EQ(started.load(), 2);
+
+  pool->setNumThreads(num_threads);
+}
+
+TEST(TaskGraph, FailedTaskStopsGraph)
+{
+  chai::ThreadPool* pool = chai::ThreadPool::getInstance();
+  const int num_threads = pool->getNumThreads();
+  pool->setNumThreads(2);
+
+  chai::PointerRecord x;
+
+  bool ran_successor = false;
+
+  chai::TaskGraph graph;
+  graph.submit([] () { throw std::runtime_error("task failed"); },
+               accesses({{&x, true}}));
+  graph.submit([&] () { ran_successor = true; }, accesses({{&x, true}}));
+
+  ASSERT_THROW(graph.run(), std::runtime_error);
+  ASSERT_FALSE(ran_successor);
+  ASSERT_EQ(graph.getNumTasks(), 0u);
+
+  // The graph can be used again
+  bool ran = false;
+  graph.submit([&] () { ran = true; }, accesses({{&x, true}}));
+  graph.run();
+  ASSERT_TRUE(ran);
+
+  pool->setNumThreads(num_threads);
+}
+#endif
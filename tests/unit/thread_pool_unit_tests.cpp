@@ -0,0 +1,201 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#include "gtest/gtest.h"
+
+#include "chai/RegionStatistics.hpp"
+#include "chai/ThreadPool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+TEST(ThreadPool, Constructor)
+{
+  chai::ThreadPool* pool = chai::ThreadPool::getInstance();
+  ASSERT_NE(pool, nullptr);
+  ASSERT_GE(pool->getNumThreads(), 1);
+  ASSERT_EQ(chai::ThreadPool::getThreadId(), 0);
+}
+
+TEST(ThreadPool, StaticCoversRange)
+{
+  chai::ThreadPool* pool = chai::ThreadPool::getInstance();
+  pool->setNumThreads(4);
+
+  std::vector<int> hits(1000, 0);
+  pool->parallelFor(0, 1000, chai::SCHEDULE_STATIC, [&] (int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+      hits[i]++;
+    }
+  });
+
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_EQ(hits[i], 1);
+  }
+}
+
+TEST(ThreadPool, GuidedCoversRange)
+{
+  chai::ThreadPool* pool = chai::ThreadPool::getInstance();
+  pool->setNumThreads(4);
+
+  std::vector<int> hits(1003, 0);
+  std::atomic<int> chunks{0};
+  pool->parallelFor(3, 1003, chai::SCHEDULE_GUIDED, [&] (int begin, int end) {
+    chunks++;
+    for (int i = begin; i < end; ++i) {
+      hits[i]++;
+    }
+  });
+
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_EQ(hits[i], 0);
+  }
+  for (int i = 3; i < 1003; ++i) {
+    ASSERT_EQ(hits[i], 1);
+  }
+  ASSERT_GT(chunks.load(), 4);
+}
+
+TEST(ThreadPool, WorkStealingCoversRange)
+{
+  chai::ThreadPool* pool = chai::ThreadPool::getInstance();
+  pool->setNumThreads(4);
+
+  std::vector<int> hits(5000, 0);
+  pool->parallelFor(0, 5000, chai::SCHEDULE_WORK_STEALING, [&] (int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+      hits[i]++;
+    }
+  }, 7);
+
+  for (int i = 0; i < 5000; ++i) {
+    ASSERT_EQ(hits[i], 1);
+  }
+}
+
+TEST(ThreadPool, WorkStealingSkewed)
+{
+  chai::ThreadPool* pool = chai::ThreadPool::getInstance();
+  pool->setNumThreads(4);
+
+  // The last quarter of the range starts out with thread 3, which stays on
+  // its first index until another thread has run part of the rest. Only a
+  // steal lets the loop finish; the deadline turns a broken steal into a
+  // failure rather than a hang.
+  std::vector<int> owners(400, -1);
+  std::atomic<int> stolen{0};
+  std::atomic<bool> timed_out{false};
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(60);
+
+  pool->parallelFor(0, 400, chai::SCHEDULE_WORK_STEALING, [&] (int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+      const int thread_id = chai::ThreadPool::getThreadId();
+      owners[i] = thread_id;
+
+      if (i > 300 && thread_id != 3) {
+        ++stolen;
+      }
+
+      if (i == 300) {
+        while (stolen.load() == 0 && !timed_out.load()) {
+          if (std::chrono::steady_clock::now() > deadline) {
+            timed_out = true;
+          }
+          std::this_thread::yield();
+        }
+      }
+    }
+  }, 1);
+
+  ASSERT_FALSE(timed_out.load());
+  ASSERT_GT(stolen.load(), 0);
+
+  for (int i = 0; i < 400; ++i) {
+    ASSERT_GE(owners[i], 0);
+    ASSERT_LT(owners[i], 4);
+  }
+}
+
+TEST(ThreadPool, NestedRunsInline)
+{
+  chai::ThreadPool* pool = chai::ThreadPool::getInstance();
+  pool->setNumThreads(4);
+
+  std::atomic<int> total{0};
+  pool->parallelFor(0, 8, chai::SCHEDULE_STATIC, [&] (int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+      const int thread_id = chai::ThreadPool::getThreadId();
+      pool->parallelFor(0, 10, chai::SCHEDULE_STATIC, [&] (int b, int e) {
+        ASSERT_EQ(chai::ThreadPool::getThreadId(), thread_id);
+        total += e - b;
+      });
+    }
+  });
+
+  ASSERT_EQ(total.load(), 80);
+}
+
+TEST(ThreadPool, CallerRegion)
+{
+  chai::ThreadPool* pool = chai::ThreadPool::getInstance();
+  pool->setNumThreads(4);
+
+  std::vector<chai::Region const*> regions(4, nullptr);
+  std::vector<int> owners(4, -1);
+  chai::Region const* caller = nullptr;
+
+  {
+    chai::ScopedRegion region("pooled");
+    caller = chai::RegionStatistics::current();
+
+    pool->parallelFor(0, 4, chai::SCHEDULE_STATIC, [&] (int begin, int end) {
+      for (int i = begin; i < end; ++i) {
+        regions[i] = chai::RegionStatistics::current();
+        owners[i] = chai::ThreadPool::getThreadId();
+      }
+    });
+  }
+
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_EQ(owners[i], i);
+    ASSERT_EQ(regions[i], caller);
+  }
+
+  // The workers leave the region with the loop
+  chai::Region const* root = chai::RegionStatistics::current();
+  pool->parallelFor(0, 4, chai::SCHEDULE_STATIC, [&] (int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+      regions[i] = chai::RegionStatistics::current();
+    }
+  });
+
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_EQ(regions[i], root);
+  }
+}
+
+TEST(ThreadPool, Resize)
+{
+  chai::ThreadPool* pool = chai::ThreadPool::getInstance();
+
+  pool->setNumThreads(1);
+  ASSERT_EQ(pool->getNumThreads(), 1);
+
+  int sum = 0;
+  pool->parallelFor(0, 10, chai::SCHEDULE_STATIC, [&] (int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+      sum += i;
+    }
+  });
+  ASSERT_EQ(sum, 45);
+
+  pool->setNumThreads(3);
+  ASSERT_EQ(pool->getNumThreads(), 3);
+}
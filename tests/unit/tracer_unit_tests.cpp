@@ -0,0 +1,172 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#include "gtest/gtest.h"
+
+#include "chai/ArrayManager.hpp"
+#include "chai/ManagedArray.hpp"
+#include "chai/Tracer.hpp"
+
+#include <algorithm>
+#include <sstream>
+#include <thread>
+
+namespace {
+
+size_t countEvents(std::vector<chai::Tracer::Event> const& events,
+                   chai::Tracer::Kind kind)
+{
+  return std::count_if(events.begin(), events.end(),
+                       [=] (chai::Tracer::Event const& event) {
+                         return event.kind == kind;
+                       });
+}
+
+}  // end of anonymous namespace
+
+TEST(Tracer, Disabled)
+{
+  chai::Tracer* tracer = chai::Tracer::getInstance();
+  tracer->setEnabled(false);
+  tracer->clear();
+
+  chai::ManagedArray<int> array(10);
+  array.free();
+
+  ASSERT_TRUE(tracer->getEvents().empty());
+}
+
+TEST(Tracer, HostEvents)
+{
+  chai::ArrayManager* rm = chai::ArrayManager::getInstance();
+  chai::Tracer* tracer = chai::Tracer::getInstance();
+  tracer->setEnabled(true);
+  tracer->clear();
+
+  chai::ManagedArray<int> array(10, chai::CPU);
+
+  rm->setExecutionSpace(chai::CPU);
+  chai::ManagedArray<int> captured = array;
+  (void) captured;
+  rm->setExecutionSpace(chai::NONE);
+
+  array.free();
+  tracer->setEnabled(false);
+
+  std::vector<chai::Tracer::Event> events = tracer->getEvents();
+  ASSERT_EQ(countEvents(events, chai::Tracer::TRACE_ALLOCATE), 1u);
+  ASSERT_EQ(countEvents(events, chai::Tracer::TRACE_CAPTURE), 1u);
+  ASSERT_EQ(countEvents(events, chai::Tracer::TRACE_LAUNCH), 1u);
+  ASSERT_EQ(countEvents(events, chai::Tracer::TRACE_FREE), 1u);
+
+  for (size_t i = 1; i < events.size(); ++i) {
+    ASSERT_LE(events[i - 1].start, events[i].start);
+    ASSERT_LE(events[i].start, events[i].end);
+  }
+
+  std::ostringstream trace;
+  tracer->write(trace);
+  ASSERT_NE(trace.str().find("\"traceEvents\""), std::string::npos);
+  ASSERT_NE(trace.str().find("\"name\":\"launch\""), std::string::npos);
+  ASSERT_NE(trace.str().find("\"bytes\":40"), std::string::npos);
+
+  tracer->clear();
+}
+
+TEST(Tracer, PerThreadBuffers)
+{
+  chai::Tracer* tracer = chai::Tracer::getInstance();
+  tracer->setEnabled(true);
+  tracer->clear();
+
+  tracer->recordInstant(chai::Tracer::TRACE_CAPTURE, chai::CPU);
+
+  std::thread other([=] {
+    for (size_t i = 0; i < chai::Tracer::s_buffer_events + 10; ++i) {
+      tracer->recordInstant(chai::Tracer::TRACE_ALLOCATE, chai::CPU, i);
+    }
+  });
+  other.join();
+
+  tracer->setEnabled(false);
+
+  std::vector<chai::Tracer::Event> events = tracer->getEvents();
+
+  // Only the newest events of the other thread are kept
+  ASSERT_EQ(events.size(), chai::Tracer::s_buffer_events + 1);
+  ASSERT_EQ(events[0].kind, chai::Tracer::TRACE_CAPTURE);
+  ASSERT_EQ(events[1].bytes, 10u);
+  ASSERT_NE(events[0].thread, events[1].thread);
+
+  tracer->clear();
+}
+
+TEST(Tracer, ExitedThreads)
+{
+  chai::Tracer* tracer = chai::Tracer::getInstance();
+  tracer->setEnabled(true);
+  tracer->clear();
+
+  // Each thread takes the buffer of the thread that exited before it
+  for (size_t i = 0; i < 8; ++i) {
+    std::thread other([=] {
+      tracer->recordInstant(chai::Tracer::TRACE_ALLOCATE, chai::CPU, i);
+    });
+    other.join();
+  }
+
+  tracer->setEnabled(false);
+
+  std::vector<chai::Tracer::Event> events = tracer->getEvents();
+  ASSERT_EQ(events.size(), 8u);
+
+  for (size_t i = 0; i < events.size(); ++i) {
+    ASSERT_EQ(events[i].bytes, i);
+    ASSERT_EQ(events[i].thread, events[0].thread);
+  }
+
+  tracer->clear();
+}
+
+#if defined(CHAI_ENABLE_CUDA) || defined(CHAI_ENABLE_HIP) || defined(CHAI_ENABLE_GPU_SIMULATION_MODE)
+TEST(Tracer, Moves)
+{
+  chai::ArrayManager* rm = chai::ArrayManager::getInstance();
+  chai::Tracer* tracer = chai::Tracer::getInstance();
+
+  chai::ManagedArray<double> array(8, chai::CPU);
+  array.data()[0] = 1.0;
+
+  tracer->setEnabled(true);
+  tracer->clear();
+
+  rm->setExecutionSpace(chai::GPU);
+  chai::ManagedArray<double> captured = array;
+  (void) captured;
+  rm->setExecutionSpace(chai::NONE);
+
+  tracer->setEnabled(false);
+
+  std::vector<chai::Tracer::Event> events = tracer->getEvents();
+  ASSERT_EQ(countEvents(events, chai::Tracer::TRACE_MOVE), 1u);
+
+  auto move = std::find_if(events.begin(), events.end(),
+                           [] (chai::Tracer::Event const& event) {
+                             return event.kind == chai::Tracer::TRACE_MOVE;
+                           });
+  ASSERT_EQ(move->source, chai::CPU);
+  ASSERT_EQ(move->space, chai::GPU);
+  ASSERT_EQ(move->bytes, 8 * sizeof(double));
+
+  std::ostringstream trace;
+  tracer->write(trace);
+  ASSERT_NE(trace.str().find("\"from\":\"CPU\",\"to\":\"GPU\""),
+            std::string::npos);
+
+  tracer->clear();
+  array.free();
+}
+#endif
@@ -0,0 +1,167 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016-20, Lawrence Livermore National Security, LLC and CHAI
+// project contributors. See the COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//////////////////////////////////////////////////////////////////////////////
+#include "gtest/gtest.h"
+
+#include "chai/ArrayManager.hpp"
+#include "chai/KernelStatistics.hpp"
+#include "chai/ManagedArray.hpp"
+#include "chai/TransferChecker.hpp"
+
+#include <sstream>
+#include <vector>
+
+TEST(TransferChecker, Hash)
+{
+  std::vector<unsigned char> data(1013);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<unsigned char>(i * 7);
+  }
+
+  const std::uint64_t hash =
+      chai::TransferChecker::hash(data.data(), data.size());
+  ASSERT_EQ(hash, chai::TransferChecker::hash(data.data(), data.size()));
+
+  // Every byte, including the ones past the last full batch, is hashed
+  for (size_t i : {size_t(0), size_t(500), data.size() - 1}) {
+    data[i] ^= 1;
+    ASSERT_NE(hash, chai::TransferChecker::hash(data.data(), data.size()));
+    data[i] ^= 1;
+  }
+
+  ASSERT_NE(hash, chai::TransferChecker::hash(data.data(), data.size() - 1));
+
+  std::vector<unsigned char> zeros(64, 0);
+  ASSERT_NE(chai::TransferChecker::hash(zeros.data(), 32),
+            chai::TransferChecker::hash(zeros.data(), 64));
+}
+
+#if defined(CHAI_ENABLE_CUDA) || defined(CHAI_ENABLE_HIP) || defined(CHAI_ENABLE_GPU_SIMULATION_MODE)
+TEST(TransferChecker, Redundant)
+{
+  chai::TransferChecker* checker = chai::TransferChecker::getInstance();
+  chai::KernelStatistics* kernels = chai::KernelStatistics::getInstance();
+  chai::ArrayManager* rm = chai::ArrayManager::getInstance();
+
+  checker->clear();
+  checker->setEnabled(true);
+
+  chai::ManagedArray<int> array(100, chai::CPU, "checked");
+  for (int i = 0; i < 100; ++i) {
+    array.data()[i] = i;
+  }
+
+  // A kernel that captures the array without writing it
+  kernels->setKernelName("reads");
+  rm->setExecutionSpace(chai::GPU);
+  chai::ManagedArray<int> captured = array;
+  (void) captured;
+  rm->setExecutionSpace(chai::NONE);
+
+  // Copies the unchanged data back, then changes it
+  array.data()[0] = -1;
+
+  rm->setExecutionSpace(chai::GPU);
+  chai::ManagedArray<int> recaptured = array;
+  (void) recaptured;
+  rm->setExecutionSpace(chai::NONE);
+
+  std::vector<chai::TransferChecker::Entry> arrays = checker->getArrayEntries();
+  ASSERT_EQ(arrays.size(), 1u);
+  ASSERT_EQ(arrays[0].name, "checked");
+  ASSERT_EQ(arrays[0].moves, 3u);
+  ASSERT_EQ(arrays[0].redundant_moves, 1u);
+  ASSERT_EQ(arrays[0].bytes_wasted, 100 * sizeof(int));
+
+  std::vector<chai::TransferChecker::Entry> by_kernel =
+      checker->getKernelEntries();
+  ASSERT_EQ(by_kernel.size(), 2u);
+  ASSERT_EQ(by_kernel[0].name, "reads");
+  ASSERT_EQ(by_kernel[0].moves, 1u);
+  ASSERT_EQ(by_kernel[0].redundant_moves, 1u);
+  ASSERT_EQ(by_kernel[1].name, "(outside kernels)");
+  ASSERT_EQ(by_kernel[1].redundant_moves, 0u);
+
+  std::ostringstream report;
+  checker->report(report);
+  ASSERT_NE(report.str().find("1 of 3 moves"), std::string::npos);
+
+  array.free();
+  checker->setEnabled(false);
+  checker->clear();
+}
+
+TEST(TransferChecker, Regions)
+{
+  chai::TransferChecker* checker = chai::TransferChecker::getInstance();
+  chai::KernelStatistics* kernels = chai::KernelStatistics::getInstance();
+  chai::ArrayManager* rm = chai::ArrayManager::getInstance();
+
+  checker->clear();
+  checker->setEnabled(true);
+
+  chai::ManagedArray<int> array(100, chai::CPU, "regional");
+  array.data()[0] = 1;
+
+  // The same kernel reads the array in two regions, and each read copies
+  // the unchanged data back
+  const char* regions[] = {"predict", "correct"};
+  for (const char* name : regions) {
+    chai::ScopedRegion region(name);
+
+    kernels->setKernelName("reads");
+    rm->setExecutionSpace(chai::GPU);
+    chai::ManagedArray<int> captured = array;
+    (void) captured;
+    rm->setExecutionSpace(chai::NONE);
+
+    array.move(chai::CPU);
+  }
+
+  std::vector<chai::TransferChecker::Entry> by_kernel =
+      checker->getKernelEntries();
+  size_t reads = 0;
+  for (auto const& entry : by_kernel) {
+    if (entry.name == "reads") {
+      ASSERT_TRUE(entry.region == "predict" || entry.region == "correct");
+      ASSERT_EQ(entry.redundant_moves, 1u);
+      ++reads;
+    }
+  }
+  ASSERT_EQ(reads, 2u);
+
+  std::ostringstream report;
+  checker->report(report);
+  ASSERT_NE(report.str().find("reads [predict]"), std::string::npos);
+
+  array.free();
+  checker->setEnabled(false);
+  checker->clear();
+}
+
+TEST(TransferChecker, Disabled)
+{
+  chai::TransferChecker* checker = chai::TransferChecker::getInstance();
+  checker->setEnabled(false);
+  checker->clear();
+
+  chai::ArrayManager* rm = chai::ArrayManager::getInstance();
+  chai::ManagedArray<int> array(10, chai::CPU);
+  array.data()[0] = 1;
+
+  rm->setExecutionSpace(chai::GPU);
+  chai::ManagedArray<int> captured = array;
+  (void) captured;
+  rm->setExecutionSpace(chai::NONE);
+
+  array.move(chai::CPU);
+
+  ASSERT_TRUE(checker->getArrayEntries().empty());
+  ASSERT_TRUE(checker->getKernelEntries().empty());
+
+  array.free();
+}
+#endif